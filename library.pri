@@ -25,6 +25,12 @@ unix {
   }
   DEFINES      += INTEL LINUX
   DESTDIR       = ../lib
+
+  # Optional optimized BLAS/LAPACK backend (see local.pri)
+  contains( DEFINES, US_BLAS ) {
+    INCLUDEPATH  += $$BLASINC
+    LIBS         += $$BLASLIBS
+  }
 }
 
 win32 {
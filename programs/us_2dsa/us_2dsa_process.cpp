@@ -435,6 +435,7 @@ DbgLv(1) << "FinalComp: szSoluI" << wtask.isolutes.size();
    }
 
    wtask.thrn = thrx + 1;
+   wtask.sim_vals.nthreads = wkstates.size();  // Other threads are idle
    wthr->define_work( wtask );
 
    connect( wthr, SIGNAL( work_complete( WorkerThread2D* ) ),
@@ -829,6 +830,10 @@ void US_2dsaProcess::submit_job( WorkPacket2D& wtask, int thrx )
    wkdepths[ thrx ]   = wtask.depth;
    wtask.sim_vals.maxrss = maxrss;
 
+   // With no more queued tasks, let this task simulate using idle threads
+   wtask.sim_vals.nthreads = job_queue.isEmpty()
+                           ? ( wkstates.count( READY ) + 1 ) : 1;
+
    wthr->define_work( wtask );
 
    connect( wthr, SIGNAL( work_complete( WorkerThread2D* ) ),
@@ -133,6 +133,10 @@ void WorkerThread2D::calc_residuals()
    sim_vals.noisflag   = noisflag;
    sim_vals.dbg_level  = dbg_level;
    sim_vals.dbg_timing = US_Settings::debug_match( "2dsaTiming" );
+   sim_vals.nnls_mode  = US_Settings::debug_match( "NnlsNormal" ) ? 1 :
+                       ( US_Settings::debug_match( "NnlsCheck"  ) ? 2 : 0 );
+   sim_vals.sim_precision = US_Settings::debug_match( "SimFloat" ) ? 1 :
+                       ( US_Settings::debug_match( "SimFloatCheck" ) ? 2 : 0 );
 
    solvesim->calc_residuals( 0, 1, sim_vals );
 
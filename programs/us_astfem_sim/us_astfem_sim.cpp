@@ -575,6 +575,7 @@ astfem_rsa->setTimeInterpolation( true );
 
       astfvm->set_buffer( buffer );
       astfvm->setMovieFlag( ck_movie->isChecked() );
+      astfvm->setThreads( US_Settings::threads() );
 
       // solve using ASTFVM
       int rc = astfvm->calculate( sim_data );
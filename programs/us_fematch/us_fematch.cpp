@@ -2199,6 +2199,7 @@ DbgLv(1) << " afvm calc: sigma delta coSed compress"
          solution_rec.buffer.compressibility = compress;
          solution_rec.buffer.manual          = manual;
          astfvm->set_buffer( solution_rec.buffer );
+         astfvm->setThreads( US_Settings::threads() );
          astfvm->calculate(     *sdata );
       }
 
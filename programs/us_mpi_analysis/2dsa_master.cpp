@@ -22,6 +22,13 @@ void US_MPI_Analysis::_2dsa_master( void )
    if ( mc_iterations > 1 )
       max_iterations   = max_iters_all > 1 ? max_iters_all : 5;
 
+   if ( ckpt_resume )
+   {  // Resume Monte Carlo iterations from the last checkpoint
+      read_checkpoint( true );
+      max_iterations   = max_iters_all;
+      set_monteCarlo();
+   }
+
    while ( true )
    {
       int worker;
@@ -39,8 +46,13 @@ void US_MPI_Analysis::_2dsa_master( void )
 
          Sa_Job job              = job_queue.takeFirst();
          submit( job, worker );
-         worker_depth [ worker ] = job.mpi_job.depth;
-         worker_status[ worker ] = WORKING;
+      }
+
+      // Give further jobs to busy workers that have asked for them
+      while ( ! job_queue.isEmpty()  &&  ( worker = prefetch_worker() ) > 0 )
+      {
+         Sa_Job job              = job_queue.takeFirst();
+         submit( job, worker );
       }
 
       // All done with the pass if no jobs are ready or running
@@ -148,6 +160,8 @@ DbgLv(1) << " master loop-BOT: GF job_queue empty" << job_queue.isEmpty();
                time_mc_iterations();
 
                set_monteCarlo();
+
+               write_checkpoint();
             }
          }
 
@@ -243,7 +257,7 @@ if ( max_depth > 0 )
       switch( status.MPI_TAG )
       {
          case MPI_Job::READY:   // Ready for work
-            worker_status[ worker ] = READY;
+            worker_ready( worker );
             break;
 
          case MPI_Job::RESULTS: // Return solute data
@@ -355,6 +369,8 @@ DbgLv(0) << "Insol:  nsubgrid sbsize" << nsubgrid << ( ncomps / nsubgrid );
          orig_solutes << solvec;
       }
    }
+
+   split_subgrids();
 }
 
 // Fill the job queue, using the list of initial solutes
@@ -365,11 +381,20 @@ void US_MPI_Analysis::fill_queue( void )
 
    worker_status.fill( INIT );
    worker_depth .fill( 0 );
+   worker_queued  .fill( QList< int >(), gcores_count );
+   worker_prefetch.fill( false,          gcores_count );
    max_depth           = 0;
    worknext            = 1;
    max_experiment_size = min_experiment_size;
 
-   // Put all jobs in the queue
+   if ( worker_jobs.size() != gcores_count )
+   {  // Busy-time accounting covers the whole run
+      worker_jobs .fill( 0, gcores_count );
+      worker_busy .fill( 0, gcores_count );
+      worker_start.fill( 0, gcores_count );
+   }
+
+   // Put all jobs in the queue, costliest first
    job_queue.clear();
 
    for ( int i = 0; i < orig_solutes.size(); i++ )
@@ -378,7 +403,7 @@ void US_MPI_Analysis::fill_queue( void )
                                   orig_solutes[ i ].size() );
       Sa_Job job;
       job.solutes         = orig_solutes[ i ];
-      job_queue << job;
+      add_to_queue( job );
    }
 }
 
@@ -480,7 +505,7 @@ DbgLv(0) << "ScaledData sum" << dsum << "iSum" << isum << "concen" << concentrat
               scaled_data.size(),
               MPI_DOUBLE,
               MPI_Job::MASTER,
-              my_communicator );
+              data_shared ? lead_comm : my_communicator );
 
    // Go to the next dataset
    job_queue.clear();
@@ -532,7 +557,7 @@ void US_MPI_Analysis::set_meniscus( void )
       Sa_Job job;
       job.solutes = orig_solutes[ i ];
 
-      job_queue << job;
+      add_to_queue( job );
    }
 
    worker_depth.fill( 0 );
@@ -548,7 +573,8 @@ DbgLv(1) << "sMC: max_depth" << max_depth << "calcsols size" << calculated_solut
  << "simvsols size" << simulation_values.solutes.size();
 
    // Set up new data modified by a gaussian distribution
-   if ( mc_iteration == 1 )
+   //  (unless restored from a checkpoint)
+   if ( mc_iteration == 1  &&  ! ckpt_resume )
    {
       set_gaussians();
 
@@ -584,6 +610,8 @@ int mcdsiz=mc_data.count();
    double varimin    = 1.0;
    double varimax    = -1.0;
    double datasum    = 0.0;
+   ckpt_resume       = false;
+   mc_reseed( mc_iteration );
 
    // Get a randomized variation of the concentrations
    // Use a gaussian distribution with the residual as the standard deviation
@@ -661,7 +689,7 @@ DbgLv(1) << "sMC: MPI Bcast";
               ds_points, 
               MPI_DOUBLE, 
               MPI_Job::MASTER, 
-              my_communicator );
+              data_shared ? lead_comm : my_communicator );
 
    fill_queue();
 
@@ -785,7 +813,7 @@ void US_MPI_Analysis::iterate( void )
          }
       }
 
-      job_queue << job;
+      add_to_queue( job );
 
       // Bump max solutes per subgrid to new observed max
       max_experiment_size = qMax( max_experiment_size,
@@ -821,34 +849,25 @@ DbgLv(1) << "Mast: submit: len sol offs cnt"
  << job.mpi_job.dataset_offset
  << job.mpi_job.dataset_count;
 
-   // Tell worker that solutes are coming
-   MPI_Send( &job.mpi_job, 
-       sizeof( MPI_Job ), 
-       MPI_BYTE,
-       worker,      // Send to system that needs work
-       MPI_Job::MASTER,
-       my_communicator );
-DbgLv(1) << "Mast: submit: send #1";
-
-   // Send solutes
-   MPI_Send( job.solutes.data(), 
-       job.mpi_job.length * solute_doubles, 
-       MPI_DOUBLE,   // Pass solute vector as hw independent values
-       worker,       // to worker
-       MPI_Job::MASTER,
-       my_communicator );
-DbgLv(1) << "Mast: submit: send #2";
+   // Send the job and its solutes, without waiting on a busy worker
+   send_job( job, worker );
+DbgLv(1) << "Mast: submit: sent";
 }
 
-// Add a job to the queue, maintaining depth order
+// Add a job to the queue, maintaining depth order and,
+//  within a depth, longest-first order of estimated cost
 void US_MPI_Analysis::add_to_queue( Sa_Job& job )
 {
    int jdepth = job.mpi_job.depth;
+   job.cost   = job_cost( job.solutes );
 
    for ( int qq = 0; qq < job_queue.size(); qq++ )
    {
-      if ( jdepth < job_queue[ qq ].mpi_job.depth )
-      { // Insert this job before any with a greater depth
+      int qdepth = job_queue[ qq ].mpi_job.depth;
+
+      if ( jdepth < qdepth  ||
+         ( jdepth == qdepth  &&  job.cost > job_queue[ qq ].cost ) )
+      { // Insert this job before any with a greater depth or lower cost
          job_queue.insert( qq, job ); 
          return;
       }
@@ -859,6 +878,108 @@ void US_MPI_Analysis::add_to_queue( Sa_Job& job )
    return;
 }
 
+// Estimate the relative cost of a job from its solutes.
+//  Each solute costs the ASTFEM time steps its s value needs (as in
+//  US_SolveSim::checkGridSize) times the simulation points, plus the
+//  interpolation and NNLS work over the data points.
+double US_MPI_Analysis::job_cost( const QVector< US_Solute >& solutes )
+{
+   double cost    = 0.0;
+
+   for ( int ee = 0; ee < data_sets.size(); ee++ )
+   {
+      US_SimulationParameters* sparams = &data_sets[ ee ]->simparams;
+      US_DataIO::EditedData*   edata   = &data_sets[ ee ]->run_data;
+      double rsimpts  = (double)qMax( sparams->simpoints - 1, 1 );
+      double npoints  = (double)( edata->scanCount() * edata->pointCount() );
+      double lgbmrat  = ( sparams->meniscus > 0.0 ) ?
+                        log( sparams->bottom / sparams->meniscus ) : 0.0;
+      double om2tsum  = 0.0;
+
+      for ( int ss = 0; ss < sparams->speed_step.size(); ss++ )
+      {  // Sum omega-squared-t over speed steps
+         US_SimulationParameters::SpeedProfile* sp = &sparams->speed_step[ ss ];
+         double duration = sp->duration_hours * 3600.0
+                         + sp->duration_minutes * 60.0;
+         om2tsum        += sq( sp->rotorspeed * M_PI / 30.0 ) * duration;
+      }
+
+      // Time steps per unit sedimentation coefficient
+      double tsfac    = ( lgbmrat > 0.0 ) ? ( om2tsum * rsimpts / lgbmrat )
+                                          : 0.0;
+
+      for ( int jj = 0; jj < solutes.size(); jj++ )
+      {
+         double tsteps   = qMax( tsfac * qAbs( solutes[ jj ].s ), 1.0 );
+         cost           += tsteps * rsimpts + npoints;
+      }
+   }
+
+   return cost;
+}
+
+// Split the costliest initial subgrids, while there are fewer of them
+//  than workers and any one would outlast an even share of the work.
+//  Halves interleave the subgrid's solutes, so each spans its range.
+//  Splitting changes the subgrid partition (and so the solutions), so it
+//  is only done when asked for (job parameter job_split=1).
+void US_MPI_Analysis::split_subgrids( void )
+{
+   const int min_split = 50;    // Minimum solutes in a split subgrid
+
+   if ( ! parameters.contains( "job_split" )  ||
+        parameters[ "job_split" ].toInt() == 0 )
+      return;
+
+   QVector< double > costs;
+   double tcost   = 0.0;
+   int    nsplit  = 0;
+
+   for ( int ii = 0; ii < orig_solutes.size(); ii++ )
+   {
+      costs << job_cost( orig_solutes[ ii ] );
+      tcost         += costs[ ii ];
+   }
+
+   while ( orig_solutes.size() < my_workers )
+   {
+      int jmax       = 0;
+
+      for ( int ii = 1; ii < costs.size(); ii++ )
+         if ( costs[ ii ] > costs[ jmax ] )  jmax = ii;
+
+      if ( costs.size() == 0  ||
+           costs[ jmax ] <= ( tcost / my_workers )  ||
+           orig_solutes[ jmax ].size() < ( min_split * 2 ) )
+         break;
+
+      QVector< US_Solute > solvec = orig_solutes[ jmax ];
+      QVector< US_Solute > solv1;
+      QVector< US_Solute > solv2;
+      qSort( solvec );
+
+      for ( int jj = 0; jj < solvec.size(); jj++ )
+      {
+         if ( ( jj & 1 ) == 0 )
+            solv1 << solvec[ jj ];
+         else
+            solv2 << solvec[ jj ];
+      }
+
+      orig_solutes[ jmax ] = solv1;
+      orig_solutes.insert( jmax + 1, solv2 );
+      costs[ jmax ]        = job_cost( solv1 );
+      costs.insert( jmax + 1, job_cost( solv2 ) );
+      nsplit++;
+   }
+
+   if ( nsplit > 0 )
+   {
+      DbgLv(0) << "Subgrids split" << nsplit << "times:  subgrids"
+               << orig_solutes.size() << " workers" << my_workers;
+   }
+}
+
 // Process the results from a just-completed worker task
 void US_MPI_Analysis::process_results( int        worker, 
                                        const int* size )
@@ -913,8 +1034,7 @@ void US_MPI_Analysis::process_results( int        worker,
              my_communicator,
              &status );
 
-   worker_status[ worker ] = INIT;
-   int depth       = worker_depth[ worker ];   
+   int depth       = job_returned( worker );
 
 if (depth == 0) { DbgLv(1) << "Mast:  process_results: worker" << worker
  << " solsize" << size[0] << "depth" << depth; }
@@ -1095,8 +1215,6 @@ DbgLv(1) << "Mast:   queue LAST ns=" << job.solutes.size() << "  d=" << depth+1
       { // Submit what should be the last job of this iteration
          ljob_solutes            = job.solutes;
          submit( job, worker );
-         worker_depth [ worker ] = job.mpi_job.depth;
-         worker_status[ worker ] = WORKING;
          // Insure calculated solutes is empty for final depth
          if ( calculated_solutes.size() > max_depth )
             calculated_solutes[ max_depth ].clear();
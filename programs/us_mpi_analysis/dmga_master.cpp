@@ -202,6 +202,12 @@ DbgLv(0) << " wmodel as1 K_d k_off" << wmodel.associations[0].k_d
       best_fitness << empty_fitness;
    }
 
+   if ( ckpt_resume )
+   {  // Resume Monte Carlo iterations from the last checkpoint
+      read_checkpoint( true );
+      set_dmga_MonteCarlo();
+   }
+
    QDateTime time = QDateTime::currentDateTime();
 
    // Handle Monte Carlo iterations.  There will always be at least 1.
@@ -296,6 +302,7 @@ DbgLv(1) << "GaMast:  mc_iter iters" << mc_iteration << mc_iterations;
 DbgLv(1) << "GaMast:    set_gaMC call";
             set_dmga_MonteCarlo();
 DbgLv(1) << "GaMast:    set_gaMC  return";
+            write_checkpoint();
          }
          else
             break;
@@ -851,7 +858,7 @@ void US_MPI_Analysis::set_dmga_MonteCarlo( void )
 {
 DbgLv(1) << "sdMC: mciter" << mc_iteration;
    // This is almost the same as ga set_monteCarlo
-   if ( mc_iteration <= mgroup_count )
+   if ( mc_iteration <= mgroup_count  &&  ! ckpt_resume )
    {
       max_depth   = 0;  // Make the datasets compatible
       calculated_solutes.clear();
@@ -861,6 +868,8 @@ DbgLv(1) << "sdMC: mciter" << mc_iteration;
 
    mc_data.resize( total_points );
    int index = 0;
+   ckpt_resume        = false;
+   mc_reseed( mc_iteration );
 
    // Get a randomized variation of the concentrations
    // Use a gaussian distribution with the residual as the standard deviation
@@ -888,6 +897,7 @@ DbgLv(1) << "sdMC: mc_data set index" << index
    MPI_Job job;
    job.command        = MPI_Job::NEWDATA;
    job.length         = total_points;
+   job.solution       = mc_iteration;
    job.dataset_offset = 0;
    job.dataset_count  = data_sets.size();
 
@@ -96,18 +96,27 @@ DbgLv(1) << my_rank << "dmga_worker: nfloatc nfvari do_astfem"
 
    while ( ! finished )
    {
-      dmga_worker_loop();
+      if ( ckpt_resume )
+      {  // Resuming from a checkpoint:  wait for the master's MC data
+         ckpt_resume   = false;
+      }
 
-      msg.size = (int)max_rss();
-      DbgLv(0) << "Deme" << grp_nbr << deme_nbr
-         << ":   Generations finished, second" << ELAPSEDSEC;
+      else
+      {
+         dmga_worker_loop();
+         migrate_finish();
 
-      MPI_Send( &msg,           // This iteration is finished
-                sizeof( msg ),  // to MPI #1
-                MPI_BYTE,
-                MPI_Job::MASTER,
-                FINISHED,
-                my_communicator );
+         msg.size = (int)max_rss();
+         DbgLv(0) << "Deme" << grp_nbr << deme_nbr
+            << ":   Generations finished, second" << ELAPSEDSEC;
+
+         MPI_Send( &msg,           // This iteration is finished
+                   sizeof( msg ),  // to MPI #1
+                   MPI_BYTE,
+                   MPI_Job::MASTER,
+                   FINISHED,
+                   my_communicator );
+      }
 DbgLv(1) << my_rank << "dmgw: FIN sent";
 if(group_rank<2) {
 DbgLv(1) << my_rank << "lfvari  n" << nfvari << lfvari.size();
@@ -136,6 +145,16 @@ DbgLv(1) << my_rank << "dmgw: job offs count len" << dataset << count << length
             DbgLv(0) << "    Deme" << grp_nbr << deme_nbr << ":"
                << fitness_hits << "fitness hits of" << fitness_count
                << "fitness checks   maxrss" << maxrss;
+            {
+               int nfhits;
+               int nfmiss;
+               int nfevic;
+               int nfent       = fitness_cache.statistics( nfhits, nfmiss,
+                                                           nfevic );
+               DbgLv(0) << "    Deme" << grp_nbr << deme_nbr << ":"
+                  << "fitness cache hits,misses" << nfhits << nfmiss
+                  << "evictions" << nfevic << "entries" << nfent;
+            }
             break;
 
          case UPDATE:   
@@ -143,6 +162,7 @@ DbgLv(1) << my_rank << "dmgw: job offs count len" << dataset << count << length
             // Global fit comes before MC (if necessary), one dataset at a time
             // Monte Carlo always comes as a sequence of all datasets
 
+            mc_reseed( job.solution );
             mc_data.resize( length );
 
             MPI_Barrier( my_communicator );
@@ -231,7 +251,7 @@ void US_MPI_Analysis::dmga_worker_loop( void )
    int grp_nbr     = my_rank / gcores_count;
    int deme_nbr    = my_rank - grp_nbr * gcores_count;
 
-   fitness_map.clear();
+   fitness_cache.clear();
    fitness_count   = 0;
    fitness_hits    = 0;
 
@@ -645,39 +665,50 @@ DbgLv(1) << my_rank << "dg:migrdg: migrate_count doubles_count" << migrate_count
    dgenes_to_marker( emmigrants, emmigres, 0, migrate_count );
 DbgLv(1) << my_rank << "dg:migrdg: emmigres size" << emmigres.size() << "emmigrants size" << emmigrants.size();
 
-   // MPI send msg type
-   MPI_GA_MSG msg;
-   msg.size            = migrate_count;
-
-   MPI_Send( &msg,                 // to MPI #1
-             sizeof( msg ),
-             MPI_BYTE,
-             MPI_Job::MASTER,
-             EMMIGRATE,
-             my_communicator );
-
-   // MPI send emmigrants
-   MPI_Send( emmigrants.data(),    // to MPI #1
-             doubles_count,
-             MPI_DOUBLE,
-             MPI_Job::MASTER,
-             EMMIGRATE,
-             my_communicator );
-
-   // Get genes from master as marker vector
    QVector< double > immigres( doubles_count );
-   MPI_Status        status;
+   int doubles_sent;
 
-   MPI_Recv( immigres.data(),      // to MPI #1
-             doubles_count,
-             MPI_DOUBLE,
-             MPI_Job::MASTER,
-             IMMIGRATE,
-             my_communicator,
-             &status );
+   if ( migrate_comm != MPI_COMM_NULL )
+   {  // Exchange genes directly with neighbor demes
+      doubles_sent        = migrate_peers( emmigrants.data(),
+                                           immigres.data(), doubles_count );
+   }
+
+   else
+   {
+      // MPI send msg type
+      MPI_GA_MSG msg;
+      msg.size            = migrate_count;
+
+      MPI_Send( &msg,                 // to MPI #1
+                sizeof( msg ),
+                MPI_BYTE,
+                MPI_Job::MASTER,
+                EMMIGRATE,
+                my_communicator );
+
+      // MPI send emmigrants
+      MPI_Send( emmigrants.data(),    // to MPI #1
+                doubles_count,
+                MPI_DOUBLE,
+                MPI_Job::MASTER,
+                EMMIGRATE,
+                my_communicator );
+
+      // Get genes from master as marker vector
+      MPI_Status        status;
+
+      MPI_Recv( immigres.data(),      // to MPI #1
+                doubles_count,
+                MPI_DOUBLE,
+                MPI_Job::MASTER,
+                IMMIGRATE,
+                my_communicator,
+                &status );
+
+      MPI_Get_count( &status, MPI_DOUBLE, &doubles_sent );
+   }
 
-   int doubles_sent;
-   MPI_Get_count( &status, MPI_DOUBLE, &doubles_sent );
    int mgenes_count    = doubles_sent / nfloatc;
 DbgLv(1) << my_rank << "dg:migrdg: immigres size" << immigres.size() << "doubles_sent" << doubles_sent;
 
@@ -1092,13 +1123,15 @@ DbgLv(1) << my_rank << "dg:IHM: FITNESS" << fitness;
 // Get the fitness value for a discrete GA Gene
 double US_MPI_Analysis::get_fitness_dmga( DGene& dgene )
 {
-   QString fkey    = dgene_key( dgene );   // Get an identifying key string
+   QVector< qint64 > fkey;
+   double fitness;
+   dgene_qkey( dgene, fkey );              // Get an identifying key
    fitness_count++;
 
-   if ( fitness_map.contains( fkey ) )
+   if ( fitness_cache.fetch( fkey, fitness ) )
    {  // We already have a match to this key, so use its fitness value
       fitness_hits++;
-      return fitness_map.value( fkey );
+      return fitness;
    }
 
    US_SolveSim::Simulation sim = simulation_values;
@@ -1106,8 +1139,8 @@ double US_MPI_Analysis::get_fitness_dmga( DGene& dgene )
    // Compute the simulation and residuals for this model
    calc_residuals_dmga( current_dataset, datasets_to_process, sim, dgene );
 
-   double fitness  = sim.variance;         // Get the computed fitness
-   fitness_map.insert( fkey, fitness );    // Add it the fitness map
+   fitness         = sim.variance;         // Get the computed fitness
+   fitness_cache.store( fkey, fitness );   // Add it to the fitness cache
 
 //DbgLv(1) << "dg:get_fit fitness" << fitness << "count hits"
 // << fitness_count << fitness_hits;
@@ -1131,6 +1164,19 @@ DbgLv(1) << my_rank << "dg:dgkey" << fkey << "mv0 mvn" << dgmarker[0] << dgmarke
    return fkey;
 }
 
+// Compose an identifying key of quantized marker values for a discrete GA
+//  Gene (same precision as the dgene_key string)
+void US_MPI_Analysis::dgene_qkey( DGene& dgene, QVector< qint64 >& fkey )
+{
+   // Get the marker for this gene
+   marker_from_dgene( dgmarker, dgene );
+
+   fkey.resize( nfloatc );
+
+   for ( int ii = 0; ii < nfloatc; ii++ )
+      fkey[ ii ]   = US_FitnessCache::quantize_sig( dgmarker[ ii ], 6 );
+}
+
 // Calculate residuals for a given discrete GA gene
 void US_MPI_Analysis::calc_residuals_dmga( int offset, int dset_count,
                                            SIMULATION& sim_vals, DGene& dgene )
@@ -37,6 +37,12 @@ DbgLv(0) << "DEBUG_LEVEL" << simulation_values.dbg_level;
       best_fitness << empty_fitness;
    }
 
+   if ( ckpt_resume )
+   {  // Resume Monte Carlo iterations from the last checkpoint
+      read_checkpoint( true );
+      set_gaMonteCarlo();
+   }
+
    QDateTime time = QDateTime::currentDateTime();
 
    // Handle Monte Carlo iterations.  There will always be at least 1.
@@ -129,6 +135,7 @@ DbgLv(1) << "GaMast:  mc_iter iters" << mc_iteration << mc_iterations;
 DbgLv(1) << "GaMast:    set_gaMC call";
             set_gaMonteCarlo();
 DbgLv(1) << "GaMast:    set_gaMC  return";
+            write_checkpoint();
          }
          else
             break;
@@ -491,7 +498,7 @@ void US_MPI_Analysis::ga_global_fit( void )
               scaled_data.size(), 
               MPI_DOUBLE, 
               MPI_Job::MASTER, 
-              my_communicator );
+              data_shared ? lead_comm : my_communicator );
 
    // Go to the next dataset
    current_dataset++;
@@ -508,7 +515,7 @@ void US_MPI_Analysis::set_gaMonteCarlo( void )
 {
 DbgLv(1) << "sgMC: mciter" << mc_iteration;
    // This is almost the same as 2dsa set_monteCarlo
-   if ( mc_iteration <= mgroup_count )
+   if ( mc_iteration <= mgroup_count  &&  ! ckpt_resume )
    {
       //meniscus_values << -1.0;
       max_depth   = 0;  // Make the datasets compatible
@@ -527,6 +534,8 @@ DbgLv(1) << "sgMC: gaussians set";
    mc_data.resize( total_points );
    int index = 0;
    int ks    = 0;
+   ckpt_resume        = false;
+   mc_reseed( mc_iteration );
 DbgLv(1) << "sgMC: totpts" << total_points << "sizes mc_data,sigmas"
  << mc_data.count() << sigmas.count() << "scaled_data ns,nr"
  << scaled_data.scanCount() << scaled_data.pointCount();
@@ -556,6 +565,7 @@ DbgLv(1) << "sgMC: mc_data set index" << index << "ks" << ks;
    MPI_Job job;
    job.command        = MPI_Job::NEWDATA;
    job.length         = total_points;
+   job.solution       = mc_iteration;
    job.dataset_offset = 0;
    job.dataset_count  = count_datasets;
 DbgLv(1) << "sgMC: MPI send my_workers" << my_workers;
@@ -581,6 +591,6 @@ DbgLv(1) << "sgMC: MPI Bcast";
               total_points, 
               MPI_DOUBLE, 
               MPI_Job::MASTER, 
-              my_communicator );
+              data_shared ? lead_comm : my_communicator );
 }
 
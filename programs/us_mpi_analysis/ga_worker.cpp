@@ -52,18 +52,27 @@ void US_MPI_Analysis::ga_worker( void )
 
    while ( ! finished )
    {
-      ga_worker_loop();
+      if ( ckpt_resume )
+      {  // Resuming from a checkpoint:  wait for the master's MC data
+         ckpt_resume   = false;
+      }
 
-      msg.size = max_rss();
-      DbgLv(0) << "Deme" << grp_nbr << deme_nbr
-         << ":   Generations finished, second" << ELAPSEDSEC;
+      else
+      {
+         ga_worker_loop();
+         migrate_finish();
 
-      MPI_Send( &msg,           // This iteration is finished
-                sizeof( msg ),  // to MPI #1
-                MPI_BYTE,
-                MPI_Job::MASTER,
-                FINISHED,
-                my_communicator );
+         msg.size = max_rss();
+         DbgLv(0) << "Deme" << grp_nbr << deme_nbr
+            << ":   Generations finished, second" << ELAPSEDSEC;
+
+         MPI_Send( &msg,           // This iteration is finished
+                   sizeof( msg ),  // to MPI #1
+                   MPI_BYTE,
+                   MPI_Job::MASTER,
+                   FINISHED,
+                   my_communicator );
+      }
 
       MPI_Recv( &job,          // Find out what to do next
                 sizeof( job ), // from MPI #0, MPI #7, MPI #9
@@ -85,6 +94,16 @@ void US_MPI_Analysis::ga_worker( void )
             DbgLv(0) << "    Deme" << grp_nbr << deme_nbr << ":"
                << fitness_hits << "fitness hits of" << fitness_count
                << " fitness checks   maxrss" << maxrss;
+            {
+               int nfhits;
+               int nfmiss;
+               int nfevic;
+               int nfent       = fitness_cache.statistics( nfhits, nfmiss,
+                                                           nfevic );
+               DbgLv(0) << "    Deme" << grp_nbr << deme_nbr << ":"
+                  << "fitness cache hits,misses" << nfhits << nfmiss
+                  << "evictions" << nfevic << "entries" << nfent;
+            }
             break;
 
          case UPDATE:   
@@ -92,44 +111,54 @@ void US_MPI_Analysis::ga_worker( void )
             // Global fit comes before MC (if necessary), one dataset at a time
             // Monte Carlo always comes as a sequence of all datasets
 
-            mc_data.resize( length );
+            mc_reseed( job.solution );
 DbgLv(1) << "Deme" << deme_nbr << "UPD ds cnt len" << dataset << count << length;
 
             MPI_Barrier( my_communicator );
 
-            // This is a receive
-            MPI_Bcast( mc_data.data(),  // from MPI #8, #10
-                       length,
-                       MPI_DOUBLE,
-                       MPI_Job::MASTER,
-                       my_communicator );
-
-            if ( is_global_fit  &&  count == 1 )
-            {  // For global update to scaled data, extra is new ODLimit
-               length--;
-               data_sets[ dataset ]->run_data.ODlimit = mc_data[ length ];
+            if ( data_shared )
+            {  // Data shared in the node:  one worker receives it
+               update_shared( dataset, count, length );
             }
 
-            for ( int ee = dataset; ee < dataset + count; ee++ )
+            else
             {
-               US_DataIO::EditedData* edata = &data_sets[ ee ]->run_data;
+               mc_data.resize( length );
+
+               // This is a receive
+               MPI_Bcast( mc_data.data(),  // from MPI #8, #10
+                          length,
+                          MPI_DOUBLE,
+                          MPI_Job::MASTER,
+                          my_communicator );
+
+               if ( is_global_fit  &&  count == 1 )
+               {  // For global update to scaled data, extra is new ODLimit
+                  length--;
+                  data_sets[ dataset ]->run_data.ODlimit = mc_data[ length ];
+               }
 
-               int scan_count    = edata->scanCount();
-               int radius_points = edata->pointCount();
+               for ( int ee = dataset; ee < dataset + count; ee++ )
+               {
+                  US_DataIO::EditedData* edata = &data_sets[ ee ]->run_data;
+
+                  int scan_count    = edata->scanCount();
+                  int radius_points = edata->pointCount();
 DbgLv(1) << "Deme" << deme_nbr << "  ee" << ee << "scnt rcnt" << scan_count << radius_points;
 double dsumi=0.0;
 double dsumo=0.0;
 
-               for ( int ss = 0; ss < scan_count; ss++ )
-               {
-                  for ( int rr = 0; rr < radius_points; rr++, index++ )
+                  for ( int ss = 0; ss < scan_count; ss++ )
                   {
+                     for ( int rr = 0; rr < radius_points; rr++, index++ )
+                     {
 dsumi+=edata->value(ss,rr);
-                     edata->setValue( ss, rr, mc_data[ index ] );
+                        edata->setValue( ss, rr, mc_data[ index ] );
 dsumo+=mc_data[index];
+                     }
                   }
-               }
 DbgLv(1) << "Deme" << deme_nbr << "  dsumi" << dsumi << "dsumo" << dsumo;
+               }
             }
 
             if ( count == data_sets.size() ) // Next iteration will be global
@@ -191,7 +220,7 @@ void US_MPI_Analysis::ga_worker_loop( void )
    int grp_nbr     = ( my_rank / gcores_count );
    int deme_nbr    = my_rank - grp_nbr * gcores_count;
 
-   fitness_map.clear();
+   fitness_cache.clear();
    fitness_hits    = 0;
    fitness_count   = 0;
 
@@ -206,10 +235,16 @@ void US_MPI_Analysis::ga_worker_loop( void )
 
 DbTimMsg("Worker start rank/generation/elapsed-secs");
       // Calculate fitness
-      for ( int i = 0; i < population; i++ )
+      if ( compute_threads > 1 )
+         population_fitness();
+
+      else
       {
-         fitness[ i ].index   = i;
-         fitness[ i ].fitness = get_fitness( genes[ i ] );
+         for ( int i = 0; i < population; i++ )
+         {
+            fitness[ i ].index   = i;
+            fitness[ i ].fitness = get_fitness( genes[ i ] );
+         }
       }
 
       // Sort fitness
@@ -421,38 +456,90 @@ void US_MPI_Analysis::align_gene( Gene& gene )
 
 double US_MPI_Analysis::get_fitness( const Gene& gene )
 {
-   US_SolveSim::Simulation sim = simulation_values;
+   US_SolveSim::Simulation sim;
+   QVector< qint64 > key;
+   double  fitness;
+
+   if ( fitness_setup( gene, sim, key, fitness ) )
+      return fitness;
+
+//DbTimMsg("  ++ call gf calc_residuals");
+   calc_residuals( current_dataset, datasets_to_process, sim );
+//DbTimMsg("  ++  return calc_residuals");
+
+   return fitness_store( sim, key );
+}
+
+// Calculate the fitness of all genes of the population, simulating those
+//  not already cached in the compute threads
+void US_MPI_Analysis::population_fitness( void )
+{
+   QVector< SIMULATION >          sims;
+   QVector< QVector< qint64 > >   keys;
+   QList< int >                   simxs;
+
+   for ( int i = 0; i < population; i++ )
+   {
+      SIMULATION        sim;
+      QVector< qint64 > key;
+      fitness[ i ].index   = i;
+
+      if ( fitness_setup( genes[ i ], sim, key, fitness[ i ].fitness ) )
+         continue;
+
+      sims  << sim;
+      keys  << key;
+      simxs << i;
+   }
+
+   run_threads( current_dataset, datasets_to_process, sims );
+
+   for ( int jj = 0; jj < simxs.size(); jj++ )
+      fitness[ simxs[ jj ] ].fitness = fitness_store( sims[ jj ], keys[ jj ] );
+}
+
+// Set up the simulation of a gene and its fitness key. Returns true,
+//  along with the fitness, if the fitness is already cached.
+bool US_MPI_Analysis::fitness_setup( const Gene& gene, SIMULATION& sim,
+                                     QVector< qint64 >& key, double& fitness )
+{
+   sim = simulation_values;
 sim.dbg_level = qMax(0,dbg_level-1);
    sim.solutes = gene;
+   sim.sim_precision = sim_precision;
    qSort( sim.solutes );
 
    fitness_count++;
    int     nisols = gene.size();
-   QString key    = "";
-   QString str;
+   key.resize( nisols * 2 );
 
    for ( int cc = 0; cc < nisols; cc++ )
-   {  // Concatenate all solute s,k values to form fitness key
-      key += str.sprintf( "%.5f%.5f", sim.solutes[ cc ].s,
-                                      sim.solutes[ cc ].k );
+   {  // Quantize all solute s,k values to form fitness key
+      key[ cc * 2     ] = US_FitnessCache::quantize_fixed(
+                             sim.solutes[ cc ].s, 5 );
+      key[ cc * 2 + 1 ] = US_FitnessCache::quantize_fixed(
+                             sim.solutes[ cc ].k, 5 );
    }
 
-DbgLv(2) << "get_fitness: nisols" << nisols << "key" << key;
-   if ( fitness_map.contains( key ) )
+DbgLv(2) << "get_fitness: nisols" << nisols;
+   if ( fitness_cache.fetch( key, fitness ) )
    {  // We already have a match to this key, so use its fitness value
       fitness_hits++;
 DbgLv(2) << "get_fitness: HIT!  new hits" << fitness_hits;
-      return fitness_map.value( key );
+      return true;
    }
 
    solutes_from_gene( sim.solutes, nisols );
+   return false;
+}
 
-//DbTimMsg("  ++ call gf calc_residuals");
-   calc_residuals( current_dataset, datasets_to_process, sim );
-//DbTimMsg("  ++  return calc_residuals");
-
+// Compute the fitness of a simulated gene and cache it
+double US_MPI_Analysis::fitness_store( SIMULATION& sim,
+                                       const QVector< qint64 >& key )
+{
    double fitness      = sim.variance;
    int    solute_count = 0;
+   int    nisols       = key.size() / 2;
    int    nosols       = sim.solutes.size();
 
    if ( data_sets.size() == 1 )
@@ -488,14 +575,14 @@ DbgLv(2) << "get_fitness: sol_count conc_thresh" << solute_count << concentratio
    }
 
    fitness *= ( 1.0 + sq( regularization * solute_count ) );
-   fitness_map.insert( key, fitness ); 
+   fitness_cache.store( key, fitness );
 DbgLv(2) << "get_fitness:  out fitness" << fitness;
 //*DEBUG*
-if(dbg_level>0 && fitness_map.size()==20 )
+if(dbg_level>0 && fitness_cache.count()==20 )
 {
  int n=nosols-1;
  DbgLv(1) << "w:" << my_rank << generation << ": fmapsize fitness nsols"
-  << fitness_map.size() << fitness << nisols << nosols
+  << fitness_cache.count() << fitness << nisols << nosols
   << "s0 s,k,v" << sim.solutes[0].s << sim.solutes[0].k << sim.solutes[0].v
   << "sn s,k,v" << sim.solutes[n].s << sim.solutes[n].k << sim.solutes[n].v;
 }
@@ -685,41 +772,53 @@ int US_MPI_Analysis::migrate_genes( void )
 //}
 //*DEBUG*
 
-   // MPI send msg type
-   MPI_GA_MSG msg;
-   msg.size = migrate_count;
    int bucket_sols  = buckets.size();
    int migrate_sols = migrate_count * bucket_sols;
-
-   MPI_Send( &msg,               // to MPI #1
-             sizeof( msg ),
-             MPI_BYTE,
-             MPI_Job::MASTER,
-             EMMIGRATE,
-             my_communicator );
-
-   // MPI send emmigrants
-   MPI_Send( emmigres.data(),  // to MPI #4
-             migrate_sols * solute_doubles,
-             MPI_DOUBLE,
-             MPI_Job::MASTER,
-             EMMIGRATE,
-             my_communicator );
-
-   // Get genes from master as concatenated genes
    QVector< US_Solute > immigres( migrate_sols );
-   MPI_Status        status;
+   int solutes_sent;
 
-   MPI_Recv( immigres.data(),  // from MPI #5
-             migrate_sols * solute_doubles,
-             MPI_DOUBLE,
-             MPI_Job::MASTER,
-             IMMIGRATE,
-             my_communicator,
-             &status );
+   if ( migrate_comm != MPI_COMM_NULL )
+   {  // Exchange genes directly with neighbor demes
+      solutes_sent = migrate_peers( (const double*)emmigres.data(),
+                                    (double*)immigres.data(),
+                                    migrate_sols * solute_doubles );
+   }
+
+   else
+   {
+      // MPI send msg type
+      MPI_GA_MSG msg;
+      msg.size = migrate_count;
+
+      MPI_Send( &msg,               // to MPI #1
+                sizeof( msg ),
+                MPI_BYTE,
+                MPI_Job::MASTER,
+                EMMIGRATE,
+                my_communicator );
+
+      // MPI send emmigrants
+      MPI_Send( emmigres.data(),  // to MPI #4
+                migrate_sols * solute_doubles,
+                MPI_DOUBLE,
+                MPI_Job::MASTER,
+                EMMIGRATE,
+                my_communicator );
+
+      // Get genes from master as concatenated genes
+      MPI_Status        status;
+
+      MPI_Recv( immigres.data(),  // from MPI #5
+                migrate_sols * solute_doubles,
+                MPI_DOUBLE,
+                MPI_Job::MASTER,
+                IMMIGRATE,
+                my_communicator,
+                &status );
+
+      MPI_Get_count( &status, MPI_DOUBLE, &solutes_sent );
+   }
 
-   int solutes_sent;
-   MPI_Get_count( &status, MPI_DOUBLE, &solutes_sent );
    solutes_sent    /= solute_doubles;
    int mgenes_count = solutes_sent / bucket_sols;
 
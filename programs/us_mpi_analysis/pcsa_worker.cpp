@@ -12,29 +12,12 @@ void US_MPI_Analysis::pcsa_worker( void )
    MPI_Status  status;
 DbgLv(1) << "w:" << my_rank << ": pcsa_worker IN";
 
-   // Use 4 here because the master will be reading 4 with the
-   // same instruction when reading ::READY or ::RESULTS.
-   int x[ 4 ] = { 0, 0, 0, 0 };
-
    while ( repeat_loop )
    {
-      MPI_Send( x, // Basically don't care
-                4,
-                MPI_INT,
-                MPI_Job::MASTER,
-                MPI_Job::READY,
-                my_communicator ); // let master know we are ready
-
-      // Blocking -- Wait for instructions
+      // Let master know we are ready and wait for instructions
 //if(my_rank==1)
 DbgLv(1) << "w:" << my_rank << ":PM:Recv: 1:job" << sizeof(job);
-      MPI_Recv( &job, // get masters' response
-                sizeof( job ),
-                MPI_BYTE,
-                MPI_Job::MASTER,
-                MPI_Job::TAG0,
-                my_communicator,
-                &status );        // status not used
+      wait_job( job );
 //if(my_rank==1)
 DbgLv(1) << "w:" << my_rank << ": job_recvd  length" << job.length
  << "command" << job.command;
@@ -64,6 +47,7 @@ DbgLv(1) << "w:" << my_rank << ":Recv:PROCESS";
                   + ( parameters[ "rinoise_option" ].toInt() > 0 ? 2 : 0 );
 //               simulation_values.dbg_level   = dbg_level;
                simulation_values.dbg_timing  = dbg_timing;
+               simulation_values.nthreads    = compute_threads;
 
 //if(my_rank==1)
 DbgLv(1) << "w:" << my_rank << ": sols size" << job.length;
@@ -179,6 +163,7 @@ DbgLv(1) << "w:" << my_rank << ":Recv:PROCESS_MC" << "mc_iter" << mc_iter
                simulation_values.noisflag    = 0;
 //               simulation_values.dbg_level   = dbg_level;
                simulation_values.dbg_timing  = dbg_timing;
+               simulation_values.nthreads    = compute_threads;
 
 //if(my_rank==1)
 DbgLv(1) << "w:" << my_rank << ": sols size" << job.length;
@@ -486,9 +486,6 @@ DbgLv(1) << "master start 2DSA" << startTime;
          Sa_Job job              = job_queue.takeFirst();
 
          submit( job, worker );
-
-         worker_depth [ worker ] = job.mpi_job.depth;
-         worker_status[ worker ] = WORKING;
       }
 
       // All done with the pass if no jobs are ready or running
@@ -0,0 +1,154 @@
+//! \file us_checkpoint.cpp
+#include "us_checkpoint.h"
+
+#define CKPT_MAGIC   0x55533343                   // "US3C"
+#define CKPT_VERSION 2
+
+// Write the parts of raw data that Monte Carlo iterations use
+static void write_rawdata( QDataStream& ds, US_DataIO::RawData& rdata )
+{
+   int nscans     = rdata.scanCount();
+   ds << rdata.xvalues << nscans;
+
+   for ( int ss = 0; ss < nscans; ss++ )
+   {
+      US_DataIO::Scan* scan = &rdata.scanData[ ss ];
+      ds << scan->temperature << scan->rpm << scan->seconds
+         << scan->omega2t << scan->rvalues;
+   }
+}
+
+// Read raw data as written by write_rawdata()
+static void read_rawdata( QDataStream& ds, US_DataIO::RawData& rdata )
+{
+   int nscans;
+   ds >> rdata.xvalues >> nscans;
+
+   rdata.scanData.resize( qMax( 0, nscans ) );
+
+   for ( int ss = 0; ss < nscans; ss++ )
+   {
+      US_DataIO::Scan* scan = &rdata.scanData[ ss ];
+      ds >> scan->temperature >> scan->rpm >> scan->seconds
+         >> scan->omega2t >> scan->rvalues;
+   }
+}
+
+// Create an empty checkpoint
+US_Checkpoint::US_Checkpoint()
+{
+   count_datasets      = 0;
+   total_points        = 0;
+   mc_iterations       = 0;
+   mc_iteration        = 0;
+   current_dataset     = 0;
+   datasets_to_process = 0;
+   meniscus_run        = 0;
+   mc_seed             = 0;
+   afsize              = 0;
+}
+
+// Write the checkpoint, replacing any earlier file only once complete
+bool US_Checkpoint::write( const QString& fname )
+{
+   QString tmfile = fname + ".tmp";
+   QFile   fileo( tmfile );
+
+   if ( ! fileo.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+      return false;
+
+   QDataStream ds( &fileo );
+   ds.setVersion( QDataStream::Qt_4_8 );
+
+   ds << (qint32)CKPT_MAGIC << (qint32)CKPT_VERSION
+      << analysis_type << requestID << count_datasets << total_points
+      << mc_iterations << identity;
+
+   ds << mc_iteration << current_dataset << datasets_to_process
+      << meniscus_run << mc_seed << analysisDate << modelGUID << afsize;
+   ds << sigmas;
+   write_rawdata( ds, sim_data1 );
+   write_rawdata( ds, scaled_data );
+
+   bool ok        = ( ds.status() == QDataStream::Ok );
+   fileo.close();
+
+   if ( ok )
+   {
+      QFile::remove( fname );
+      ok             = QFile::rename( tmfile, fname );
+   }
+
+   return ok;
+}
+
+// Read the header and scalar state of a checkpoint, and its data if full
+bool US_Checkpoint::read( const QString& fname, bool full )
+{
+   QFile filei( fname );
+
+   if ( ! filei.open( QIODevice::ReadOnly ) )
+      return false;
+
+   QDataStream ds( &filei );
+   ds.setVersion( QDataStream::Qt_4_8 );
+
+   qint32  magic;
+   qint32  version;
+
+   ds >> magic >> version;
+
+   if ( ds.status() != QDataStream::Ok  ||
+        magic != CKPT_MAGIC  ||  version != CKPT_VERSION )
+      return false;
+
+   ds >> analysis_type >> requestID >> count_datasets >> total_points
+      >> mc_iterations >> identity;
+
+   ds >> mc_iteration >> current_dataset >> datasets_to_process
+      >> meniscus_run >> mc_seed >> analysisDate >> modelGUID >> afsize;
+
+   if ( full )
+   {
+      ds >> sigmas;
+      read_rawdata( ds, sim_data1 );
+      read_rawdata( ds, scaled_data );
+   }
+
+   return ( ds.status() == QDataStream::Ok );
+}
+
+// Test if the job and run identities of two checkpoints match
+bool US_Checkpoint::same_run( const US_Checkpoint& other ) const
+{
+   return ( analysis_type  == other.analysis_type   &&
+            requestID      == other.requestID       &&
+            count_datasets == other.count_datasets  &&
+            total_points   == other.total_points    &&
+            mc_iterations  == other.mc_iterations   &&
+            identity       == other.identity );
+}
+
+// Compose the identity of a run:  its submit time (input tar file time)
+//  and its analysis parameters. A checkpoint is only resumed by the run
+//  that wrote it. Empty values are skipped, since looking up a parameter
+//  not given adds it with an empty value.
+QByteArray US_Checkpoint::run_identity( const QDateTime& stime,
+                                        const QMap< QString, QString >& params )
+{
+   QByteArray  ident;
+   QDataStream ds( &ident, QIODevice::WriteOnly );
+   QStringList keys = params.keys();
+
+   ds << stime.toString( Qt::ISODate );
+
+   for ( int ii = 0; ii < keys.size(); ii++ )
+   {
+      QString value  = params.value( keys[ ii ] );
+
+      if ( ! value.isEmpty() )
+         ds << keys[ ii ] << value;
+   }
+
+   return QCryptographicHash::hash( ident, QCryptographicHash::Md5 );
+}
@@ -0,0 +1,73 @@
+//! \file us_checkpoint.h
+#ifndef US_CHECKPOINT_H
+#define US_CHECKPOINT_H
+
+#include <QtCore>
+
+#include "us_dataIO.h"
+
+//! \brief Master state of an analysis run saved between Monte Carlo
+//!        iterations
+//!
+//! A checkpoint file holds a header identifying the job and run that
+//! wrote it, then the master state at the start of a Monte Carlo
+//! iteration. The file is written to a temporary name and renamed, so an
+//! interrupted write never replaces a complete checkpoint.
+//!
+class US_Checkpoint
+{
+   public:
+      // Header:  the job and run identity
+      QString             analysis_type;   //!< Analysis type (2DSA, GA, ...)
+      QString             requestID;       //!< Request identifier
+      int                 count_datasets;  //!< Count of data sets
+      int                 total_points;    //!< Total data points
+      int                 mc_iterations;   //!< MC iterations requested
+      QByteArray          identity;        //!< Run identity (run_identity())
+
+      // Master state at the start of an MC iteration
+      int                 mc_iteration;    //!< MC iteration to resume at
+      int                 current_dataset; //!< First data set of the run
+      int                 datasets_to_process; //!< Data sets processed
+      int                 meniscus_run;    //!< Meniscus fit run index
+      quint32             mc_seed;         //!< Base random seed
+      QString             analysisDate;    //!< Analysis date string
+      QString             modelGUID;       //!< Model GUID
+      qint64              afsize;          //!< Size of analysis_files.txt
+      QVector< double >   sigmas;          //!< MC noise sigmas
+      US_DataIO::RawData  sim_data1;       //!< Simulation of iteration 1
+      US_DataIO::RawData  scaled_data;     //!< Scaled global fit data
+
+      //! \brief Create an empty checkpoint
+      US_Checkpoint();
+
+      //! \brief Write the checkpoint to a file
+      //!
+      //! \param fname     Checkpoint file name
+      //! \returns         Flag if the file was completely written
+      bool write( const QString& );
+
+      //! \brief Read a checkpoint file
+      //!
+      //! \param fname     Checkpoint file name
+      //! \param full      Flag to read the data as well as the header and
+      //!                  the scalar state
+      //! \returns         Flag if the file was read without error
+      bool read( const QString&, bool );
+
+      //! \brief Test if a checkpoint was written by the same run
+      //!
+      //! \param other     Checkpoint with the header of the current run
+      //! \returns         Flag if the job and run identities match
+      bool same_run( const US_Checkpoint& ) const;
+
+      //! \brief Compose the identity of a run
+      //!
+      //! \param stime     Submit time of the run
+      //! \param params    Analysis parameters of the run
+      //! \returns         Digest of the submit time and the non-empty
+      //!                  parameters
+      static QByteArray run_identity( const QDateTime&,
+                                      const QMap< QString, QString >& );
+};
+#endif
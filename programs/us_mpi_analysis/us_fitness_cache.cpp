@@ -0,0 +1,209 @@
+//! \file us_fitness_cache.cpp
+#include "us_fitness_cache.h"
+
+#define PROBE_SLOTS 8          // Slots examined for each key
+#define MAX_SLOTS   (1<<24)    // Upper limit on the slot count
+
+// Create an empty cache with a given memory budget
+US_FitnessCache::US_FitnessCache( int megabytes )
+{
+   budget_mb      = qMax( 0, megabytes );
+   clear();
+}
+
+// Set the memory budget in megabytes (0 disables the cache)
+void US_FitnessCache::set_budget( int megabytes )
+{
+   budget_mb      = qMax( 0, megabytes );
+   clear();
+}
+
+// Remove all entries and reset statistics
+void US_FitnessCache::clear( void )
+{
+   keys.clear();
+   fits.clear();
+   used.clear();
+   klength        = 0;
+   kmask          = 0;
+   nentries       = 0;
+   nhits          = 0;
+   nmisses        = 0;
+   nevicts        = 0;
+   stamp          = 0;
+}
+
+// Fetch the fitness value for a key, if present
+bool US_FitnessCache::fetch( const QVector< qint64 >& key, double& fitness )
+{
+   bool found     = false;
+
+   if ( klength > 0  &&  key.size() == klength )
+   {
+      int slot       = find_slot( key, found );
+
+      if ( found )
+      {
+         used[ slot ]   = ++stamp;
+         fitness        = fits[ slot ];
+      }
+   }
+
+   if ( found )
+      nhits++;
+   else
+      nmisses++;
+
+   return found;
+}
+
+// Store the fitness value for a key
+void US_FitnessCache::store( const QVector< qint64 >& key, double fitness )
+{
+   if ( budget_mb == 0  ||  key.size() == 0 )
+      return;
+
+   if ( klength == 0 )
+   {  // Size the table now that the key length is known
+      klength        = key.size();
+      kmask          = allocate( klength ) - 1;
+   }
+
+   if ( key.size() != klength )
+      return;
+
+   bool found     = false;
+   int  slot      = find_slot( key, found );
+
+   if ( ! found )
+   {  // New entry:  fill an empty slot or replace the least recently used
+      if ( used[ slot ] != 0 )
+         nevicts++;
+      else
+         nentries++;
+
+      qint64* skey   = keys.data() + slot * klength;
+
+      for ( int jj = 0; jj < klength; jj++ )
+         skey[ jj ]     = key[ jj ];
+   }
+
+   if ( stamp == 0xffffffffU )
+   {  // Restart use stamps before they wrap, keeping only their existence
+      for ( int jj = 0; jj < used.size(); jj++ )
+         used[ jj ]     = ( used[ jj ] != 0 ) ? 1 : 0;
+
+      stamp          = 1;
+   }
+
+   used[ slot ]   = ++stamp;
+   fits[ slot ]   = fitness;
+}
+
+// Return hit/miss/eviction counts and the count of entries held
+int US_FitnessCache::statistics( int& hits, int& misses, int& evictions ) const
+{
+   hits           = nhits;
+   misses         = nmisses;
+   evictions      = nevicts;
+
+   return nentries;
+}
+
+// Quantize to a count of decimal places
+qint64 US_FitnessCache::quantize_fixed( double value, int places )
+{
+   return qRound64( value * pow( 10.0, places ) );
+}
+
+// Quantize to a count of significant digits, combined with the exponent
+qint64 US_FitnessCache::quantize_sig( double value, int digits )
+{
+   double avalue  = qAbs( value );
+
+   if ( avalue < 1.0e-300  ||  avalue > 1.0e+300 )
+      return 0;
+
+   int    expon   = (int)floor( log10( avalue ) );
+   qint64 mantis  = qRound64( value * pow( 10.0, digits - 1 - expon ) );
+
+   if ( qAbs( mantis ) >= qRound64( pow( 10.0, digits ) ) )
+   {  // Rounding carried into another digit
+      expon++;
+      mantis         = qRound64( value * pow( 10.0, digits - 1 - expon ) );
+   }
+
+   return ( mantis * 1024 + ( expon + 512 ) );
+}
+
+// Allocate the table for a key length and return its slot count
+int US_FitnessCache::allocate( int klen )
+{
+   qint64 sbytes  = klen * sizeof( qint64 ) + sizeof( double )
+                    + sizeof( quint32 );
+   qint64 nfit    = ( (qint64)budget_mb * 1024 * 1024 ) / sbytes;
+   int    nslots  = PROBE_SLOTS;
+
+   while ( nslots < MAX_SLOTS  &&  (qint64)nslots * 2 <= nfit )
+      nslots        *= 2;
+
+   keys.fill( 0,   nslots * klen );
+   fits.fill( 0.0, nslots );
+   used.fill( 0,   nslots );
+
+   return nslots;
+}
+
+// Hash a key (FNV-1a over the values, with a final bit mix)
+quint64 US_FitnessCache::hash_key( const QVector< qint64 >& key ) const
+{
+   quint64 hash   = 0xcbf29ce484222325ULL;
+
+   for ( int jj = 0; jj < key.size(); jj++ )
+   {
+      hash          ^= (quint64)key[ jj ];
+      hash          *= 0x100000001b3ULL;
+   }
+
+   hash          ^= ( hash >> 33 );
+   hash          *= 0xff51afd7ed558ccdULL;
+   hash          ^= ( hash >> 33 );
+
+   return hash;
+}
+
+// Find the slot holding a key, or else the slot in which to store it
+int US_FitnessCache::find_slot( const QVector< qint64 >& key,
+                                bool& found ) const
+{
+   int  start     = (int)( hash_key( key ) & (quint64)kmask );
+   int  lslot     = start;
+   const qint64* kv = key.constData();
+
+   found          = false;
+
+   for ( int pp = 0; pp < PROBE_SLOTS; pp++ )
+   {
+      int slot       = ( start + pp ) & kmask;
+
+      if ( used[ slot ] == 0 )
+         return slot;          // Empty slot ends the search
+
+      const qint64* skey = keys.constData() + slot * klength;
+      int jj         = 0;
+
+      while ( jj < klength  &&  skey[ jj ] == kv[ jj ] )
+         jj++;
+
+      if ( jj == klength )
+      {
+         found          = true;
+         return slot;
+      }
+
+      if ( used[ slot ] < used[ lslot ] )
+         lslot          = slot;
+   }
+
+   return lslot;               // Least recently used slot of the run
+}
@@ -0,0 +1,87 @@
+//! \file us_fitness_cache.h
+#ifndef US_FITNESS_CACHE_H
+#define US_FITNESS_CACHE_H
+
+#include <QtCore>
+
+//! \brief Fixed-capacity cache of GA gene fitness values
+//!
+//! Fitness values are keyed by a vector of quantized gene parameters and
+//! held in an open-addressing hash table whose size is set from a memory
+//! budget when the key length becomes known. Each key may occupy any of
+//! a short run of slots after its hash position. When all slots of the
+//! run are in use, the least recently used of them is replaced, so the
+//! cache never grows beyond its budget. Not thread-safe.
+//!
+class US_FitnessCache
+{
+   public:
+      //! \brief Create an empty cache
+      //!
+      //! \param megabytes Memory budget in MB (0 disables the cache)
+      US_FitnessCache( int = 64 );
+
+      //! \brief Set the memory budget, removing any cached values
+      //!
+      //! \param megabytes Memory budget in MB (0 disables the cache)
+      void set_budget( int );
+
+      //! \brief Remove all cached values and reset statistics
+      void clear( void );
+
+      //! \brief Fetch the fitness for a key, if present
+      //!
+      //! \param key     Quantized gene parameters
+      //! \param fitness Returned fitness value, if found
+      //! \returns       Flag if the key was found
+      bool fetch( const QVector< qint64 >&, double& );
+
+      //! \brief Store the fitness for a key
+      //!
+      //! \param key     Quantized gene parameters
+      //! \param fitness Fitness value to save
+      void store( const QVector< qint64 >&, double );
+
+      //! \brief Return cache statistics
+      //!
+      //! \param hits      Returned count of fetches found
+      //! \param misses    Returned count of fetches not found
+      //! \param evictions Returned count of entries replaced
+      //! \returns         Count of entries currently held
+      int statistics( int&, int&, int& ) const;
+
+      //! \brief Return the count of entries currently held
+      int count( void ) const { return nentries; };
+
+      //! \brief Quantize a value to a given count of decimal places
+      //!
+      //! \param value     Value to quantize
+      //! \param places    Decimal places kept (as in "%.<places>f")
+      //! \returns         Integer key for the value
+      static qint64 quantize_fixed( double, int );
+
+      //! \brief Quantize a value to a given count of significant digits
+      //!
+      //! \param value     Value to quantize
+      //! \param digits    Significant digits kept (as in "%.<digits-1>e")
+      //! \returns         Integer key for the value
+      static qint64 quantize_sig( double, int );
+
+   private:
+      QVector< qint64 >   keys;      // Slot keys, klength values each
+      QVector< double >   fits;      // Slot fitness values
+      QVector< quint32 >  used;      // Slot last-use stamps (0 if empty)
+      int                 budget_mb; // Memory budget in MB
+      int                 klength;   // Key length (set on first store)
+      int                 kmask;     // Slot count minus one
+      int                 nentries;  // Count of slots in use
+      int                 nhits;     // Fetches found
+      int                 nmisses;   // Fetches not found
+      int                 nevicts;   // Entries replaced
+      quint32             stamp;     // Use counter for LRU replacement
+
+      int     allocate ( int );
+      quint64 hash_key ( const QVector< qint64 >& ) const;
+      int     find_slot( const QVector< qint64 >&, bool& ) const;
+};
+#endif
@@ -5,6 +5,7 @@
 #include "us_sleep.h"
 #include "us_util.h"
 #include "us_revision.h"
+#include "us_settings.h"
 
 #include <mpi.h>
 #include <sys/user.h>
@@ -12,7 +13,9 @@
 
 int main( int argc, char* argv[] )
 {
-   MPI_Init( &argc, &argv );
+   // Compute threads of the hybrid mode make no MPI calls
+   int thread_level;
+   MPI_Init_thread( &argc, &argv, MPI_THREAD_FUNNELED, &thread_level );
    QCoreApplication application( argc, argv );
 
    QStringList cmdargs;
@@ -29,6 +32,8 @@ US_MPI_Analysis::US_MPI_Analysis( int nargs, QStringList& cmdargs ) : QObject()
    // Command line special parameter keys
    const QString wallkey ( "-walltime" );
    const QString pmgckey ( "-mgroupcount" );
+   const QString ckptkey ( "-checkpoint" );
+   const QString rstrkey ( "-restart" );
    // Alternate versions of those keys
    const QString wallkey2( "-WallTimeLimit" );
    const QString pmgckey2( "-MGroupCount" );
@@ -43,10 +48,30 @@ US_MPI_Analysis::US_MPI_Analysis( int nargs, QStringList& cmdargs ) : QObject()
    maxrss       = 0L;
    minimize_opt = 2;
    in_gsm       = false;
+   restart      = false;
+   ckpt_resume  = false;
+   ckpt_resumed = false;
+   data_bcast   = 0;
+   data_shared  = false;
+   node_rank    = -1;
+   shared_data  = NULL;
+   node_comm    = MPI_COMM_NULL;
+   lead_comm    = MPI_COMM_NULL;
+   job_prefetch  = false;
+   job_requested = false;
+   job_request   = MPI_REQUEST_NULL;
+   worker_waited = 0;
+   migrate_topology = 0;
+   migrate_comm     = MPI_COMM_NULL;
+
+   for ( int ii = 0; ii < 6; ii++ )
+      sent_reqs[ ii ] = MPI_REQUEST_NULL;
+
    QString tarfile;
    QString jxmlfili;
    task_params[ "walltime"    ] = "1440";
    task_params[ "mgroupcount" ] = "1";
+   task_params[ "checkpoint"  ] = "1";
 
    // Get some task parameters from the command line
    for ( int jj = 1; jj < nargs; jj++ )
@@ -55,7 +80,12 @@ US_MPI_Analysis::US_MPI_Analysis( int nargs, QStringList& cmdargs ) : QObject()
 if(my_rank==0)
 DbgLv(0) << "CmdArg: jj" << jj << "cmdarg" << cmdarg;
 
-      if ( cmdarg.startsWith( "-" ) )
+      if ( cmdarg == rstrkey  ||  cmdarg == ( "-" + rstrkey ) )
+      {  // Flag ("--restart") to resume from the last checkpoint
+         restart        = true;
+      }
+
+      else if ( cmdarg.startsWith( "-" ) )
       {  // Argument pair is keyed set (.e.g., "-maxwall <n>")
          QString cmdval = "";
          int valx       = cmdarg.indexOf( "=" ); 
@@ -83,6 +113,11 @@ DbgLv(0) << "CmdArg: jj" << jj << "cmdarg" << cmdarg;
          {  // Get number of parallel masters groups
             task_params[ "mgroupcount" ] = cmdval;
          }
+
+         else if ( cmdarg.contains( ckptkey ) )
+         {  // Get Monte Carlo iterations between checkpoints (0 for none)
+            task_params[ "checkpoint"  ] = cmdval;
+         }
 if(my_rank==0)
 DbgLv(0) << "CmdArg:   valx" << valx << "cmdval" << cmdval;
       }
@@ -100,6 +135,7 @@ DbgLv(0) << "CmdArg:   valx" << valx << "cmdval" << cmdval;
 if(my_rank==0) {
 DbgLv(0) << "CmdArg: walltime" << task_params["walltime"];
 DbgLv(0) << "CmdArg: mgroupcount" << task_params["mgroupcount"];
+DbgLv(0) << "CmdArg: checkpoint" << task_params["checkpoint"] << "restart" << restart;
 DbgLv(0) << "CmdArg: tarfile" << tarfile;
 DbgLv(0) << "CmdArg: jxmlfili" << jxmlfili;
 }
@@ -132,6 +168,7 @@ DbgLv(0) << "work_dir=" << work_dir;
 
       // Create a dedicated output directory and make sure it's empty
       // During testing, it may not always be empty
+      // (On restart, outputs of the interrupted run are kept)
       wkdir.mkdir  ( output_dir );
 
       QDir odir( output_dir );
@@ -140,7 +177,8 @@ DbgLv(0) << "work_dir=" << work_dir;
       QStringList files = odir.entryList( ffilt, QDir::Files );
       QString     file;
 
-      foreach( file, files ) odir.remove( file );
+      if ( ! restart )
+         foreach( file, files ) odir.remove( file );
       DbgLv(0) << "Start:  processor_count" << proc_count;
    }
  
@@ -189,6 +227,10 @@ DbgLv(0) << "work_dir=" << work_dir;
    else
       US_Math2::randomize();
 
+   // Base seed for Monte Carlo data (made common to all in checkpoint_sync)
+   mc_seed          = parameters.contains( "seed" ) ? seed : (uint)qrand();
+   ckpt_interval    = qMax( 0, task_params[ "checkpoint" ].toInt() );
+
    QString jxmlfile  = jxmlfili;
 
    // Parse task xml file if present or needed (input argument or detected file)
@@ -232,54 +274,13 @@ DbgLv(0) << "submitTime " << submitTime
    QString msg_start = QString( "Starting --  " ) + QString( REVISION );
    send_udp( msg_start );   // Can't send udp message until xmlfile is parsed
 
-   // Read data 
+   // Read data:  in every process, or in one (per node) and broadcast
+   read_data( parameters[ "data_bcast" ].toInt() );
+
    for ( int ii = 0; ii < data_sets.size(); ii++ )
    {
       US_SolveSim::DataSet* dset = data_sets[ ii ];
 
-      try
-      {
-         int result = US_DataIO::loadData( ".", dset->edit_file,
-                                                dset->run_data );
-
-         if ( result != US_DataIO::OK ) throw result;
-      }
-      catch ( int error )
-      {
-         QString msg = "Bad data file " + dset->auc_file + " "
-                                        + dset->edit_file;
-DbgLv(0) << "BAD DATA. error" << error << "rank" << my_rank;
-         abort( msg, error );
-      }
-      catch ( US_DataIO::ioError error )
-      {
-         QString msg = "Bad data file " + dset->auc_file + " "
-                                        + dset->edit_file;
-DbgLv(0) << "BAD DATA. ioError" << error << "rank" << my_rank << proc_count;
-//if(proc_count!=16)
-         abort( msg, error );
-      }
-//DbgLv(0) << "Good DATA. rank" << my_rank;
-
-      for ( int jj = 0; jj < dset->noise_files.size(); jj++ )
-      {
-          US_Noise noise;
-
-          int err = noise.load( dset->noise_files[ jj ] );
-
-          if ( err != 0 )
-          {
-             QString msg = "Bad noise file " + dset->noise_files[ jj ];
-             abort( msg );
-          }
-
-          if ( noise.apply_to_data( dset->run_data  ) != 0 )
-          {
-             QString msg = "Bad noise file " + dset->noise_files[ jj ];
-             abort( msg );
-          }
-      }
-
       dset->temperature = dset->run_data.average_temperature();
       dset->vbartb = US_Math2::calcCommonVbar( dset->solution_rec,
                                                dset->temperature );
@@ -298,6 +299,45 @@ DbgLv(0) << "BAD DATA. ioError" << error << "rank" << my_rank << proc_count;
    mc_iterations   = parameters[ "mc_iterations" ].toInt();
    mc_iterations   = qMax( mc_iterations, 1 );
 
+   // Set the solute-simulation cache budget in MB, if given (default 0:
+   //  disabled)
+   if ( parameters.contains( "simcache_mb" ) )
+      US_SimCache::set_budget( parameters[ "simcache_mb" ].toInt() );
+
+   // Set the persistent simulation basis store, if given a size in MB
+   if ( parameters.contains( "simstore_mb" ) )
+   {
+      QString sdir    = parameters.contains( "simstore_dir" )
+                        ? parameters[ "simstore_dir" ]
+                        : US_Settings::tmpDir() + "/simstore";
+
+      if ( ! US_SimCache::set_store( sdir,
+                                     parameters[ "simstore_mb" ].toInt() ) )
+      {
+         DbgLv(0) << "*WARNING* Could not use the simulation basis store"
+                  << sdir;
+      }
+   }
+
+   // Set the GA fitness cache budget in MB, if given (0 disables)
+   if ( parameters.contains( "fitcache_mb" ) )
+      fitness_cache.set_budget( parameters[ "fitcache_mb" ].toInt() );
+
+   // Set the NNLS method:  0 Lawson-Hanson, 1 normal equations, 2 compare.
+   //  The warm start from previous solute concentrations and the sparse A
+   //  of band-forming and ODlimit fits are used only with 1.
+   nnls_mode       = parameters.contains( "nnls_mode" )
+                     ? parameters[ "nnls_mode" ].toInt() : 0;
+
+   // Set the precision of screening simulations (2DSA depth 0 and GA
+   //  fitness):  0 double, 1 float, 2 float checked against double
+   sim_precision   = parameters.contains( "sim_precision" )
+                     ? parameters[ "sim_precision" ].toInt() : 0;
+
+   // Set the compute threads of each rank (hybrid MPI + threads mode)
+   compute_threads = parameters.contains( "compute_threads" )
+                     ? qMax( 1, parameters[ "compute_threads" ].toInt() ) : 1;
+
    meniscus_range  = parameters[ "meniscus_range"  ].toDouble();
    meniscus_points = parameters[ "meniscus_points" ].toInt();
    meniscus_points = qMax( meniscus_points, 1 );
@@ -400,6 +440,7 @@ DbgLv(0) << "BAD DATA. ioError" << error << "rank" << my_rank << proc_count;
    mutation                = parameters[ "mutation"       ].toInt();
    plague                  = parameters[ "plague"         ].toInt();
    migrate_count           = parameters[ "migration"      ].toInt();
+   migrate_topology        = parameters[ "migrate_topology" ].toInt();
    elitism                 = parameters[ "elitism"        ].toInt();
    mutate_sigma            = parameters[ "mutate_sigma"   ].toDouble();
    p_mutate_s              = parameters[ "p_mutate_s"     ].toDouble();
@@ -444,7 +485,9 @@ if ( my_rank == 0 )
  
       int nssp            = ds->simparams.speed_step.count();
       bool incl_speed     = ( nssp < 1 );
-      ds->simparams.initFromData( NULL, *edata, incl_speed );
+
+      if ( data_bcast == 0 )   // Else done by the data reader
+         ds->simparams.initFromData( NULL, *edata, incl_speed );
 if ( my_rank == 0 )
  DbgLv(0) << "incl_speed" << incl_speed << "nssp" << nssp;
  
@@ -705,6 +748,12 @@ void US_MPI_Analysis::start( void )
    gcores_count            = proc_count;
    group_rank              = my_rank;
 
+   // Set up checkpoints and learn if resuming from one
+   checkpoint_sync();
+
+   // Share experiment data among the workers of each node, if requested
+   share_data( parameters[ "shared_data" ].toInt() != 0 );
+
    // Real processing goes here
    if ( analysis_type.startsWith( "2DSA" ) )
    {
@@ -712,6 +761,12 @@ void US_MPI_Analysis::start( void )
 
       if ( iterations < 1 ) iterations = 1;
 
+      // Pre-assign jobs to busy workers, unless turned off. Workers with
+      //  compute threads always take several jobs.
+      job_prefetch = ! ( parameters.contains( "job_prefetch" )  &&
+                         parameters[ "job_prefetch" ].toInt() == 0 )  ||
+                     compute_threads > 1;
+
       if ( my_rank == 0 ) 
           _2dsa_master();
       else
@@ -720,6 +775,8 @@ void US_MPI_Analysis::start( void )
 
    else if ( analysis_type.startsWith( "GA" ) )
    {
+      migrate_setup();
+
       if ( my_rank == 0 ) 
           ga_master();
       else
@@ -728,6 +785,8 @@ void US_MPI_Analysis::start( void )
 
    else if ( analysis_type.startsWith( "DMGA" ) )
    {
+      migrate_setup();
+
       if ( my_rank == 0 ) 
           dmga_master();
       else
@@ -742,6 +801,11 @@ void US_MPI_Analysis::start( void )
           pcsa_worker();
    }
 
+   // Collect the time each worker spent waiting on the master
+   //  and the time its threads were busy
+   gather_stats();
+   migrate_free();
+
    int exit_status = 0;
 
    // Pack results
@@ -777,6 +841,9 @@ void US_MPI_Analysis::start( void )
       // Create archive file of outputs and remove other output files
       update_outputs( true );
 
+      // The run is complete:  its checkpoint is no longer needed
+      remove_checkpoint();
+
       // Send "Finished" message.
       int wt_hr      = walltime / 3600;
       int wt_min     = ( walltime - wt_hr * 3600 ) / 60;
@@ -819,6 +886,7 @@ void US_MPI_Analysis::start( void )
       }
    }
 
+   free_shared_data();
    MPI_Finalize();
    exit( exit_status );
 }
@@ -933,6 +1001,117 @@ void US_MPI_Analysis::stats_output( int walltime, int cputime, int maxrssmb,
    xml.writeAttribute    ( "maxwalltime",  QString::number( max_walltime ) );
    xml.writeAttribute    ( "groupcount",   QString::number( mgroup_count ) );
    xml.writeEndElement   ();  // id
+
+   if ( worker_jobs.size() > 1 )
+   {  // Busy and idle seconds of each worker, as seen by the master
+      int    nworkers = worker_jobs.size() - 1;
+      double busymin  = 1.0e+99;
+      double busymax  = 0.0;
+      double busysum  = 0.0;
+
+      for ( int ww = 1; ww <= nworkers; ww++ )
+      {
+         double busy     = worker_busy[ ww ] / 1000.0;
+         busymin         = qMin( busymin, busy );
+         busymax         = qMax( busymax, busy );
+         busysum        += busy;
+      }
+
+      double busyavg  = busysum / (double)nworkers;
+      double idleavg  = qMax( cputime - busyavg, 0.0 );
+
+      // Seconds workers waited on the master, when reported per rank
+      bool   waits    = ( worker_wait.size() == worker_jobs.size() );
+      double waitsum  = 0.0;
+
+      for ( int ww = 1; waits  &&  ww <= nworkers; ww++ )
+         waitsum        += worker_wait[ ww ];
+
+      // Busy percent of each worker's compute threads, when threaded
+      int    nthr     = compute_threads;
+      bool   threads  = ( nthr > 1  &&
+                          worker_tbusy.size() == worker_jobs.size() * nthr );
+
+      xml.writeStartElement ( "workers" );
+      xml.writeAttribute    ( "count",    QString::number( nworkers ) );
+      xml.writeAttribute    ( "busymin",  QString::number( busymin, 'f', 1 ) );
+      xml.writeAttribute    ( "busymax",  QString::number( busymax, 'f', 1 ) );
+      xml.writeAttribute    ( "busyavg",  QString::number( busyavg, 'f', 1 ) );
+      xml.writeAttribute    ( "idleavg",  QString::number( idleavg, 'f', 1 ) );
+
+      if ( waits )
+         xml.writeAttribute ( "waitavg",  QString::number(
+                                 waitsum / (double)nworkers, 'f', 1 ) );
+
+      if ( threads )
+         xml.writeAttribute ( "threads",  QString::number( nthr ) );
+
+      for ( int ww = 1; ww <= nworkers; ww++ )
+      {
+         double busy     = worker_busy[ ww ] / 1000.0;
+         double idle     = qMax( cputime - busy, 0.0 );
+         xml.writeStartElement ( "worker" );
+         xml.writeAttribute    ( "rank",  QString::number( ww ) );
+         xml.writeAttribute    ( "jobs",  QString::number( worker_jobs[ ww ] ) );
+         xml.writeAttribute    ( "busy",  QString::number( busy, 'f', 1 ) );
+         xml.writeAttribute    ( "idle",  QString::number( idle, 'f', 1 ) );
+
+         if ( waits )
+            xml.writeAttribute ( "wait",  QString::number(
+                                    worker_wait[ ww ], 'f', 1 ) );
+
+         if ( threads )
+         {  // Space-separated utilization percent of each thread
+            QStringList utils;
+
+            for ( int tt = 0; tt < nthr; tt++ )
+               utils << QString::number( cputime > 0
+                        ? worker_tbusy[ ww * nthr + tt ] * 100.0 / cputime
+                        : 0.0, 'f', 1 );
+
+            xml.writeAttribute ( "threadutil", utils.join( " " ) );
+         }
+         xml.writeEndElement   ();  // worker
+      }
+
+      xml.writeEndElement   ();  // workers
+
+      DbgLv(0) << "Workers busy seconds:  min" << busymin << "max" << busymax
+               << "avg" << busyavg << " idle avg" << idleavg;
+   }
+
+   else if ( compute_threads > 1  &&  proc_count > 1  &&
+             worker_tbusy.size() == proc_count * compute_threads )
+   {  // GA ranks have no job counts, but do have thread busy times
+      int    nworkers = proc_count - 1;
+      int    nthr     = compute_threads;
+
+      xml.writeStartElement ( "workers" );
+      xml.writeAttribute    ( "count",    QString::number( nworkers ) );
+      xml.writeAttribute    ( "threads",  QString::number( nthr ) );
+
+      for ( int ww = 1; ww <= nworkers; ww++ )
+      {
+         QStringList utils;
+
+         for ( int tt = 0; tt < nthr; tt++ )
+            utils << QString::number( cputime > 0
+                     ? worker_tbusy[ ww * nthr + tt ] * 100.0 / cputime
+                     : 0.0, 'f', 1 );
+
+         xml.writeStartElement ( "worker" );
+         xml.writeAttribute    ( "rank",  QString::number( ww ) );
+
+         if ( worker_wait.size() == proc_count )
+            xml.writeAttribute ( "wait",  QString::number(
+                                    worker_wait[ ww ], 'f', 1 ) );
+
+         xml.writeAttribute    ( "threadutil", utils.join( " " ) );
+         xml.writeEndElement   ();  // worker
+      }
+
+      xml.writeEndElement   ();  // workers
+   }
    xml.writeEndElement   ();  // US_JobStatistics
    xml.writeEndDocument  ();
 
@@ -1053,6 +1232,8 @@ if ( do_dbg ) DbgLv(1) << "w:" << my_rank << ":nsoli" << nsoli << "nsolz" << nso
 if ( do_dbg ) simu_values.dbg_level = qMax( simu_values.dbg_level, 1 );
 //*DEBUG*
 
+   simu_values.nnls_mode = nnls_mode;
+
    solvesim.calc_residuals( offset, dataset_count, simu_values );
 
 //*DEBUG*
@@ -1067,15 +1248,15 @@ if ( do_dbg )
  US_DataIO::RawData*    sdat = &simu_values.sim_data;
  int nsc = edat->scanCount();
  int nrp = edat->pointCount();
- double d0 = edat->scanData[0].rvalues[0];
- double d1 = edat->scanData[0].rvalues[1];
- double dh = edat->scanData[nsc/2].rvalues[nrp/2];
- double dm = edat->scanData[nsc-1].rvalues[nrp-2];
- double dn = edat->scanData[nsc-1].rvalues[nrp-1];
+ double d0 = edat->value(0,0);
+ double d1 = edat->value(0,1);
+ double dh = edat->value(nsc/2,nrp/2);
+ double dm = edat->value(nsc-1,nrp-2);
+ double dn = edat->value(nsc-1,nrp-1);
  DbgLv(1) << "w:" << my_rank << ":d(01hmn)" << d0 << d1 << dh << dm << dn;
  double dt = 0.0;
  for ( int ss=0;ss<nsc;ss++ )
-  for ( int rr=0;rr<nrp;rr++ ) dt += edat->scanData[ss].rvalues[rr];
+  for ( int rr=0;rr<nrp;rr++ ) dt += edat->value(ss,rr);
  DbgLv(1) << "w:" << my_rank << ":dtot" << dt;
  double s0 = sdat->value(0,0);
  double s1 = sdat->value(0,1);
@@ -1088,15 +1269,15 @@ if ( do_dbg )
   int nxx = nsc;
   nsc = edat->scanCount();
   nrp = edat->pointCount();
-  d0 = edat->scanData[0].rvalues[0];
-  d1 = edat->scanData[0].rvalues[1];
-  dh = edat->scanData[nsc/2].rvalues[nrp/2];
-  dm = edat->scanData[nsc-1].rvalues[nrp-2];
-  dn = edat->scanData[nsc-1].rvalues[nrp-1];
+  d0 = edat->value(0,0);
+  d1 = edat->value(0,1);
+  dh = edat->value(nsc/2,nrp/2);
+  dm = edat->value(nsc-1,nrp-2);
+  dn = edat->value(nsc-1,nrp-1);
   DbgLv(1) << "w:" << my_rank << ":d2(01hmn)" << d0 << d1 << dh << dm << dn;
   dt = 0.0;
   for ( int ss=0;ss<nsc;ss++ )
-   for ( int rr=0;rr<nrp;rr++ ) dt += edat->scanData[ss].rvalues[rr];
+   for ( int rr=0;rr<nrp;rr++ ) dt += edat->value(ss,rr);
   DbgLv(1) << "w:" << my_rank << ":dtot" << dt;
   s0 = sdat->value(nxx+0,0);
   s1 = sdat->value(nxx+0,1);
@@ -1568,6 +1749,7 @@ void US_MPI_Analysis::shutdown_all( void )
    MPI_Job job;
    job.command = MPI_Job::SHUTDOWN;
 DbgLv(1) << "2dsa master shutdown : master maxrss" << maxrss;
+   complete_jobs();
  
    for ( int i = 1; i <= my_workers; i++ )
    {
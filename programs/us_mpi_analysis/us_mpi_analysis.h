@@ -14,6 +14,8 @@
 #include "us_solve_sim.h"
 #include "us_vector.h"
 #include "us_math2.h"
+#include "us_fitness_cache.h"
+#include "us_checkpoint.h"
 
 #define SIMULATION       US_SolveSim::Simulation
 #define DATASET          US_SolveSim::DataSet
@@ -47,6 +49,9 @@ class US_MPI_Analysis : public QObject
     int                 iterations;           // Master only - Iterative
     int                 max_iterations;       // Master only - Iterative
     int                 mc_iterations;        // Monte Carlo
+    int                 nnls_mode;            // NNLS method (0,1,2)
+    int                 sim_precision;        // Screening sims float (0,1,2)
+    int                 compute_threads;      // Compute threads per rank
     int                 mc_iteration;         // Monte Carlo current iteration
     int                 max_experiment_size;
     int                 total_points;
@@ -56,6 +61,24 @@ class US_MPI_Analysis : public QObject
     bool                do_astfem;
     bool                is_global_fit;
     bool                is_composite_job;
+    bool                restart;              // Restart requested
+    bool                ckpt_resume;          // Resuming from a checkpoint
+    bool                ckpt_resumed;         // Run resumed from a checkpoint
+    int                 ckpt_interval;        // MC iterations per checkpoint
+    uint                mc_seed;              // Base random seed for MC data
+    int                 data_bcast;           // Data read mode (0,1,2)
+    bool                data_shared;          // Data shared within nodes
+    int                 node_rank;            // Rank among node's workers
+    double*             shared_data;          // Node's shared readings
+    MPI_Win             data_win;             // Window of shared readings
+    MPI_Comm            node_comm;            // Workers of this node
+    MPI_Comm            lead_comm;            // Master, first node workers
+    bool                job_prefetch;         // Pre-assign busy workers' jobs
+    bool                job_requested;        // Worker:  next job requested
+    MPI_Request         job_request;          // Worker:  next job receive
+    MPI_Request         sent_reqs[ 6 ];       // Worker:  results sends
+    int                 sent_sizes[ 4 ];      // Worker:  results sizes sent
+    qint64              worker_waited;        // Worker:  ms waiting on master
 
     MPI_Comm            my_communicator;
 
@@ -70,6 +93,8 @@ class US_MPI_Analysis : public QObject
     int                 mutation;
     int                 plague;
     int                 migrate_count;
+    int                 migrate_topology;     // 0 via master, 1 ring, 2 random
+    MPI_Comm            migrate_comm;         // Workers' peer migration
     int                 elitism;
     int                 attr_x;
     int                 attr_y;
@@ -91,6 +116,9 @@ class US_MPI_Analysis : public QObject
                         
     QVector< int >      worker_status;
     QVector< int >      worker_depth;
+    QVector< int >      worker_jobs;     // Jobs completed by each worker
+    QVector< qint64 >   worker_busy;     // Busy milliseconds of each worker
+    QVector< qint64 >   worker_start;    // Start of each worker's job (ms)
     QList< int >        ds_startx;
     QList< int >        ds_points;
     QVector< double >   gl_nnls_a;
@@ -184,6 +212,12 @@ class US_MPI_Analysis : public QObject
           MPI_Job               mpi_job;
           QVector< US_Solute  > solutes;
           QVector< US_ZSolute > zsolutes;
+          double                cost;     // Estimated relative cost
+
+          Sa_Job()
+          {
+             cost           = 0.0;
+          };
     };
 
     QList< Sa_Job >               job_queue;
@@ -203,6 +237,7 @@ class US_MPI_Analysis : public QObject
     SIMULATION simulation_values;
     SIMULATION wksim_vals;
     SIMULATION previous_values;
+    SIMULATION sent_values;      // Worker:  results being sent
 
     // 2DSA class
     class Result
@@ -216,6 +251,38 @@ class US_MPI_Analysis : public QObject
 
     QList< Result >             cached_results;
 
+    MPI_Job                     next_job;         // Worker:  job being received
+    QVector< Sa_Job >           worker_sjobs;     // Jobs being sent to workers
+    QVector< MPI_Request >      worker_sreqs;     // Their send requests
+    QVector< QList< int > >     worker_queued;    // Depths of workers' jobs
+    QVector< bool >             worker_prefetch;  // Worker asked for next job
+    QVector< double >           worker_wait;      // Seconds each rank waited
+    QVector< double >           worker_tbusy;     // Ranks' thread busy seconds
+
+    // Thread computing residuals in the hybrid MPI + threads mode.
+    //  Threads given the same list take its simulations in turn.
+    class ResidThread : public QThread
+    {
+       public:
+          ResidThread( US_MPI_Analysis* );
+
+          void set_work( int, int, SIMULATION*, int, QAtomicInt* = 0 );
+          void run     ( void );
+
+          US_MPI_Analysis* analysis;      // Parent analysis object
+          SIMULATION*      sims;          // Simulations to compute
+          QAtomicInt*      next;          // Index of the next one to take
+          QAtomicInt       own_next;      // Index if not shared
+          int              nsims;         // Count of simulations
+          int              offset;        // Data set offset
+          int              dataset_count; // Data sets count
+          qint64           busy_ms;       // Milliseconds spent computing
+    };
+
+    QList< ResidThread* >       res_threads;      // Worker compute threads
+    QList< QVector< double > >  migrate_bufs;     // Emigrants being sent
+    QList< MPI_Request >        migrate_reqs;     // Their send requests
+
     // GA class variables and classes
 
     class Bucket
@@ -243,7 +310,7 @@ class US_MPI_Analysis : public QObject
     QList< Gene >             genes;
     QList< Gene >             best_genes;   // Size is number of processors
     QList< SIMULATION >       sim_values;
-    QMap < QString, double >  fitness_map;
+    US_FitnessCache           fitness_cache;
     int                       fitness_hits;
     QList< DGene >            dgenes;
     QList< DGene >            best_dgenes;  // Size is number of workers
@@ -323,6 +390,8 @@ class US_MPI_Analysis : public QObject
     void     submit            ( Sa_Job&, int );
     void     submit_pcsa       ( Sa_Job&, int );
     void     add_to_queue      ( Sa_Job& );
+    double   job_cost          ( const QVector< US_Solute >& );
+    void     split_subgrids    ( void );
     void     process_results   ( int, const int* );
     void     shutdown_all      ( void );
     void     write_noise       ( US_Noise::NoiseType, const QVector< double>& );
@@ -352,6 +421,8 @@ class US_MPI_Analysis : public QObject
 
     // Worker
     void     _2dsa_worker      ( void );
+    void     _2dsa_worker_threads( void );
+    void     worker_new_data   ( MPI_Job& );
 
     void     calc_residuals     ( int, int, SIMULATION& );
 
@@ -376,6 +447,10 @@ class US_MPI_Analysis : public QObject
     int    e_random      ( void );
     double minimize      ( Gene&, double );
     double get_fitness   ( const Gene& );
+    bool   fitness_setup ( const Gene&, SIMULATION&, QVector< qint64 >&,
+                           double& );
+    double fitness_store ( SIMULATION&, const QVector< qint64 >& );
+    void   population_fitness( void );
     double get_fitness_v ( const US_Vector& );
     double update_fitness( int, US_Vector& );
     void   lamm_gsm_df   ( const US_Vector&, US_Vector& );
@@ -419,6 +494,7 @@ class US_MPI_Analysis : public QObject
     void    lamm_gsm_df_dmga   ( US_Vector&, US_Vector&, US_Vector& );
     double  minimize_dmga      ( DGene&, double );
     QString dgene_key          ( DGene& );
+    void    dgene_qkey         ( DGene&, QVector< qint64 >& );
     void    calc_residuals_dmga( int, int, SIMULATION&, DGene& );
 
     // PCSA Master
@@ -462,6 +538,48 @@ class US_MPI_Analysis : public QObject
     void    pm_dmga_cjmast     ( void );
     void    pm_pcsa_cjmast     ( void );
 
+    // Data input
+    void    read_data          ( int );
+    int     load_dataset       ( US_SolveSim::DataSet*, QString& );
+    void    share_data         ( bool );
+    void    sync_shared        ( void );
+    void    update_shared      ( int, int, int );
+    void    free_shared_data   ( void );
+
+    // Job exchange
+    void    send_job           ( Sa_Job&, int );
+    void    complete_jobs      ( void );
+    void    job_sent           ( int, int );
+    int     job_returned       ( int );
+    void    worker_ready       ( int );
+    int     prefetch_worker    ( void );
+    void    request_job        ( void );
+    void    wait_job           ( MPI_Job& );
+    void    send_results       ( const int*, SIMULATION&, int );
+    void    complete_sends     ( void );
+    void    gather_stats       ( void );
+
+    // Hybrid MPI + threads
+    void    init_threads       ( void );
+    void    thread_residuals   ( int, int, SIMULATION& );
+    void    run_threads        ( int, int, QVector< SIMULATION >& );
+    void    wait_threads       ( void );
+    void    end_threads        ( void );
+
+    // Island migration
+    void    migrate_setup      ( void );
+    void    migrate_free       ( void );
+    int     migrate_peers      ( const double*, double*, int );
+    void    migrate_finish     ( void );
+
+    // Checkpoint and restart
+    void    checkpoint_sync    ( void );
+    void    remove_checkpoint  ( void );
+    void    mc_reseed          ( int );
+    void    checkpoint_header  ( US_Checkpoint& );
+    void    write_checkpoint   ( void );
+    bool    read_checkpoint    ( bool );
+
     // Debug
     void    dump_buckets( void );
     void    dump_genes  ( int );
@@ -30,9 +30,19 @@ SOURCES      += us_mpi_analysis.cpp  \
                 pcsa_worker.cpp      \
                 parallel_masters.cpp \
                 pmasters_compjob.cpp \
-                us_mpi_parse.cpp
-
-HEADERS      += us_mpi_analysis.h
+                us_mpi_parse.cpp     \
+                us_mpi_checkpoint.cpp \
+                us_mpi_data.cpp      \
+                us_mpi_jobs.cpp      \
+                us_mpi_threads.cpp   \
+                us_mpi_migrate.cpp   \
+                us_fitness_cache.cpp \
+                us_checkpoint.cpp
+
+HEADERS      += us_mpi_analysis.h    \
+                us_mpi_shared_data.h \
+                us_fitness_cache.h   \
+                us_checkpoint.h
 
 INCLUDEPATH  += ../../utils /usr/include/mysql
 DEPENDPATH   += ../../utils
@@ -0,0 +1,196 @@
+#include "us_mpi_analysis.h"
+#include "us_math2.h"
+
+#define CKPT_FILE    "../us_mpi_checkpoint.dat"   // Relative to output dir
+
+// Remove the outputs recorded by an interrupted run, which a run started
+//  over would otherwise add to. Other files are left in place.
+static void remove_run_outputs( void )
+{
+   QFile       filea( "analysis_files.txt" );
+   QStringList files;
+
+   if ( filea.open( QIODevice::ReadOnly | QIODevice::Text ) )
+   {
+      QTextStream ts( &filea );
+
+      while ( ! ts.atEnd() )
+      {
+         QString fname  = ts.readLine().section( ";", 0, 0 );
+
+         if ( ! fname.isEmpty()  &&  ! fname.contains( "/" ) )
+            files << fname;
+      }
+
+      filea.close();
+   }
+
+   files << QDir( "." ).entryList( QStringList( "*.mdl.tmp" ), QDir::Files );
+   files << "analysis_files.txt";
+
+   for ( int ii = 0; ii < files.size(); ii++ )
+      QFile::remove( files[ ii ] );
+}
+
+// Remove the checkpoint file (at the start of a new run or at the end of
+//  a completed one)
+void US_MPI_Analysis::remove_checkpoint( void )
+{
+   if ( QFile::exists( CKPT_FILE ) )
+   {
+      QFile::remove( CKPT_FILE );
+      DbgLv(1) << "Checkpoint file removed";
+   }
+}
+
+// Agree among all processes on checkpointing and on resuming from one
+void US_MPI_Analysis::checkpoint_sync( void )
+{
+   // Checkpoints are taken between Monte Carlo iterations of standard
+   //  (single group, non-composite) 2DSA and GA jobs. They hold the master
+   //  state at an iteration boundary only:  a resumed run repeats the
+   //  interrupted iteration from its start. Runs without MC iterations,
+   //  parallel-masters groups, composite jobs and PCSA are not
+   //  checkpointed.
+   if ( mc_iterations < 2  ||  mgroup_count > 1  ||  is_composite_job  ||
+        analysis_type.startsWith( "PCSA" ) )
+      ckpt_interval  = 0;
+
+   int ckvals[ 2 ];
+   ckvals[ 0 ]    = 0;
+   ckvals[ 1 ]    = (int)mc_seed;
+
+   if ( my_rank == 0 )
+   {
+      if ( ! restart )
+      {  // A new run never resumes an earlier run's checkpoint
+         remove_checkpoint();
+      }
+
+      else if ( ckpt_interval > 0 )
+         ckvals[ 0 ]    = read_checkpoint( false ) ? 1 : 0;
+
+      if ( restart  &&  ckvals[ 0 ] == 0 )
+      {  // Nothing to resume:  drop the interrupted run's recorded outputs
+         DbgLv(0) << "*WARNING* No usable checkpoint in"
+                  << QFileInfo( CKPT_FILE ).absoluteFilePath()
+                  << "- starting from the beginning";
+         remove_checkpoint();
+         remove_run_outputs();
+      }
+
+      else if ( ckvals[ 0 ] != 0 )
+      {
+         DbgLv(0) << "Restart:  resuming after MC iteration"
+                  << mc_iteration << "of" << mc_iterations;
+      }
+
+      ckvals[ 1 ]    = (int)mc_seed;
+   }
+
+   MPI_Bcast( ckvals, 2, MPI_INT, MPI_Job::MASTER, MPI_COMM_WORLD );
+
+   ckpt_resume    = ( ckvals[ 0 ] != 0 );
+   ckpt_resumed   = ckpt_resume;
+   mc_seed        = (uint)ckvals[ 1 ];
+}
+
+// Reset the random sequence for a Monte Carlo iteration of a run resumed
+//  from a checkpoint, so that its processes do not repeat the sequences
+//  they started the interrupted run with. Runs not resumed keep their
+//  sequences untouched. A resumed run is statistically, not bitwise,
+//  equivalent to an uninterrupted one.
+void US_MPI_Analysis::mc_reseed( int iteration )
+{
+   if ( ckpt_resumed  &&  iteration > 0 )
+      qsrand( mc_seed + (uint)( iteration * proc_count + my_rank ) );
+}
+
+// Set the job and run identity of a checkpoint for the current run
+void US_MPI_Analysis::checkpoint_header( US_Checkpoint& ckpt )
+{
+   ckpt.analysis_type  = analysis_type;
+   ckpt.requestID      = requestID;
+   ckpt.count_datasets = count_datasets;
+   ckpt.total_points   = total_points;
+   ckpt.mc_iterations  = parameters[ "mc_iterations" ].toInt();
+   ckpt.identity       = US_Checkpoint::run_identity( submitTime, parameters );
+}
+
+// Write a checkpoint of the master state at the start of an MC iteration
+void US_MPI_Analysis::write_checkpoint( void )
+{
+   if ( ckpt_interval < 1  ||  ( mc_iteration % ckpt_interval ) != 0 )
+      return;
+
+   US_Checkpoint ckpt;
+   checkpoint_header( ckpt );
+
+   ckpt.mc_iteration        = mc_iteration;
+   ckpt.current_dataset     = current_dataset;
+   ckpt.datasets_to_process = datasets_to_process;
+   ckpt.meniscus_run        = meniscus_run;
+   ckpt.mc_seed             = (quint32)mc_seed;
+   ckpt.analysisDate        = analysisDate;
+   ckpt.modelGUID           = modelGUID;
+   ckpt.afsize              = QFileInfo( "analysis_files.txt" ).size();
+   ckpt.sigmas              = sigmas;
+   ckpt.sim_data1           = sim_data1;
+   ckpt.scaled_data         = scaled_data;
+
+   if ( ! ckpt.write( CKPT_FILE ) )
+   {
+      DbgLv(0) << "*WARNING* Could not write checkpoint file" << CKPT_FILE;
+   }
+   else
+   {
+      DbgLv(1) << "Checkpoint written at MC iteration" << mc_iteration;
+   }
+}
+
+// Read a checkpoint:  validate its header only or restore master state
+bool US_MPI_Analysis::read_checkpoint( bool restore )
+{
+   US_Checkpoint ckpt;
+   US_Checkpoint ckrun;
+
+   if ( ! ckpt.read( CKPT_FILE, restore ) )
+      return false;
+
+   checkpoint_header( ckrun );
+
+   if ( ! ckpt.same_run( ckrun ) )
+   {
+      DbgLv(0) << "*WARNING* Checkpoint" << CKPT_FILE
+               << "is not from this run";
+      return false;
+   }
+
+   if ( ckpt.mc_iteration < 1  ||  ckpt.mc_iteration >= mc_iterations )
+      return false;
+
+   mc_seed        = (uint)ckpt.mc_seed;
+   mc_iteration   = ckpt.mc_iteration;
+
+   if ( ! restore )
+      return true;
+
+   current_dataset     = ckpt.current_dataset;
+   datasets_to_process = ckpt.datasets_to_process;
+   meniscus_run        = ckpt.meniscus_run;
+   analysisDate        = ckpt.analysisDate;
+   modelGUID           = ckpt.modelGUID;
+   iterations          = 1;
+   max_depth           = 0;
+   sigmas              = ckpt.sigmas;
+   sim_data1           = ckpt.sim_data1;
+   scaled_data         = ckpt.scaled_data;
+
+   // Drop output records written after the checkpoint
+   QFile filea( "analysis_files.txt" );
+
+   if ( filea.exists()  &&  filea.size() > ckpt.afsize )
+      filea.resize( ckpt.afsize );
+
+   return true;
+}
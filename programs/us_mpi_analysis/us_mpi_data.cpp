@@ -0,0 +1,419 @@
+#include "us_mpi_analysis.h"
+#include "us_mpi_shared_data.h"
+#include "us_math2.h"
+
+// Write all of an edited data set, with any noise already applied
+static void write_edited( QDataStream& ds, US_DataIO::EditedData& edata )
+{
+   int nspeeds    = edata.speedData.size();
+   int nscans     = edata.scanCount();
+
+   ds << edata.expType << edata.runID << edata.editID << edata.dataType
+      << edata.cell << edata.channel << edata.wavelength << edata.description
+      << edata.editGUID << edata.dataGUID
+      << edata.meniscus << edata.plateau << edata.baseline << edata.ODlimit
+      << edata.floatingData << edata.xvalues << nspeeds << nscans;
+
+   for ( int jj = 0; jj < nspeeds; jj++ )
+   {
+      US_DataIO::SpeedData* spd = &edata.speedData[ jj ];
+      ds << spd->first_scan << spd->scan_count << spd->speed
+         << spd->meniscus << spd->dataLeft << spd->dataRight;
+   }
+
+   for ( int ss = 0; ss < nscans; ss++ )
+   {
+      US_DataIO::Scan* scan = &edata.scanData[ ss ];
+      ds << scan->temperature << scan->rpm << scan->seconds
+         << scan->omega2t << scan->wavelength << scan->plateau
+         << scan->delta_r << scan->nz_stddev << scan->rvalues
+         << scan->stddevs << scan->interpolated;
+   }
+}
+
+// Read an edited data set as written by write_edited()
+static void read_edited( QDataStream& ds, US_DataIO::EditedData& edata )
+{
+   int nspeeds;
+   int nscans;
+
+   ds >> edata.expType >> edata.runID >> edata.editID >> edata.dataType
+      >> edata.cell >> edata.channel >> edata.wavelength >> edata.description
+      >> edata.editGUID >> edata.dataGUID
+      >> edata.meniscus >> edata.plateau >> edata.baseline >> edata.ODlimit
+      >> edata.floatingData >> edata.xvalues >> nspeeds >> nscans;
+
+   edata.speedData.clear();
+
+   for ( int jj = 0; jj < nspeeds; jj++ )
+   {
+      US_DataIO::SpeedData spd;
+      ds >> spd.first_scan >> spd.scan_count >> spd.speed
+         >> spd.meniscus >> spd.dataLeft >> spd.dataRight;
+      edata.speedData << spd;
+   }
+
+   edata.scanData.resize( qMax( 0, nscans ) );
+
+   for ( int ss = 0; ss < nscans; ss++ )
+   {
+      US_DataIO::Scan* scan = &edata.scanData[ ss ];
+      ds >> scan->temperature >> scan->rpm >> scan->seconds
+         >> scan->omega2t >> scan->wavelength >> scan->plateau
+         >> scan->delta_r >> scan->nz_stddev >> scan->rvalues
+         >> scan->stddevs >> scan->interpolated;
+   }
+}
+
+// Write the simulation parameters that initFromData() derives from data
+static void write_simparms( QDataStream& ds, US_SimulationParameters& sp )
+{
+   int nsteps     = sp.speed_step.size();
+
+   ds << sp.rotorCalID << sp.rotorcoeffs[ 0 ] << sp.rotorcoeffs[ 1 ]
+      << sp.meniscus << sp.bottom_position << sp.bottom << nsteps;
+
+   for ( int jj = 0; jj < nsteps; jj++ )
+   {
+      US_SimulationParameters::SpeedProfile* ssp = &sp.speed_step[ jj ];
+      ds << ssp->duration_minutes << ssp->delay_minutes
+         << ssp->w2t_first << ssp->w2t_last
+         << ssp->avg_speed << ssp->speed_stddev
+         << ssp->duration_hours << ssp->delay_hours
+         << ssp->time_first << ssp->time_last << ssp->scans
+         << ssp->rotorspeed << ssp->acceleration << ssp->set_speed
+         << ssp->acceleration_flag;
+   }
+}
+
+// Read simulation parameters as written by write_simparms()
+static void read_simparms( QDataStream& ds, US_SimulationParameters& sp )
+{
+   int nsteps;
+
+   ds >> sp.rotorCalID >> sp.rotorcoeffs[ 0 ] >> sp.rotorcoeffs[ 1 ]
+      >> sp.meniscus >> sp.bottom_position >> sp.bottom >> nsteps;
+
+   sp.speed_step.resize( qMax( 0, nsteps ) );
+
+   for ( int jj = 0; jj < nsteps; jj++ )
+   {
+      US_SimulationParameters::SpeedProfile* ssp = &sp.speed_step[ jj ];
+      ds >> ssp->duration_minutes >> ssp->delay_minutes
+         >> ssp->w2t_first >> ssp->w2t_last
+         >> ssp->avg_speed >> ssp->speed_stddev
+         >> ssp->duration_hours >> ssp->delay_hours
+         >> ssp->time_first >> ssp->time_last >> ssp->scans
+         >> ssp->rotorspeed >> ssp->acceleration >> ssp->set_speed
+         >> ssp->acceleration_flag;
+   }
+}
+
+// Load the edited data of a data set and apply its noise.
+//  Returns 0 if all is well; else an error code, with a message.
+int US_MPI_Analysis::load_dataset( US_SolveSim::DataSet* dset, QString& msg )
+{
+   try
+   {
+      int result = US_DataIO::loadData( ".", dset->edit_file,
+                                             dset->run_data );
+
+      if ( result != US_DataIO::OK ) throw result;
+   }
+   catch ( int error )
+   {
+      msg = "Bad data file " + dset->auc_file + " " + dset->edit_file;
+DbgLv(0) << "BAD DATA. error" << error << "rank" << my_rank;
+      return ( error != 0 ? error : -1 );
+   }
+   catch ( US_DataIO::ioError error )
+   {
+      msg = "Bad data file " + dset->auc_file + " " + dset->edit_file;
+DbgLv(0) << "BAD DATA. ioError" << error << "rank" << my_rank << proc_count;
+      return ( error != 0 ? (int)error : -1 );
+   }
+
+   for ( int jj = 0; jj < dset->noise_files.size(); jj++ )
+   {
+      US_Noise noise;
+
+      if ( noise.load( dset->noise_files[ jj ] ) != 0  ||
+           noise.apply_to_data( dset->run_data ) != 0 )
+      {
+         msg = "Bad noise file " + dset->noise_files[ jj ];
+         return -1;
+      }
+   }
+
+   return 0;
+}
+
+// Read the experiment data of all data sets.
+//  With mode 0, every process reads all the data files.  With mode 1,
+//  rank 0 reads them and broadcasts the edited, noise-corrected data and
+//  its derived simulation parameters to all other processes.  With mode 2,
+//  the lowest rank on each node reads and broadcasts within its node.
+void US_MPI_Analysis::read_data( int mode )
+{
+   QString msg;
+   int     error  = 0;
+
+   data_bcast     = ( proc_count > 1 ) ? mode : 0;
+
+   if ( data_bcast == 0 )
+   {  // Every process reads its own copy
+      for ( int ii = 0; ii < data_sets.size(); ii++ )
+      {
+         error          = load_dataset( data_sets[ ii ], msg );
+
+         if ( error != 0 )
+            abort( msg, error );
+      }
+
+      return;
+   }
+
+   // Communicator of the processes sharing one reader
+   MPI_Comm bcomm = MPI_COMM_WORLD;
+   int      brank = my_rank;
+
+   if ( data_bcast == 2 )
+   {
+#if MPI_VERSION >= 3
+      MPI_Comm_split_type( MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, my_rank,
+                           MPI_INFO_NULL, &bcomm );
+      MPI_Comm_rank( bcomm, &brank );
+#else
+      data_bcast     = 1;      // No node communicator: rank 0 reads
+#endif
+   }
+
+   QByteArray dbuf;
+
+   if ( brank == 0 )
+   {  // Reader:  load, then serialize data and derived simulation parameters
+      QDataStream ds( &dbuf, QIODevice::WriteOnly );
+      ds.setVersion( QDataStream::Qt_4_8 );
+
+      for ( int ii = 0; ii < data_sets.size(); ii++ )
+      {
+         US_SolveSim::DataSet* dset = data_sets[ ii ];
+         error          = load_dataset( dset, msg );
+
+         if ( error != 0 )
+            break;
+
+         bool incl_speed = ( dset->simparams.speed_step.count() < 1 );
+         dset->simparams.initFromData( NULL, dset->run_data, incl_speed );
+
+         write_edited  ( ds, dset->run_data );
+         write_simparms( ds, dset->simparams );
+      }
+   }
+
+   // Any read error aborts the whole job
+   int kerror     = ( error != 0 ) ? 1 : 0;
+   int gerror     = 0;
+   MPI_Allreduce( &kerror, &gerror, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD );
+
+   if ( gerror != 0 )
+   {
+      if ( bcomm != MPI_COMM_WORLD )
+         MPI_Comm_free( &bcomm );
+
+      if ( error == 0 )
+      {
+         msg            = "Bad data or noise file read by another process";
+         error          = -1;
+      }
+
+      abort( msg, error );
+   }
+
+   int dsize      = dbuf.size();
+   MPI_Bcast( &dsize, 1, MPI_INT, 0, bcomm );
+
+   if ( brank != 0 )
+      dbuf.resize( dsize );
+
+   MPI_Bcast( dbuf.data(), dsize, MPI_BYTE, 0, bcomm );
+
+   if ( brank != 0 )
+   {  // Everyone else:  deserialize
+      QDataStream ds( dbuf );
+      ds.setVersion( QDataStream::Qt_4_8 );
+
+      for ( int ii = 0; ii < data_sets.size(); ii++ )
+      {
+         read_edited  ( ds, data_sets[ ii ]->run_data );
+         read_simparms( ds, data_sets[ ii ]->simparams );
+      }
+   }
+
+   if ( bcomm != MPI_COMM_WORLD )
+      MPI_Comm_free( &bcomm );
+
+   if ( my_rank == 0 )
+   {
+      DbgLv(0) << "Data read by" << ( data_bcast == 2 ? "node" : "rank 0" )
+               << "and broadcast:  bytes" << dsize;
+   }
+}
+
+// Place the workers' experiment data in memory shared by the workers of
+//  each node, so that a node holds one copy of it instead of one per rank.
+//  Used by single-group 2DSA and GA jobs, whose workers read the data only
+//  through EditedData::value() and receive updates from the master alone.
+void US_MPI_Analysis::share_data( bool request )
+{
+   data_shared    = false;
+   node_rank      = -1;
+
+#if MPI_VERSION >= 3
+   bool eligible  = ( request  &&  proc_count > 2  &&  mgroup_count < 2  &&
+                      ! is_composite_job  &&
+                      ( analysis_type.startsWith( "2DSA" )  ||
+                        analysis_type.startsWith( "GA" ) ) );
+
+   if ( ! eligible )
+      return;
+
+   // Communicator of the workers of a node (the master keeps its own data)
+   MPI_Comm ncomm;
+   MPI_Comm_split_type( MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, my_rank,
+                        MPI_INFO_NULL, &ncomm );
+   MPI_Comm_split( ncomm, ( my_rank == MPI_Job::MASTER ) ? MPI_UNDEFINED : 0,
+                   my_rank, &node_comm );
+   MPI_Comm_free( &ncomm );
+
+   if ( node_comm != MPI_COMM_NULL )
+      MPI_Comm_rank( node_comm, &node_rank );
+
+   // Communicator of the master and the first worker of each node,
+   //  over which updated data is broadcast
+   MPI_Comm_split( MPI_COMM_WORLD,
+                   ( node_rank <= 0 ) ? 0 : MPI_UNDEFINED,
+                   my_rank, &lead_comm );
+
+   data_shared    = true;
+
+   if ( my_rank == MPI_Job::MASTER )
+      return;
+
+   // The node's first worker allocates the readings of all data sets,
+   //  plus a slot for an updated ODlimit
+   MPI_Aint wsize = ( node_rank == 0 )
+                    ? (MPI_Aint)( total_points + 1 ) * sizeof( double ) : 0;
+   MPI_Win_allocate_shared( wsize, sizeof( double ), MPI_INFO_NULL,
+                            node_comm, &shared_data, &data_win );
+
+   if ( node_rank != 0 )
+   {
+      MPI_Aint qsize;
+      int      qdisp;
+      MPI_Win_shared_query( data_win, 0, &qsize, &qdisp, &shared_data );
+   }
+
+   MPI_Win_lock_all( MPI_MODE_NOCHECK, data_win );
+
+   if ( node_rank == 0 )
+   {
+      for ( int ee = 0; ee < data_sets.size(); ee++ )
+      {
+         US_DataIO::EditedData* edata = &data_sets[ ee ]->run_data;
+         double* sdata  = shared_data + ds_startx[ ee ];
+         int     nscans = edata->scanCount();
+         int     npoints = edata->pointCount();
+
+         for ( int ss = 0; ss < nscans; ss++ )
+            for ( int rr = 0; rr < npoints; rr++ )
+               *(sdata++)     = edata->value( ss, rr );
+      }
+   }
+
+   sync_shared();
+
+   for ( int ee = 0; ee < data_sets.size(); ee++ )
+      US_MPI_SharedData::attach( data_sets[ ee ]->run_data,
+                                 shared_data + ds_startx[ ee ] );
+
+   if ( node_rank == 0 )
+   {
+      int nnode;
+      MPI_Comm_size( node_comm, &nnode );
+      DbgLv(0) << "Worker" << my_rank << ": data shared by" << nnode
+               << "workers:  MB" << ( wsize / ( 1024 * 1024 ) );
+   }
+#else
+   if ( request  &&  my_rank == 0 )
+   {
+      DbgLv(0) << "*WARNING* Shared data needs MPI-3:  not shared";
+   }
+#endif
+}
+
+// Make the shared data written by one worker visible to the others
+void US_MPI_Analysis::sync_shared( void )
+{
+#if MPI_VERSION >= 3
+   MPI_Win_sync( data_win );
+   MPI_Barrier ( node_comm );
+   MPI_Win_sync( data_win );
+#endif
+}
+
+// Receive data for a global fit scaling or Monte Carlo iteration into the
+//  shared data.  The first worker of each node receives it from the master
+//  and copies it for the node; all then pick up any new ODlimit.
+void US_MPI_Analysis::update_shared( int offset, int count, int length )
+{
+   int npoints    = 0;
+
+   for ( int ee = offset; ee < offset + count; ee++ )
+      npoints       += ds_points[ ee ];
+
+   if ( node_rank == 0 )
+   {
+      QVector< double > udata( length );
+
+      MPI_Bcast( udata.data(), length, MPI_DOUBLE, MPI_Job::MASTER,
+                 lead_comm );
+
+      double* sdata  = shared_data + ds_startx[ offset ];
+
+      for ( int jj = 0; jj < npoints; jj++ )
+         sdata[ jj ]    = udata[ jj ];
+
+      shared_data[ total_points ] = ( length > npoints ) ? udata[ npoints ]
+                                                         : 0.0;
+   }
+
+   sync_shared();
+
+   if ( is_global_fit  &&  count == 1 )
+      data_sets[ offset ]->run_data.ODlimit = shared_data[ total_points ];
+}
+
+// Release the shared data and its communicators
+void US_MPI_Analysis::free_shared_data( void )
+{
+#if MPI_VERSION >= 3
+   if ( ! data_shared )
+      return;
+
+   if ( my_rank != MPI_Job::MASTER )
+   {  // The data is no longer needed:  leave the data sets without readings
+      for ( int ee = 0; ee < data_sets.size(); ee++ )
+         US_MPI_SharedData::release( data_sets[ ee ]->run_data );
+
+      MPI_Win_unlock_all( data_win );
+      MPI_Win_free( &data_win );
+      MPI_Comm_free( &node_comm );
+   }
+
+   if ( lead_comm != MPI_COMM_NULL )
+      MPI_Comm_free( &lead_comm );
+
+   data_shared    = false;
+#endif
+}
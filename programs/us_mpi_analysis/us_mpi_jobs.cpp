@@ -0,0 +1,327 @@
+#include "us_mpi_analysis.h"
+
+// Milliseconds since the start of the run
+static qint64 run_msecs( const QDateTime& start )
+{
+   return start.msecsTo( QDateTime::currentDateTime() );
+}
+
+//////////////////
+//  Master:  job bookkeeping
+//
+//  With job prefetch, a worker asks for its next job as soon as it has
+//  received the current one, so the master may send it a second job while
+//  it is still computing. Each worker's outstanding job depths are kept
+//  in submit order, which is the order the worker returns results.
+//////////////////
+
+// Send a job and its solutes to a worker without waiting for delivery
+void US_MPI_Analysis::send_job( Sa_Job& job, int worker )
+{
+   if ( worker_sjobs.size() != gcores_count )
+   {
+      worker_sjobs.resize( gcores_count );
+      worker_sreqs.fill( MPI_REQUEST_NULL, gcores_count * 2 );
+   }
+
+   // The previous job sent to this worker must be delivered before its
+   //  buffers are reused. The worker has received it, since it only asks
+   //  for another job once it has.
+   MPI_Request* sreqs   = worker_sreqs.data() + worker * 2;
+   MPI_Waitall( 2, sreqs, MPI_STATUSES_IGNORE );
+
+   worker_sjobs[ worker ] = job;
+   Sa_Job* sjob         = &worker_sjobs[ worker ];
+
+   // Tell worker that solutes are coming
+   MPI_Isend( &sjob->mpi_job,
+              sizeof( MPI_Job ),
+              MPI_BYTE,
+              worker,      // Send to system that needs work
+              MPI_Job::MASTER,
+              my_communicator,
+              &sreqs[ 0 ] );
+
+   // Send solutes
+   MPI_Isend( sjob->solutes.data(),
+              sjob->mpi_job.length * solute_doubles,
+              MPI_DOUBLE,  // Pass solute vector as hw independent values
+              worker,      // to worker
+              MPI_Job::MASTER,
+              my_communicator,
+              &sreqs[ 1 ] );
+
+   job_sent( worker, job.mpi_job.depth );
+}
+
+// Complete all job sends before the workers are shut down
+void US_MPI_Analysis::complete_jobs( void )
+{
+   if ( worker_sreqs.size() > 0 )
+      MPI_Waitall( worker_sreqs.size(), worker_sreqs.data(),
+                   MPI_STATUSES_IGNORE );
+}
+
+// Record a job given to a worker
+void US_MPI_Analysis::job_sent( int worker, int depth )
+{
+   if ( worker_queued[ worker ].isEmpty() )
+   {  // An idle worker starts on the job now
+      worker_start[ worker ] = run_msecs( startTime );
+      worker_depth[ worker ] = depth;
+   }
+
+   else
+   {  // A busy worker holds results no deeper than its lowest job
+      worker_depth[ worker ] = qMin( worker_depth[ worker ], depth );
+DbgLv(1) << "Mast: job_sent: PREFETCH worker" << worker << "depth" << depth
+ << "queued" << worker_queued[ worker ];
+   }
+
+   worker_queued  [ worker ] << depth;
+   worker_prefetch[ worker ] = false;
+   worker_status  [ worker ] = WORKING;
+}
+
+// Record the results of a worker's oldest job and return the job depth
+int US_MPI_Analysis::job_returned( int worker )
+{
+   QList< int >* queued = &worker_queued[ worker ];
+   qint64        now    = run_msecs( startTime );
+   int           depth  = queued->isEmpty() ? worker_depth[ worker ]
+                                            : queued->takeFirst();
+   worker_busy [ worker ] += now - worker_start[ worker ];
+   worker_jobs [ worker ]++;
+   worker_start[ worker ]  = now;   // The next job, if any, starts now
+
+   if ( ! queued->isEmpty() )
+   {  // Still working on a prefetched job
+      int wdepth       = queued->at( 0 );
+
+      for ( int ii = 1; ii < queued->size(); ii++ )
+         wdepth           = qMin( wdepth, queued->at( ii ) );
+
+      worker_depth [ worker ] = wdepth;
+   }
+
+   else if ( worker_prefetch[ worker ] )
+   {  // Already asked for its next job
+      worker_prefetch[ worker ] = false;
+      worker_status  [ worker ] = READY;
+   }
+
+   else
+   {  // Its request for the next job is still to come
+      worker_status  [ worker ] = INIT;
+   }
+
+   return depth;
+}
+
+// Record a worker's request for a job
+void US_MPI_Analysis::worker_ready( int worker )
+{
+   if ( job_prefetch  &&  worker_status[ worker ] == WORKING )
+      worker_prefetch[ worker ] = true;   // Asking ahead of its results
+   else
+      worker_status  [ worker ] = READY;
+}
+
+// Find a busy worker that has asked for its next job
+int US_MPI_Analysis::prefetch_worker( void )
+{
+   if ( ! job_prefetch )
+      return -1;
+
+   for ( int ii = 1; ii <= my_workers; ii++ )
+   {
+      if ( worker_prefetch[ ii ]  &&  worker_status[ ii ] == WORKING )
+         return ii;
+   }
+
+   return -1;
+}
+
+//////////////////
+//  Worker:  job exchange
+//////////////////
+
+// Tell the master we are ready and start receiving the next job
+void US_MPI_Analysis::request_job( void )
+{
+   // Use 4 here because the master will be reading 4 with the
+   // same instruction when reading ::READY or ::RESULTS.
+   int x[ 4 ] = { 0, 0, 0, 0 };
+
+   MPI_Send( x, // Basically don't care
+             4,
+             MPI_INT,
+             MPI_Job::MASTER,
+             MPI_Job::READY,
+             my_communicator ); // let master know we are ready
+DbgLv(1) << "w:" << my_rank << ": ready sent";
+
+   MPI_Irecv( &next_job, // get masters' response
+              sizeof( MPI_Job ),
+              MPI_BYTE,
+              MPI_Job::MASTER,
+              MPI_Job::TAG0,
+              my_communicator,
+              &job_request );
+
+   job_requested  = true;
+}
+
+// Wait for the next job from the master, requesting it if not yet done
+void US_MPI_Analysis::wait_job( MPI_Job& job )
+{
+   if ( ! job_requested )
+      request_job();
+
+   qint64 start   = run_msecs( startTime );
+
+   MPI_Wait( &job_request, MPI_STATUS_IGNORE );
+
+   worker_waited += run_msecs( startTime ) - start;
+   job_requested  = false;
+   job            = next_job;
+}
+
+// Send job results to the master without waiting for their delivery
+void US_MPI_Analysis::send_results( const int* sizes, SIMULATION& sim,
+                                    int dataset_count )
+{
+   complete_sends();
+
+   // Hold the results until sent
+   for ( int ii = 0; ii < 4; ii++ )
+      sent_sizes[ ii ] = sizes[ ii ];
+
+   sent_values.solutes   = sim.solutes;
+   sent_values.variance  = sim.variance;
+   sent_values.variances = sim.variances;
+   sent_values.ti_noise  = sim.ti_noise;
+   sent_values.ri_noise  = sim.ri_noise;
+
+   // Tell master we are sending back results
+   MPI_Isend( sent_sizes,
+              4,
+              MPI_INT,
+              MPI_Job::MASTER,
+              MPI_Job::RESULTS,
+              my_communicator,
+              &sent_reqs[ 0 ] );
+
+   // Send back to master all of simulation_values
+   MPI_Isend( sent_values.solutes.data(),
+              sent_values.solutes.size() * solute_doubles,
+              MPI_DOUBLE,
+              MPI_Job::MASTER,
+              MPI_Job::TAG0,
+              my_communicator,
+              &sent_reqs[ 1 ] );
+
+   MPI_Isend( &sent_values.variance,
+              1,
+              MPI_DOUBLE,
+              MPI_Job::MASTER,
+              MPI_Job::TAG0,
+              my_communicator,
+              &sent_reqs[ 2 ] );
+
+   MPI_Isend( sent_values.variances.data(),
+              dataset_count,
+              MPI_DOUBLE,
+              MPI_Job::MASTER,
+              MPI_Job::TAG0,
+              my_communicator,
+              &sent_reqs[ 3 ] );
+
+   MPI_Isend( sent_values.ti_noise.data(),
+              sent_values.ti_noise.size(),
+              MPI_DOUBLE,
+              MPI_Job::MASTER,
+              MPI_Job::TAG0,
+              my_communicator,
+              &sent_reqs[ 4 ] );
+
+   MPI_Isend( sent_values.ri_noise.data(),
+              sent_values.ri_noise.size(),
+              MPI_DOUBLE,
+              MPI_Job::MASTER,
+              MPI_Job::TAG0,
+              my_communicator,
+              &sent_reqs[ 5 ] );
+}
+
+// Wait for the delivery of the last results sent
+void US_MPI_Analysis::complete_sends( void )
+{
+   qint64 start   = run_msecs( startTime );
+
+   MPI_Waitall( 6, sent_reqs, MPI_STATUSES_IGNORE );
+
+   worker_waited += run_msecs( startTime ) - start;
+}
+
+// Collect in the master the seconds each process waited on the master
+//  and the seconds its compute threads were busy
+void US_MPI_Analysis::gather_stats( void )
+{
+   double wait    = worker_waited / 1000.0;
+
+   worker_wait.fill( 0.0, ( my_rank == 0 ) ? proc_count : 1 );
+
+   MPI_Gather( &wait,
+               1,
+               MPI_DOUBLE,
+               worker_wait.data(),
+               1,
+               MPI_DOUBLE,
+               MPI_Job::MASTER,
+               MPI_COMM_WORLD );
+
+   if ( compute_threads > 1 )
+   {
+      QVector< double > tbusy( compute_threads, 0.0 );
+
+      for ( int tt = 0; tt < res_threads.size(); tt++ )
+         tbusy[ tt ]    = res_threads[ tt ]->busy_ms / 1000.0;
+
+      if ( res_threads.size() > 0 )
+      {
+         DbgLv(0) << "w:" << my_rank << ": Threads busy seconds" << tbusy;
+      }
+
+      worker_tbusy.fill( 0.0, ( my_rank == 0 )
+                              ? proc_count * compute_threads : 1 );
+
+      MPI_Gather( tbusy.data(),
+                  compute_threads,
+                  MPI_DOUBLE,
+                  worker_tbusy.data(),
+                  compute_threads,
+                  MPI_DOUBLE,
+                  MPI_Job::MASTER,
+                  MPI_COMM_WORLD );
+   }
+
+   end_threads();
+
+   if ( my_rank != 0  ||  proc_count < 2 )
+      return;
+
+   double waitmin = 1.0e+99;
+   double waitmax = 0.0;
+   double waitsum = 0.0;
+
+   for ( int ii = 1; ii < proc_count; ii++ )
+   {
+      waitmin        = qMin( waitmin, worker_wait[ ii ] );
+      waitmax        = qMax( waitmax, worker_wait[ ii ] );
+      waitsum       += worker_wait[ ii ];
+   }
+
+   DbgLv(0) << "Workers wait seconds:  min" << waitmin << "max" << waitmax
+            << "avg" << waitsum / (double)( proc_count - 1 );
+}
@@ -0,0 +1,172 @@
+#include "us_mpi_analysis.h"
+
+//////////////////
+//  Island migration
+//
+//  With migrate_topology set, GA and DMGA workers (demes) pass emigrants
+//  directly to neighbor demes instead of through the master:  to the next
+//  deme in a ring (1) or to a random other deme (2). Sends do not wait for
+//  delivery and a deme takes whatever immigrants have arrived, so no deme
+//  waits for another during the generations. Peer messages use their own
+//  communicator so they never match receives from the master. It is
+//  set up for single master runs only; parallel-masters groups keep the
+//  master exchange.
+//////////////////
+
+// Set up peer migration for the current run (all processes)
+void US_MPI_Analysis::migrate_setup( void )
+{
+   if ( migrate_topology == 0 )
+      return;
+
+   if ( my_workers < 2  ||  migrate_count < 1 )
+   {  // No neighbors or no migration
+      migrate_topology = 0;
+      return;
+   }
+
+   MPI_Comm_dup( my_communicator, &migrate_comm );
+
+   if ( my_rank == 0 )
+   {
+      DbgLv(0) << "Island migration:"
+               << ( ( migrate_topology == 1 ) ? "ring" : "random" )
+               << "of" << my_workers << "demes";
+   }
+}
+
+// Free the peer migration communicator at the end of the run
+void US_MPI_Analysis::migrate_free( void )
+{
+   if ( migrate_comm != MPI_COMM_NULL )
+      MPI_Comm_free( &migrate_comm );
+}
+
+// Send emigrants to a neighbor deme and take the newest immigrants that
+//  have arrived. Returns the number of immigrant doubles received (0 if
+//  none have arrived).
+int US_MPI_Analysis::migrate_peers( const double* emigrants,
+                                    double* immigrants, int doubles_count )
+{
+   // Release the buffers of delivered emigrants
+   for ( int ii = migrate_reqs.size() - 1; ii >= 0; ii-- )
+   {
+      int done       = 0;
+      MPI_Test( &migrate_reqs[ ii ], &done, MPI_STATUS_IGNORE );
+
+      if ( done )
+      {
+         migrate_reqs.removeAt( ii );
+         migrate_bufs.removeAt( ii );
+      }
+   }
+
+   // Next deme in the ring, or any other deme
+   int offset     = ( migrate_topology == 1 ) ? 0
+                                              : u_random( my_workers - 1 );
+   int dest       = ( group_rank + offset ) % my_workers + 1;
+
+   migrate_bufs << QVector< double >( doubles_count );
+   migrate_reqs << MPI_REQUEST_NULL;
+   QVector< double >* sbuf = &migrate_bufs.last();
+
+   for ( int ii = 0; ii < doubles_count; ii++ )
+      (*sbuf)[ ii ] = emigrants[ ii ];
+
+   MPI_Isend( sbuf->data(),
+              doubles_count,
+              MPI_DOUBLE,
+              dest,
+              EMMIGRATE,
+              migrate_comm,
+              &migrate_reqs.last() );
+
+   // Receive all arrived emigrants of other demes. Each set overwrites
+   //  the one before, so the newest is kept.
+   int received   = 0;
+   int arrived    = 0;
+   MPI_Status status;
+
+   MPI_Iprobe( MPI_ANY_SOURCE, EMMIGRATE, migrate_comm, &arrived, &status );
+
+   while ( arrived )
+   {
+      MPI_Recv( immigrants,
+                doubles_count,
+                MPI_DOUBLE,
+                status.MPI_SOURCE,
+                EMMIGRATE,
+                migrate_comm,
+                &status );
+
+      MPI_Get_count( &status, MPI_DOUBLE, &received );
+
+      MPI_Iprobe( MPI_ANY_SOURCE, EMMIGRATE, migrate_comm, &arrived, &status );
+   }
+
+DbgLv(1) << "MG:Deme" << group_rank << ": sent to" << dest << "pending"
+ << migrate_reqs.size() << "received" << received;
+   return received;
+}
+
+// End the migration of an iteration:  receive and discard the emigrants
+//  still on their way to this deme, then wait for this deme's own sends.
+//  No send is cancelled; each completes because its receiving deme drains
+//  its messages here too, so the next iteration starts with none pending.
+void US_MPI_Analysis::migrate_finish( void )
+{
+   if ( migrate_comm == MPI_COMM_NULL )
+      return;
+
+   // Tell the demes that may send to this one that this one is done
+   int nsrcs      = ( migrate_topology == 1 ) ? 1 : my_workers - 1;
+   QVector< MPI_Request > ereqs( nsrcs, MPI_REQUEST_NULL );
+
+   for ( int ii = 0; ii < nsrcs; ii++ )
+   {
+      int dest       = ( group_rank + ii ) % my_workers + 1;
+
+      MPI_Isend( NULL,
+                 0,
+                 MPI_DOUBLE,
+                 dest,
+                 FINISHED,
+                 migrate_comm,
+                 &ereqs[ ii ] );
+   }
+
+   // Messages from a deme arrive in order, so all of its emigrants are
+   //  received once its FINISHED is
+   int nfins      = 0;
+
+   while ( nfins < nsrcs )
+   {
+      MPI_Status status;
+      int        count;
+
+      MPI_Probe( MPI_ANY_SOURCE, MPI_ANY_TAG, migrate_comm, &status );
+      MPI_Get_count( &status, MPI_DOUBLE, &count );
+
+      QVector< double > discard( qMax( count, 1 ) );
+
+      MPI_Recv( discard.data(),
+                count,
+                MPI_DOUBLE,
+                status.MPI_SOURCE,
+                status.MPI_TAG,
+                migrate_comm,
+                MPI_STATUS_IGNORE );
+
+      if ( status.MPI_TAG == FINISHED )
+         nfins++;
+   }
+
+   // Wait for the FINISHED and emigrant sends of this deme to complete
+   MPI_Waitall( ereqs.size(), ereqs.data(), MPI_STATUSES_IGNORE );
+
+   for ( int ii = 0; ii < migrate_reqs.size(); ii++ )
+      MPI_Wait( &migrate_reqs[ ii ], MPI_STATUS_IGNORE );
+
+   migrate_reqs.clear();
+   migrate_bufs.clear();
+}
@@ -341,6 +341,12 @@ void US_MPI_Analysis::parse_dataset( QXmlStreamReader& xml, DATASET* dataset )
                               a.value( "value" ).toString().toInt();
       }
 
+      if ( xml.name() == "time_tolerance" )
+      {
+         dataset->simparams.dt_tolerance =
+                              a.value( "value" ).toString().toDouble();
+      }
+
       if ( xml.name() == "density" )
       {
          dataset->density     = a.value( "value" ).toString().toDouble();
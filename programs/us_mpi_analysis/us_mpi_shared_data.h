@@ -0,0 +1,39 @@
+//! \file us_mpi_shared_data.h
+#ifndef US_MPI_SHARED_DATA_H
+#define US_MPI_SHARED_DATA_H
+
+#include "us_dataIO.h"
+
+//! \brief Point edited data at readings in memory shared by the workers
+//!  of a node
+//!
+//! An attached data set releases the readings of its scans and reads them
+//! through EditedData::value() from the shared array. Copying the data set,
+//! or changing a reading with setValue(), gives the copy or the data set its
+//! own readings again. Only us_mpi_analysis attaches data this way.
+//!
+class US_MPI_SharedData
+{
+   public:
+      //! \brief Read the readings of a data set from a shared array
+      //!
+      //! \param edata  Edited data, whose scans' readings are released
+      //! \param values Scan-major readings (scans x points)
+      static void attach( US_DataIO::EditedData& edata, const double* values )
+      {
+         for ( int ss = 0; ss < edata.scanData.size(); ss++ )
+            edata.scanData[ ss ].rvalues = QVector< double >();
+
+         edata.shared_values  = values;
+      }
+
+      //! \brief Stop reading a shared array that is about to be freed,
+      //!  leaving the data set without readings
+      //!
+      //! \param edata  Edited data attached to a shared array
+      static void release( US_DataIO::EditedData& edata )
+      {
+         edata.shared_values  = NULL;
+      }
+};
+#endif
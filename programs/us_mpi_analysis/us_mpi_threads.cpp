@@ -0,0 +1,113 @@
+#include "us_mpi_analysis.h"
+
+//////////////////
+//  Hybrid MPI + threads mode
+//
+//  With compute_threads above 1, a worker rank computes several 2DSA jobs
+//  or GA fitness simulations at once in threads sharing its (read-only)
+//  experiment data. Only the main thread makes MPI calls.
+//////////////////
+
+// Residuals thread constructor
+US_MPI_Analysis::ResidThread::ResidThread( US_MPI_Analysis* analysis )
+   : QThread(), analysis( analysis )
+{
+   sims          = NULL;
+   next          = &own_next;
+   nsims         = 0;
+   offset        = 0;
+   dataset_count = 1;
+   busy_ms       = 0;
+}
+
+// Define the work of a residuals thread:  the simulations of a list to
+//  compute, taken in turn with other threads given the same next index
+void US_MPI_Analysis::ResidThread::set_work( int offs, int dscount,
+      SIMULATION* simvals, int nsimvals, QAtomicInt* nextx )
+{
+   offset        = offs;
+   dataset_count = dscount;
+   sims          = simvals;
+   nsims         = nsimvals;
+   next          = ( nextx != 0 ) ? nextx : &own_next;
+
+   if ( nextx == 0 )
+      own_next.fetchAndStoreOrdered( 0 );
+}
+
+// Run a residuals thread:  compute simulations until none are left
+void US_MPI_Analysis::ResidThread::run( void )
+{
+   QDateTime start  = QDateTime::currentDateTime();
+   int       simx   = next->fetchAndAddOrdered( 1 );
+
+   while ( simx < nsims )
+   {
+      analysis->thread_residuals( offset, dataset_count, sims[ simx ] );
+
+      simx          = next->fetchAndAddOrdered( 1 );
+   }
+
+   busy_ms      += start.msecsTo( QDateTime::currentDateTime() );
+}
+
+// Create the compute threads of a worker
+void US_MPI_Analysis::init_threads( void )
+{
+   while ( res_threads.size() < compute_threads )
+      res_threads << new ResidThread( this );
+}
+
+// Calculate residuals in a compute thread. Unlike calc_residuals(),
+//  no analysis object state is changed.
+void US_MPI_Analysis::thread_residuals( int offset, int dataset_count,
+                                        SIMULATION& simu_values )
+{
+   US_SolveSim solvesim( data_sets, my_rank, false );
+
+   simu_values.nnls_mode = nnls_mode;
+   simu_values.nthreads  = 1;
+
+   solvesim.calc_residuals( offset, dataset_count, simu_values );
+}
+
+// Compute a list of simulations with all compute threads
+void US_MPI_Analysis::run_threads( int offset, int dataset_count,
+                                   QVector< SIMULATION >& sims )
+{
+   init_threads();
+
+   QAtomicInt next( 0 );
+
+   for ( int tt = 0; tt < res_threads.size(); tt++ )
+   {
+      res_threads[ tt ]->set_work( offset, dataset_count,
+                                   sims.data(), sims.size(), &next );
+      res_threads[ tt ]->start();
+   }
+
+   for ( int tt = 0; tt < res_threads.size(); tt++ )
+      res_threads[ tt ]->wait();
+}
+
+// Wait briefly for any running compute thread to finish
+void US_MPI_Analysis::wait_threads( void )
+{
+   for ( int tt = 0; tt < res_threads.size(); tt++ )
+   {
+      if ( res_threads[ tt ]->isRunning()  &&  res_threads[ tt ]->wait( 2 ) )
+         break;
+   }
+}
+
+// Delete the compute threads of a worker
+void US_MPI_Analysis::end_threads( void )
+{
+   for ( int tt = 0; tt < res_threads.size(); tt++ )
+   {
+      res_threads[ tt ]->wait();
+      delete res_threads[ tt ];
+   }
+
+   res_threads.clear();
+}
@@ -642,6 +642,10 @@ void US_pcsaProcess::submit_job( WorkPacketPc& wtask, int thrx )
    wkstates[ thrx ]   = WORKING;
    wtask.sim_vals.maxrss = maxrss;
 
+   // With no more queued tasks, let this task simulate using idle threads
+   wtask.sim_vals.nthreads = job_queue.isEmpty()
+                           ? ( wkstates.count( READY ) + 1 ) : 1;
+
    wthr->define_work( wtask );
 
    connect( wthr, SIGNAL( work_complete( WorkerThreadPc* ) ),
@@ -2151,7 +2155,8 @@ double US_pcsaProcess::evaluate_model( QList< US_SolveSim::DataSet* >& dsets,
       spar->mesh_radius << sim_vals.zsolutes[ ii ].y;
    }
 
-   // Do astfem fit, mostly to get an RMSD
+   // Do astfem fit, mostly to get an RMSD (with L-M, no workers are busy)
+   sim_vals.nthreads     = qMax( 1, QThread::idealThreadCount() );
    US_SolveSim* solvesim = new US_SolveSim( dsets, 0, false );
    solvesim->calc_residuals( 0, 1, sim_vals );
 
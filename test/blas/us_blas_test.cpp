@@ -0,0 +1,336 @@
+//! \file us_blas_test.cpp
+//!
+//! Checks the matrix kernels that have an optional BLAS/LAPACK backend
+//! (US_BLAS). US_Matrix kernels take the backend only for matrices with
+//! contiguous rows, so each is run on contiguous and on padded-row copies
+//! of the same matrices and the results compared. The QR factorization of
+//! US_LM, converted from LAPACK to MINPACK form when built with US_BLAS, is
+//! checked by rebuilding A*P from its factors, and by a curve fit of known
+//! solution. Exits non-zero if any check fails.
+
+#include <QtCore>
+#include <math.h>
+
+#include "us_matrix.h"
+#include "us_lm.h"
+
+static int nfail   = 0;      // Count of failed checks
+
+// Report a check and count any failure
+static void check( bool ok, const char* name, double value )
+{
+   qDebug() << ( ok ? "PASS" : "FAIL" ) << name << value;
+
+   if ( ! ok )
+      nfail++;
+}
+
+// Repeatable pseudo-random value in [0,1)
+static double urand( void )
+{
+   static quint32 seed = 54321;
+   seed           = seed * 1103515245 + 12345;
+   return (double)( ( seed >> 8 ) & 0xffffff ) / 16777216.0;
+}
+
+// Matrix with rows padded apart, which the BLAS path never takes
+static double** padded( QVector< double* >& vm, QVector< double >& vd,
+                        int rows, int columns )
+{
+   vd.fill( 0.0, rows * ( columns + 1 ) );
+   vm.resize( rows );
+
+   for ( int ii = 0; ii < rows; ii++ )
+      vm[ ii ]       = vd.data() + ii * ( columns + 1 );
+
+   return vm.data();
+}
+
+// Fill two matrices with the same random values
+static void fill_random( double** aa, double** bb, int rows, int columns )
+{
+   for ( int ii = 0; ii < rows; ii++ )
+      for ( int jj = 0; jj < columns; jj++ )
+         aa[ ii ][ jj ] = bb[ ii ][ jj ] = urand() - 0.5;
+}
+
+// Largest difference of two matrices, relative to the largest value
+static double rel_diff( double** aa, double** bb, int rows, int columns )
+{
+   double dmax    = 0.0;
+   double amax    = 0.0;
+
+   for ( int ii = 0; ii < rows; ii++ )
+   {
+      for ( int jj = 0; jj < columns; jj++ )
+      {
+         double diff    = qAbs( aa[ ii ][ jj ] - bb[ ii ][ jj ] );
+         dmax           = qMax( dmax, diff );
+         amax           = qMax( amax, qAbs( aa[ ii ][ jj ] ) );
+      }
+   }
+
+   return ( amax > 0.0 ) ? ( dmax / amax ) : dmax;
+}
+
+// Largest difference of two vectors, relative to the largest value
+static double rel_diff( double* aa, double* bb, int size )
+{
+   return rel_diff( &aa, &bb, 1, size );
+}
+
+// Matrix products:  A'A (tmm) and A*B (mmm)
+static void test_products( void )
+{
+   int    rows    = 200;
+   int    size    = 30;
+   int    columns = 25;
+   QVector< double* > vm[ 6 ];
+   QVector< double >  vd[ 6 ];
+   double** AAc   = US_Matrix::construct( vm[ 0 ], vd[ 0 ], rows, size );
+   double** AAp   = padded( vm[ 1 ], vd[ 1 ], rows, size );
+   double** BBc   = US_Matrix::construct( vm[ 2 ], vd[ 2 ], size, columns );
+   double** BBp   = padded( vm[ 3 ], vd[ 3 ], size, columns );
+   double** CCc   = US_Matrix::construct( vm[ 4 ], vd[ 4 ], rows, columns );
+   double** CCp   = padded( vm[ 5 ], vd[ 5 ], rows, columns );
+   QVector< double* > vmt[ 2 ];
+   QVector< double >  vdt[ 2 ];
+   double** TTc   = US_Matrix::construct( vmt[ 0 ], vdt[ 0 ], size, size );
+   double** TTp   = padded( vmt[ 1 ], vdt[ 1 ], size, size );
+
+   fill_random( AAc, AAp, rows, size );
+   fill_random( BBc, BBp, size, columns );
+
+   US_Matrix::tmm( AAc, TTc, rows, size, true );
+   US_Matrix::tmm( AAp, TTp, rows, size, true );
+   check( rel_diff( TTc, TTp, size, size ) < 1e-12, "tmm: relative diff",
+          rel_diff( TTc, TTp, size, size ) );
+
+   US_Matrix::mmm( AAc, BBc, CCc, rows, size, columns );
+   US_Matrix::mmm( AAp, BBp, CCp, rows, size, columns );
+   check( rel_diff( CCc, CCp, rows, columns ) < 1e-12, "mmm: relative diff",
+          rel_diff( CCc, CCp, rows, columns ) );
+}
+
+// Cholesky factorization and solution of a positive definite system
+static void test_cholesky( void )
+{
+   int    nn      = 40;
+   int    rows    = 100;
+   QVector< double* > vm[ 6 ];
+   QVector< double >  vd[ 6 ];
+   double** AAc   = US_Matrix::construct( vm[ 0 ], vd[ 0 ], rows, nn );
+   double** AAp   = padded( vm[ 1 ], vd[ 1 ], rows, nn );
+   double** MMc   = US_Matrix::construct( vm[ 2 ], vd[ 2 ], nn, nn );
+   double** MMp   = padded( vm[ 3 ], vd[ 3 ], nn, nn );
+   double** MM0   = padded( vm[ 4 ], vd[ 4 ], nn, nn );
+   QVector< double > bc( nn );
+   QVector< double > bp( nn );
+   QVector< double > b0( nn );
+
+   fill_random( AAc, AAp, rows, nn );
+   US_Matrix::tmm( AAp, MMp, rows, nn, true );
+   US_Matrix::add_diag( MMp, 1.0, nn );
+
+   for ( int ii = 0; ii < nn; ii++ )
+   {
+      for ( int jj = 0; jj < nn; jj++ )
+         MMc[ ii ][ jj ] = MM0[ ii ][ jj ] = MMp[ ii ][ jj ];
+
+      bc[ ii ]       = bp[ ii ] = b0[ ii ] = urand();
+   }
+
+   bool okc       = US_Matrix::Cholesky_Decomposition( MMc, nn );
+   bool okp       = US_Matrix::Cholesky_Decomposition( MMp, nn );
+   check( okc  &&  okp, "Cholesky: factored", okc + okp );
+   check( rel_diff( MMc, MMp, nn, nn ) < 1e-12, "Cholesky: L relative diff",
+          rel_diff( MMc, MMp, nn, nn ) );
+
+   US_Matrix::Cholesky_SolveSystem( MMc, bc.data(), nn );
+   US_Matrix::Cholesky_SolveSystem( MMp, bp.data(), nn );
+   check( rel_diff( bc.data(), bp.data(), nn ) < 1e-12,
+          "Cholesky: x relative diff", rel_diff( bc.data(), bp.data(), nn ) );
+
+   // The solution satisfies the original system
+   double rmax    = 0.0;
+
+   for ( int ii = 0; ii < nn; ii++ )
+   {
+      double sum     = -b0[ ii ];
+
+      for ( int jj = 0; jj < nn; jj++ )
+         sum           += MM0[ ii ][ jj ] * bc[ jj ];
+
+      rmax           = qMax( rmax, qAbs( sum ) );
+   }
+
+   check( rmax < 1e-10, "Cholesky: max |Mx-b|", rmax );
+}
+
+// LU factorization and solution of a general system
+static void test_lu( void )
+{
+   int    nn      = 30;
+   QVector< double* > vm[ 3 ];
+   QVector< double >  vd[ 3 ];
+   double** MMc   = US_Matrix::construct( vm[ 0 ], vd[ 0 ], nn, nn );
+   double** MMp   = padded( vm[ 1 ], vd[ 1 ], nn, nn );
+   double** MM0   = padded( vm[ 2 ], vd[ 2 ], nn, nn );
+   QVector< double > bcv( nn );
+   QVector< double > bpv( nn );
+   QVector< double > b0( nn );
+   QVector< int >    ixc( nn );
+   QVector< int >    ixp( nn );
+
+   fill_random( MMc, MMp, nn, nn );
+
+   for ( int ii = 0; ii < nn; ii++ )
+   {
+      MMc[ ii ][ ii ] += 2.0;
+      MMp[ ii ][ ii ] += 2.0;
+
+      for ( int jj = 0; jj < nn; jj++ )
+         MM0[ ii ][ jj ] = MMp[ ii ][ jj ];
+
+      bcv[ ii ]      = bpv[ ii ] = b0[ ii ] = urand();
+   }
+
+   double* bc     = bcv.data();
+   double* bp     = bpv.data();
+   US_Matrix::LU_Decomposition( MMc, ixc.data(), false, nn );
+   US_Matrix::LU_Decomposition( MMp, ixp.data(), false, nn );
+   US_Matrix::LU_BackSubstitute( MMc, bc, ixc.data(), nn );
+   US_Matrix::LU_BackSubstitute( MMp, bp, ixp.data(), nn );
+
+   check( rel_diff( bc, bp, nn ) < 1e-10, "LU: x relative diff",
+          rel_diff( bc, bp, nn ) );
+
+   double rmax    = 0.0;
+
+   for ( int ii = 0; ii < nn; ii++ )
+   {
+      double sum     = -b0[ ii ];
+
+      for ( int jj = 0; jj < nn; jj++ )
+         sum           += MM0[ ii ][ jj ] * bc[ jj ];
+
+      rmax           = qMax( rmax, qAbs( sum ) );
+   }
+
+   check( rmax < 1e-10, "LU: max |Mx-b|", rmax );
+}
+
+// QR factorization in MINPACK form:  rebuild A*P as Q*R, where
+//  Q = H(0)...H(k-1), H(j) = I - u*u'/u(j), u stored below the diagonal
+static void test_qrfac( int pivot )
+{
+   int    mm      = 60;
+   int    nn      = 8;
+   QVector< double > a0( mm * nn );
+   QVector< double > aa;
+   QVector< double > rdiag( nn );
+   QVector< double > acnorm( nn );
+   QVector< double > wa( nn );
+   QVector< double > vv( mm );
+   QVector< int >    ipvt( nn );
+
+   for ( int ii = 0; ii < mm * nn; ii++ )
+      a0[ ii ]       = urand() - 0.5;
+
+   aa             = a0;
+   US_LM::lm_qrfac( mm, nn, aa.data(), pivot, ipvt.data(), rdiag.data(),
+                    acnorm.data(), wa.data() );
+
+   double dmax    = 0.0;
+   QVector< int > used( nn, 0 );
+
+   for ( int kk = 0; kk < nn; kk++ )
+   {
+      int    kc      = pivot ? ipvt[ kk ] : kk;
+
+      if ( kc < 0  ||  kc >= nn  ||  used[ kc ]++ > 0 )
+      {
+         check( false, "qrfac: ipvt permutation", kc );
+         return;
+      }
+
+      // Column kk of R
+      for ( int ii = 0; ii < mm; ii++ )
+         vv[ ii ]       = ( ii < kk ) ? aa[ kk * mm + ii ]
+                        : ( ( ii == kk ) ? rdiag[ kk ] : 0.0 );
+
+      // Apply H(j) for j = k-1, ..., 0
+      for ( int jj = qMin( mm, nn ) - 1; jj >= 0; jj-- )
+      {
+         const double* uu = aa.constData() + jj * mm;
+
+         if ( uu[ jj ] == 0.0 )
+            continue;
+
+         double sum     = 0.0;
+
+         for ( int ii = jj; ii < mm; ii++ )
+            sum           += uu[ ii ] * vv[ ii ];
+
+         sum           /= uu[ jj ];
+
+         for ( int ii = jj; ii < mm; ii++ )
+            vv[ ii ]      -= sum * uu[ ii ];
+      }
+
+      for ( int ii = 0; ii < mm; ii++ )
+         dmax           = qMax( dmax, qAbs( vv[ ii ] - a0[ kc * mm + ii ] ) );
+   }
+
+   check( dmax < 1e-12, pivot ? "qrfac (pivot): max |QR-AP|"
+                              : "qrfac: max |QR-A|", dmax );
+}
+
+// Model for the curve fit:  p0 * exp( -p1 * t ) + p2
+static double decay( double t, double* par )
+{
+   return par[ 0 ] * exp( -par[ 1 ] * t ) + par[ 2 ];
+}
+
+// Levenberg-Marquardt fit of data of a known model
+static void test_lmfit( void )
+{
+   int    ndat    = 50;
+   double par[ 3 ] = { 1.0, 1.0, 0.0 };
+   double ptrue[ 3 ] = { 3.0, 0.5, 1.0 };
+   QVector< double > tt( ndat );
+   QVector< double > yy( ndat );
+
+   for ( int ii = 0; ii < ndat; ii++ )
+   {
+      tt[ ii ]       = (double)ii * 0.2;
+      yy[ ii ]       = decay( tt[ ii ], ptrue );
+   }
+
+   US_LM::LM_Control control;
+   US_LM::LM_Status  status;
+
+   US_LM::lmcurve_fit( 3, par, ndat, tt.data(), yy.data(), decay,
+                       &control, &status );
+
+   double dmax    = 0.0;
+
+   for ( int jj = 0; jj < 3; jj++ )
+      dmax           = qMax( dmax, qAbs( par[ jj ] - ptrue[ jj ] ) );
+
+   check( dmax < 1e-6, "lmcurve_fit: max |p-ptrue|", dmax );
+}
+
+int main( void )
+{
+   test_products();
+   test_cholesky();
+   test_lu();
+   test_lmfit();     // the fit also sets the norm function lm_qrfac uses
+   test_qrfac( 0 );
+   test_qrfac( 1 );
+
+   qDebug() << ( nfail == 0 ? "All BLAS tests passed" : "BLAS tests FAILED:" )
+            << nfail;
+   return ( nfail == 0 ) ? 0 : 1;
+}
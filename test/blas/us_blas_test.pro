@@ -0,0 +1,24 @@
+# Test of the BLAS/LAPACK and hand-written matrix kernels (console program)
+include( ../../local.pri )
+
+CONFIG      += $${DEBUGORRELEASE} qt thread warn console
+TEMPLATE     = app
+QT          -= gui
+DEFINES     += LINUX
+
+TARGET       = us_blas_test
+DESTDIR      = .
+
+MOC_DIR      = ./moc
+OBJECTS_DIR  = ./obj
+
+SOURCES      = us_blas_test.cpp
+
+INCLUDEPATH  += ../../utils
+DEPENDPATH   += ../../utils
+LIBS         += -lus_utils -L../../lib
+
+# Run with the library built without US_BLAS and again with it (see
+#  local.pri).  Each check compares a kernel on contiguous matrices, which
+#  take the BLAS/LAPACK path when it is built in, with the same kernel on
+#  matrices of padded rows, which always take the hand-written path.
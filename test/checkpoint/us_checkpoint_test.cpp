@@ -0,0 +1,227 @@
+//! \file us_checkpoint_test.cpp
+//!
+//! Checks the Monte Carlo checkpoint file of us_mpi_analysis
+//! (US_Checkpoint):  a written checkpoint reads back unchanged, the header
+//! alone can be read, run identities tell runs apart, and damaged or
+//! foreign files are rejected. Exits non-zero if any check fails.
+
+#include <QtCore>
+
+#include "us_checkpoint.h"
+
+static int nfail   = 0;      // Count of failed checks
+
+// Report a check and count any failure
+static void check( bool ok, const char* name, double value )
+{
+   qDebug() << ( ok ? "PASS" : "FAIL" ) << name << value;
+
+   if ( ! ok )
+      nfail++;
+}
+
+// Fill raw data with a small grid of distinct values
+static void fill_rawdata( US_DataIO::RawData& rdata, int nscans, int npoints,
+                          double base )
+{
+   rdata.xvalues.resize( npoints );
+   rdata.scanData.resize( nscans );
+
+   for ( int rr = 0; rr < npoints; rr++ )
+      rdata.xvalues[ rr ] = 5.9 + rr * 0.01;
+
+   for ( int ss = 0; ss < nscans; ss++ )
+   {
+      US_DataIO::Scan* scan = &rdata.scanData[ ss ];
+      scan->temperature = 20.0 + ss * 0.01;
+      scan->rpm         = 50000.0;
+      scan->seconds     = 600.0 + ss * 300.0;
+      scan->omega2t     = scan->seconds * 2.74e7;
+      scan->rvalues.resize( npoints );
+
+      for ( int rr = 0; rr < npoints; rr++ )
+         scan->rvalues[ rr ] = base + ss + rr * 1.0e-3;
+   }
+}
+
+// Test if the parts of raw data kept in a checkpoint are equal
+static bool same_rawdata( US_DataIO::RawData& rdata1,
+                          US_DataIO::RawData& rdata2 )
+{
+   if ( rdata1.xvalues != rdata2.xvalues  ||
+        rdata1.scanData.size() != rdata2.scanData.size() )
+      return false;
+
+   for ( int ss = 0; ss < rdata1.scanData.size(); ss++ )
+   {
+      US_DataIO::Scan* scan1 = &rdata1.scanData[ ss ];
+      US_DataIO::Scan* scan2 = &rdata2.scanData[ ss ];
+
+      if ( scan1->temperature != scan2->temperature  ||
+           scan1->rpm         != scan2->rpm          ||
+           scan1->seconds     != scan2->seconds      ||
+           scan1->omega2t     != scan2->omega2t      ||
+           scan1->rvalues     != scan2->rvalues )
+         return false;
+   }
+
+   return true;
+}
+
+// Compose the checkpoint of a run part way through its MC iterations
+static void make_checkpoint( US_Checkpoint& ckpt,
+                             QMap< QString, QString >& params )
+{
+   QDateTime stime( QDate( 2024, 3, 1 ), QTime( 12, 30, 0 ) );
+   params[ "mc_iterations" ] = "50";
+   params[ "s_min" ]         = "1";
+   params[ "s_max" ]         = "10";
+
+   ckpt.analysis_type       = "2DSA-MC";
+   ckpt.requestID           = "1234";
+   ckpt.count_datasets      = 1;
+   ckpt.total_points        = 3000;
+   ckpt.mc_iterations       = 50;
+   ckpt.identity            = US_Checkpoint::run_identity( stime, params );
+
+   ckpt.mc_iteration        = 12;
+   ckpt.current_dataset     = 0;
+   ckpt.datasets_to_process = 1;
+   ckpt.meniscus_run        = 0;
+   ckpt.mc_seed             = 0x9e3779b9U;
+   ckpt.analysisDate        = "240301123000";
+   ckpt.modelGUID           = "00000000-1111-2222-3333-444444444444";
+   ckpt.afsize              = 4321;
+
+   ckpt.sigmas.clear();
+
+   for ( int ii = 0; ii < 100; ii++ )
+      ckpt.sigmas << 0.01 + ii * 1.0e-5;
+
+   fill_rawdata( ckpt.sim_data1,   5, 40, 0.1 );
+   fill_rawdata( ckpt.scaled_data, 5, 40, 0.2 );
+}
+
+// A written checkpoint reads back unchanged, in whole or header only
+static void test_round_trip( const QString& fname )
+{
+   US_Checkpoint ckpt;
+   US_Checkpoint ckin;
+   US_Checkpoint ckhdr;
+   QMap< QString, QString > params;
+
+   make_checkpoint( ckpt, params );
+
+   check( ckpt.write( fname ), "write checkpoint", 0 );
+   check( ! QFile::exists( fname + ".tmp" ), "no temporary file left", 0 );
+   check( ckin.read( fname, true ), "read checkpoint", 0 );
+
+   bool same      = ckin.same_run( ckpt )                          &&
+                    ckin.mc_iteration        == ckpt.mc_iteration        &&
+                    ckin.current_dataset     == ckpt.current_dataset     &&
+                    ckin.datasets_to_process == ckpt.datasets_to_process &&
+                    ckin.meniscus_run        == ckpt.meniscus_run        &&
+                    ckin.mc_seed             == ckpt.mc_seed             &&
+                    ckin.analysisDate        == ckpt.analysisDate        &&
+                    ckin.modelGUID           == ckpt.modelGUID           &&
+                    ckin.afsize              == ckpt.afsize              &&
+                    ckin.sigmas              == ckpt.sigmas;
+   check( same, "round trip: header and state", ckin.mc_iteration );
+   check( same_rawdata( ckin.sim_data1,   ckpt.sim_data1 )  &&
+          same_rawdata( ckin.scaled_data, ckpt.scaled_data ),
+          "round trip: simulation and scaled data",
+          ckin.scaled_data.scanData.size() );
+
+   // The header and scalar state alone, as read to validate a restart
+   bool read      = ckhdr.read( fname, false );
+   check( read  &&  ckhdr.same_run( ckpt )  &&
+          ckhdr.mc_iteration == ckpt.mc_iteration  &&
+          ckhdr.sigmas.isEmpty()  &&  ckhdr.sim_data1.scanData.isEmpty(),
+          "header only read", ckhdr.mc_iteration );
+
+   // A later checkpoint replaces the earlier one
+   ckpt.mc_iteration        = 13;
+   check( ckpt.write( fname )  &&  ckhdr.read( fname, false )  &&
+          ckhdr.mc_iteration == 13, "rewrite replaces checkpoint", 13 );
+}
+
+// Run identities differ with the run submit time and parameters, but not
+//  with parameters whose value is empty
+static void test_identity( void )
+{
+   US_Checkpoint ckpt1;
+   US_Checkpoint ckpt2;
+   QMap< QString, QString > params1;
+   QMap< QString, QString > params2;
+   QDateTime stime( QDate( 2024, 3, 1 ), QTime( 12, 30, 0 ) );
+
+   make_checkpoint( ckpt1, params1 );
+   make_checkpoint( ckpt2, params2 );
+   check( ckpt1.same_run( ckpt2 ), "same run identity", 0 );
+
+   params2[ "debug_level" ] = "";
+   check( US_Checkpoint::run_identity( stime, params1 ) ==
+          US_Checkpoint::run_identity( stime, params2 ),
+          "empty parameter ignored", 0 );
+
+   params2[ "s_max" ]       = "12";
+   check( US_Checkpoint::run_identity( stime, params1 ) !=
+          US_Checkpoint::run_identity( stime, params2 ),
+          "changed parameter differs", 0 );
+
+   check( US_Checkpoint::run_identity( stime, params1 ) !=
+          US_Checkpoint::run_identity( stime.addSecs( 1 ), params1 ),
+          "changed submit time differs", 0 );
+
+   ckpt2.requestID          = "1235";
+   check( ! ckpt1.same_run( ckpt2 ), "other request differs", 0 );
+
+   make_checkpoint( ckpt2, params2 );
+   ckpt2.total_points       = 3001;
+   check( ! ckpt1.same_run( ckpt2 ), "other data size differs", 0 );
+}
+
+// Damaged, foreign and missing files are not read
+static void test_rejected( const QString& fname )
+{
+   US_Checkpoint ckpt;
+   US_Checkpoint ckin;
+   QMap< QString, QString > params;
+
+   make_checkpoint( ckpt, params );
+   ckpt.write( fname );
+
+   QFile filet( fname );
+   qint64 fsize   = filet.size();
+   filet.resize( fsize / 2 );
+   check( ! ckin.read( fname, true ), "truncated file rejected", fsize / 2 );
+
+   QFile fileo( fname );
+
+   if ( fileo.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+   {
+      fileo.write( QByteArray( 64, 'x' ) );
+      fileo.close();
+   }
+
+   check( ! ckin.read( fname, false ), "foreign file rejected", 64 );
+
+   QFile::remove( fname );
+   check( ! ckin.read( fname, false ), "missing file rejected", 0 );
+}
+
+int main( void )
+{
+   QString fname  = QDir::tempPath() + "/us_checkpoint_test.dat";
+
+   test_round_trip( fname );
+   test_identity();
+   test_rejected( fname );
+
+   QFile::remove( fname );
+
+   qDebug() << ( nfail == 0 ? "All checkpoint tests passed"
+                            : "Checkpoint tests FAILED:" )
+            << nfail;
+   return ( nfail == 0 ) ? 0 : 1;
+}
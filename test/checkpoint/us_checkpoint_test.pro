@@ -0,0 +1,20 @@
+# Test of the us_mpi_analysis checkpoint file (console program)
+include( ../../local.pri )
+
+CONFIG      += $${DEBUGORRELEASE} qt thread warn console
+TEMPLATE     = app
+QT          -= gui
+DEFINES     += LINUX
+
+TARGET       = us_checkpoint_test
+DESTDIR      = .
+
+MOC_DIR      = ./moc
+OBJECTS_DIR  = ./obj
+
+SOURCES      = us_checkpoint_test.cpp \
+               ../../programs/us_mpi_analysis/us_checkpoint.cpp
+
+INCLUDEPATH  += ../../utils ../../programs/us_mpi_analysis
+DEPENDPATH   += ../../utils ../../programs/us_mpi_analysis
+LIBS         += -lus_utils -L../../lib
@@ -0,0 +1,157 @@
+//! \file us_fitcache_test.cpp
+//!
+//! Checks the GA fitness cache (US_FitnessCache):  stored values are
+//! fetched unchanged, other keys miss, the table stays within its memory
+//! budget, and nearby gene values quantize to the same key. Exits non-zero
+//! if any check fails.
+
+#include <QtCore>
+#include <math.h>
+
+#include "us_fitness_cache.h"
+
+static int nfail   = 0;      // Count of failed checks
+
+// Report a check and count any failure
+static void check( bool ok, const char* name, double value )
+{
+   qDebug() << ( ok ? "PASS" : "FAIL" ) << name << value;
+
+   if ( ! ok )
+      nfail++;
+}
+
+// Key of a 2-solute gene, as the GA worker builds it
+static QVector< qint64 > gene_key( int index )
+{
+   QVector< qint64 > key( 4 );
+
+   for ( int jj = 0; jj < 4; jj++ )
+      key[ jj ]      = US_FitnessCache::quantize_fixed(
+                          1.0 + index * 0.001 + jj * 3.7, 5 );
+
+   return key;
+}
+
+// Stored values are fetched unchanged; absent keys miss
+static void test_round_trip( void )
+{
+   US_FitnessCache cache( 16 );
+   int    nkeys   = 1000;
+   int    nbad    = 0;
+   double fitness = 0.0;
+
+   check( ! cache.fetch( gene_key( 0 ), fitness ), "fetch from empty cache",
+          cache.count() );
+
+   for ( int kk = 0; kk < nkeys; kk++ )
+      cache.store( gene_key( kk ), 1.0 / ( kk + 1 ) );
+
+   for ( int kk = 0; kk < nkeys; kk++ )
+   {
+      if ( ! cache.fetch( gene_key( kk ), fitness )  ||
+           fitness != 1.0 / ( kk + 1 ) )
+         nbad++;
+   }
+
+   check( nbad == 0, "round trip: keys not found or changed", nbad );
+   check( cache.count() == nkeys, "round trip: entries held", cache.count() );
+   check( ! cache.fetch( gene_key( nkeys ), fitness ), "absent key misses",
+          nkeys );
+
+   // A key of another length never matches
+   QVector< qint64 > skey = gene_key( 1 );
+   skey.resize( 2 );
+   check( ! cache.fetch( skey, fitness ), "shorter key misses", skey.size() );
+
+   // Storing a key again replaces its value
+   cache.store( gene_key( 5 ), -2.0 );
+   bool found     = cache.fetch( gene_key( 5 ), fitness );
+   check( found  &&  fitness == -2.0, "store replaces value", fitness );
+
+   int hits;
+   int misses;
+   int evicts;
+   int count      = cache.statistics( hits, misses, evicts );
+   check( count == nkeys  &&  hits == nkeys + 1  &&  misses == 3  &&
+          evicts == 0, "round trip: statistics", hits );
+}
+
+// A zero budget disables the cache
+static void test_disabled( void )
+{
+   US_FitnessCache cache( 0 );
+   double fitness = 0.0;
+
+   cache.store( gene_key( 1 ), 0.5 );
+   check( ! cache.fetch( gene_key( 1 ), fitness )  &&  cache.count() == 0,
+          "disabled cache holds nothing", cache.count() );
+}
+
+// Entries beyond the budget replace older ones
+static void test_bounded( void )
+{
+   US_FitnessCache cache( 1 );
+   int    nkeys   = 100000;
+   double fitness = 0.0;
+
+   for ( int kk = 0; kk < nkeys; kk++ )
+      cache.store( gene_key( kk ), (double)kk );
+
+   int hits;
+   int misses;
+   int evicts;
+   int count      = cache.statistics( hits, misses, evicts );
+   int nslots     = ( 1024 * 1024 ) / ( 4 * sizeof( qint64 )
+                                        + sizeof( double ) + sizeof( quint32 ) );
+
+   check( count <= nslots  &&  count + evicts == nkeys,
+          "bounded: entries held", count );
+   bool found     = cache.fetch( gene_key( nkeys - 1 ), fitness );
+   check( found  &&  fitness == (double)( nkeys - 1 ),
+          "bounded: newest key kept", fitness );
+
+   cache.clear();
+   check( cache.count() == 0  &&  ! cache.fetch( gene_key( 1 ), fitness ),
+          "clear empties the cache", cache.count() );
+}
+
+// Values equal to the kept precision share a key
+static void test_quantize( void )
+{
+   check( US_FitnessCache::quantize_fixed( 2.345671, 5 ) ==
+          US_FitnessCache::quantize_fixed( 2.345669, 5 ),
+          "quantize_fixed: same to 5 places", 2.34567 );
+   check( US_FitnessCache::quantize_fixed( 2.34567, 5 ) !=
+          US_FitnessCache::quantize_fixed( 2.34568, 5 ),
+          "quantize_fixed: differ at 5 places", 2.34568 );
+
+   check( US_FitnessCache::quantize_sig( 1.5e-13, 4 ) ==
+          US_FitnessCache::quantize_sig( 1.50001e-13, 4 ),
+          "quantize_sig: same to 4 digits", 1.5e-13 );
+   check( US_FitnessCache::quantize_sig( 1.5e-13, 4 ) !=
+          US_FitnessCache::quantize_sig( 1.501e-13, 4 ),
+          "quantize_sig: differ at 4 digits", 1.501e-13 );
+   check( US_FitnessCache::quantize_sig( 1.5e-13, 4 ) !=
+          US_FitnessCache::quantize_sig( 1.5e-12, 4 ),
+          "quantize_sig: differ in exponent", 1.5e-12 );
+   check( US_FitnessCache::quantize_sig( 9.9996, 4 ) ==
+          US_FitnessCache::quantize_sig( 10.0, 4 ),
+          "quantize_sig: rounding carry", 10.0 );
+   check( US_FitnessCache::quantize_sig( -3.0, 4 ) !=
+          US_FitnessCache::quantize_sig( 3.0, 4 ),
+          "quantize_sig: sign kept", -3.0 );
+}
+
+int main( void )
+{
+   test_round_trip();
+   test_disabled();
+   test_bounded();
+   test_quantize();
+
+   qDebug() << ( nfail == 0 ? "All fitness cache tests passed"
+                            : "Fitness cache tests FAILED:" )
+            << nfail;
+   return ( nfail == 0 ) ? 0 : 1;
+}
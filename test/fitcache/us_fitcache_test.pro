@@ -0,0 +1,19 @@
+# Test of the GA fitness cache of us_mpi_analysis (console program)
+include( ../../local.pri )
+
+CONFIG      += $${DEBUGORRELEASE} qt thread warn console
+TEMPLATE     = app
+QT          -= gui
+DEFINES     += LINUX
+
+TARGET       = us_fitcache_test
+DESTDIR      = .
+
+MOC_DIR      = ./moc
+OBJECTS_DIR  = ./obj
+
+SOURCES      = us_fitcache_test.cpp \
+               ../../programs/us_mpi_analysis/us_fitness_cache.cpp
+
+INCLUDEPATH  += ../../programs/us_mpi_analysis
+DEPENDPATH   += ../../programs/us_mpi_analysis
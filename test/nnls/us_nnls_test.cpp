@@ -0,0 +1,279 @@
+//! \file us_nnls_test.cpp
+//!
+//! Checks that the normal-equations NNLS solvers (nnls_gram, nnls_gram_csc,
+//! nnls_normal, nnls_ne) agree with the Lawson-Hanson nnls() on systems of
+//! known solution and on sedimentation-like test problems. Exits non-zero
+//! if any check fails.
+
+#include <QtCore>
+#include <math.h>
+
+#include "us_math2.h"
+
+static int nfail   = 0;      // Count of failed checks
+
+// Report a check and count any failure
+static void check( bool ok, const char* name, double value )
+{
+   qDebug() << ( ok ? "PASS" : "FAIL" ) << name << value;
+
+   if ( ! ok )
+      nfail++;
+}
+
+// Repeatable pseudo-random value in [0,1)
+static double urand( void )
+{
+   static quint32 seed = 12345;
+   seed           = seed * 1103515245 + 12345;
+   return (double)( ( seed >> 8 ) & 0xffffff ) / 16777216.0;
+}
+
+// Fill A with step-like columns, as simulated boundaries are, and b with
+//  a noisy sum of a few of them
+static void profiles( int m, int n, QVector< double >& a,
+                      QVector< double >& b )
+{
+   a.fill( 0.0, m * n );
+   b.fill( 0.0, m );
+
+   for ( int jj = 0; jj < n; jj++ )
+   {
+      double cen     = urand();
+      double wid     = 0.02 + 0.2 * urand();
+
+      for ( int ii = 0; ii < m; ii++ )
+      {
+         double xx      = ( (double)ii / (double)m - cen ) / wid;
+         a[ ii + jj * m ] = 0.5 * ( 1.0 + erf( xx ) );
+      }
+   }
+
+   for ( int kk = 0; kk < 3; kk++ )
+   {
+      int    jj      = (int)( urand() * n );
+      double conc    = 0.5 + 2.0 * urand();
+
+      for ( int ii = 0; ii < m; ii++ )
+         b[ ii ]       += conc * a[ ii + jj * m ];
+   }
+
+   for ( int ii = 0; ii < m; ii++ )
+      b[ ii ]       += 0.01 * ( urand() - 0.5 );
+}
+
+// Solve by nnls() on copies of A and b (which nnls() overwrites)
+static double solve_lh( int m, int n, const QVector< double >& a,
+                        const QVector< double >& b, QVector< double >& x )
+{
+   QVector< double > aw = a;
+   QVector< double > bw = b;
+   double rnorm   = 0.0;
+   x.fill( 0.0, n );
+
+   US_Math2::nnls( aw.data(), m, m, n, bw.data(), x.data(), &rnorm );
+   return rnorm;
+}
+
+// Largest absolute difference of two vectors
+static double max_diff( const QVector< double >& x1,
+                        const QVector< double >& x2 )
+{
+   double dmax    = 0.0;
+
+   for ( int jj = 0; jj < x1.size(); jj++ )
+      dmax           = qMax( dmax, qAbs( x1[ jj ] - x2[ jj ] ) );
+
+   return dmax;
+}
+
+// Largest absolute value of a vector
+static double max_abs( const QVector< double >& x )
+{
+   double xmax    = 0.0;
+
+   for ( int jj = 0; jj < x.size(); jj++ )
+      xmax           = qMax( xmax, qAbs( x[ jj ] ) );
+
+   return xmax;
+}
+
+// A 3 by 2 system whose unconstrained solution is negative in x[1]:
+//  the constrained solution is ( 0.5, 0 ), with residual norm sqrt(1.5)
+static void test_known( void )
+{
+   double avals[] = { 1.0, 0.0, 1.0,   0.0, 1.0, 1.0 };
+   double bvals[] = { 1.0, -1.0, 0.0 };
+   QVector< double > a( 6 );
+   QVector< double > b( 3 );
+   QVector< double > x_lh;
+   QVector< double > x_ne( 2, 0.0 );
+   double rn_ne   = 0.0;
+
+   for ( int ii = 0; ii < 6; ii++ ) a[ ii ] = avals[ ii ];
+   for ( int ii = 0; ii < 3; ii++ ) b[ ii ] = bvals[ ii ];
+
+   double rn_lh   = solve_lh( 3, 2, a, b, x_lh );
+   US_Math2::nnls_ne( a.data(), 3, 3, 2, b.data(), x_ne.data(), &rn_ne );
+
+   check( qAbs( x_lh[ 0 ] - 0.5 ) < 1e-12  &&  x_lh[ 1 ] == 0.0,
+          "known: nnls x", x_lh[ 0 ] );
+   check( qAbs( x_ne[ 0 ] - 0.5 ) < 1e-12  &&  x_ne[ 1 ] == 0.0,
+          "known: nnls_ne x", x_ne[ 0 ] );
+   check( qAbs( rn_lh - sqrt( 1.5 ) ) < 1e-12, "known: nnls rnorm", rn_lh );
+   check( qAbs( rn_ne - sqrt( 1.5 ) ) < 1e-12, "known: nnls_ne rnorm", rn_ne );
+}
+
+// Sedimentation-like problems:  both solvers find the same solution
+static void test_profiles( void )
+{
+   double dxmax   = 0.0;
+   double drmax   = 0.0;
+
+   for ( int trial = 0; trial < 50; trial++ )
+   {
+      int    m       = 100 + (int)( urand() * 400 );
+      int    n       = 2   + (int)( urand() * 60 );
+      QVector< double > a;
+      QVector< double > b;
+      QVector< double > x_lh;
+      QVector< double > x_ne( n, 0.0 );
+      double rn_ne   = 0.0;
+
+      profiles( m, n, a, b );
+      double rn_lh   = solve_lh( m, n, a, b, x_lh );
+      US_Math2::nnls_ne( a.data(), m, m, n, b.data(), x_ne.data(), &rn_ne,
+                         1 + trial % 4 );
+
+      dxmax          = qMax( dxmax, max_diff( x_lh, x_ne ) /
+                                    qMax( 1.0, max_abs( x_lh ) ) );
+      drmax          = qMax( drmax, qAbs( rn_ne - rn_lh ) / rn_lh );
+   }
+
+   check( dxmax < 1e-6, "profiles: max relative |dx|", dxmax );
+   check( drmax < 1e-6, "profiles: max relative rnorm difference", drmax );
+}
+
+// A repeated column:  the residual norms still agree
+static void test_dependent( void )
+{
+   int    m       = 200;
+   int    n       = 20;
+   QVector< double > a;
+   QVector< double > b;
+   QVector< double > x_lh;
+   QVector< double > x_ne( n, 0.0 );
+   double rn_ne   = 0.0;
+
+   profiles( m, n, a, b );
+
+   for ( int ii = 0; ii < m; ii++ )
+      a[ ii + 7 * m ] = a[ ii + 3 * m ];
+
+   double rn_lh   = solve_lh( m, n, a, b, x_lh );
+   int    ret     = US_Math2::nnls_ne( a.data(), m, m, n, b.data(),
+                                       x_ne.data(), &rn_ne );
+
+   check( ret == 0, "dependent: nnls_ne return", ret );
+   check( qAbs( rn_ne - rn_lh ) / rn_lh < 1e-6,
+          "dependent: relative rnorm difference", rn_ne - rn_lh );
+}
+
+// A warm start from a nearby solution reaches the cold-start solution
+static void test_warm( void )
+{
+   int    m       = 300;
+   int    n       = 40;
+   QVector< double > a;
+   QVector< double > b;
+   QVector< double > ata( n * n );
+   QVector< double > atb( n );
+   QVector< double > x_cold( n, 0.0 );
+   QVector< double > x_warm;
+   double btb     = 0.0;
+
+   profiles( m, n, a, b );
+   US_Math2::nnls_gram( a.data(), m, m, n, b.data(), ata.data(), atb.data(),
+                        &btb );
+   US_Math2::nnls_normal( ata.constData(), atb.constData(), n,
+                          x_cold.data(), btb );
+
+   x_warm         = x_cold;
+
+   for ( int jj = 0; jj < n; jj += 5 )
+      x_warm[ jj ]   = ( x_warm[ jj ] > 0.0 ) ? 0.0 : 1.0;
+
+   US_Math2::nnls_normal( ata.constData(), atb.constData(), n,
+                          x_warm.data(), btb, NULL, true );
+
+   check( max_diff( x_cold, x_warm ) < 1e-6 * qMax( 1.0, max_abs( x_cold ) ),
+          "warm: max |dx| from cold start", max_diff( x_cold, x_warm ) );
+}
+
+// The dense and sparse normal-equations products agree, and the dense
+//  ones do not depend on the thread count
+static void test_gram( void )
+{
+   int    m       = 500;
+   int    n       = 30;
+   QVector< double > a( m * n, 0.0 );
+   QVector< double > b( m );
+   QVector< double > vals;
+   QVector< int >    rows;
+   QVector< int >    cptr;
+   QVector< double > ata1( n * n );
+   QVector< double > atb1( n );
+   QVector< double > ata4( n * n );
+   QVector< double > atb4( n );
+   QVector< double > atas( n * n );
+   QVector< double > atbs( n );
+   double btb1    = 0.0;
+   double btbs    = 0.0;
+
+   // Band-like columns, each nonzero over part of the rows
+   for ( int jj = 0; jj < n; jj++ )
+   {
+      int    r0      = (int)( urand() * m * 0.7 );
+      int    r1      = r0 + 20 + (int)( urand() * m * 0.3 );
+      cptr << vals.size();
+
+      for ( int ii = r0; ii < qMin( r1, m ); ii++ )
+      {
+         a[ ii + jj * m ] = urand();
+         vals << a[ ii + jj * m ];
+         rows << ii;
+      }
+   }
+
+   cptr << vals.size();
+
+   for ( int ii = 0; ii < m; ii++ )
+      b[ ii ]        = urand();
+
+   US_Math2::nnls_gram( a.data(), m, m, n, b.data(), ata1.data(),
+                        atb1.data(), &btb1, 1 );
+   US_Math2::nnls_gram( a.data(), m, m, n, b.data(), ata4.data(),
+                        atb4.data(), NULL, 4 );
+   US_Math2::nnls_gram_csc( vals.data(), rows.data(), cptr.data(), m, n,
+                            b.data(), atas.data(), atbs.data(), &btbs, 4 );
+
+   check( ata1 == ata4  &&  atb1 == atb4, "gram: 1 and 4 threads identical",
+          max_diff( ata1, ata4 ) );
+   check( max_diff( ata1, atas ) < 1e-12 * max_abs( ata1 )  &&
+          max_diff( atb1, atbs ) < 1e-12 * max_abs( atb1 )  &&
+          qAbs( btb1 - btbs ) < 1e-12 * btb1,
+          "gram: dense and sparse max |diff|", max_diff( ata1, atas ) );
+}
+
+int main( void )
+{
+   test_known();
+   test_profiles();
+   test_dependent();
+   test_warm();
+   test_gram();
+
+   qDebug() << ( nfail == 0 ? "All NNLS tests passed" : "NNLS tests FAILED:" )
+            << nfail;
+   return ( nfail == 0 ) ? 0 : 1;
+}
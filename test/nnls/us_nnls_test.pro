@@ -0,0 +1,19 @@
+# Test of the NNLS solvers of US_Math2 (console program)
+include( ../../local.pri )
+
+CONFIG      += $${DEBUGORRELEASE} qt thread warn console
+TEMPLATE     = app
+QT          -= gui
+DEFINES     += LINUX
+
+TARGET       = us_nnls_test
+DESTDIR      = .
+
+MOC_DIR      = ./moc
+OBJECTS_DIR  = ./obj
+
+SOURCES      = us_nnls_test.cpp
+
+INCLUDEPATH  += ../../utils
+DEPENDPATH   += ../../utils
+LIBS         += -lus_utils -L../../lib
@@ -0,0 +1,259 @@
+//! \file us_simcache_test.cpp
+//!
+//! Checks the simulation cache and basis store of US_SimCache:  keys
+//! follow the simulation parameters and data grid but not the readings,
+//! cached simulations and matrices are fetched unchanged, and raw
+//! simulation grids survive a round trip through the store on disk.
+//! Exits non-zero if any check fails.
+
+#include <QtCore>
+
+#include "us_sim_cache.h"
+
+static int nfail   = 0;      // Count of failed checks
+
+// Report a check and count any failure
+static void check( bool ok, const char* name, double value )
+{
+   qDebug() << ( ok ? "PASS" : "FAIL" ) << name << value;
+
+   if ( ! ok )
+      nfail++;
+}
+
+// Fill a data grid with scans of distinct readings
+template< class T > static void fill_grid( T& data, int nscans, int npoints,
+                                           double base )
+{
+   data.xvalues.resize( npoints );
+   data.scanData.resize( nscans );
+
+   for ( int rr = 0; rr < npoints; rr++ )
+      data.xvalues[ rr ] = 5.9 + rr * 0.01;
+
+   for ( int ss = 0; ss < nscans; ss++ )
+   {
+      US_DataIO::Scan* scan = &data.scanData[ ss ];
+      scan->temperature = 20.0;
+      scan->rpm         = 50000.0;
+      scan->seconds     = 600.0 + ss * 300.0;
+      scan->omega2t     = scan->seconds * 2.74e7;
+      scan->rvalues.resize( npoints );
+
+      for ( int rr = 0; rr < npoints; rr++ )
+         scan->rvalues[ rr ] = base + ss * 0.1 + rr * 1.0e-3;
+   }
+}
+
+// Test if the readings of two data grids are equal
+static bool same_readings( US_DataIO::RawData& data1,
+                           US_DataIO::RawData& data2 )
+{
+   if ( data1.scanData.size() != data2.scanData.size() )
+      return false;
+
+   for ( int ss = 0; ss < data1.scanData.size(); ss++ )
+   {
+      if ( data1.scanData[ ss ].rvalues != data2.scanData[ ss ].rvalues )
+         return false;
+   }
+
+   return true;
+}
+
+// Remove the files of the basis store in use
+static void clear_store( void )
+{
+   QString vdir   = US_SimCache::store_directory();
+   QStringList files = QDir( vdir ).entryList( QDir::Files );
+
+   for ( int ii = 0; ii < files.size(); ii++ )
+      QFile::remove( vdir + "/" + files[ ii ] );
+}
+
+// Data set and solute keys follow what determines a simulation
+static void test_keys( void )
+{
+   US_SimulationParameters   simparams;
+   US_DataIO::RawData        rdata;
+   US_Model::SimulationComponent comp;
+
+   fill_grid( rdata, 10, 50, 0.0 );
+   comp.s         = 3.0e-13;
+   comp.D         = 6.0e-7;
+
+   US_SimCache::set_budget( 0 );
+   check( US_SimCache::dataset_key( simparams, rdata ).isEmpty(),
+          "disabled cache gives no key", 0 );
+
+   US_SimCache::set_budget( 16 );
+   QByteArray dskey = US_SimCache::dataset_key( simparams, rdata );
+   check( ! dskey.isEmpty()  &&
+          dskey == US_SimCache::dataset_key( simparams, rdata ),
+          "data set key repeatable", dskey.size() );
+
+   // Readings do not change the key;  scan times and parameters do
+   US_DataIO::RawData rdata2 = rdata;
+   rdata2.scanData[ 3 ].rvalues[ 7 ] += 1.0;
+   check( US_SimCache::dataset_key( simparams, rdata2 ) == dskey,
+          "readings do not change key", 0 );
+
+   rdata2.scanData[ 3 ].seconds += 1.0;
+   check( US_SimCache::dataset_key( simparams, rdata2 ) != dskey,
+          "scan time changes key", 0 );
+
+   US_SimulationParameters simparams2 = simparams;
+   simparams2.meniscus += 0.001;
+   check( US_SimCache::dataset_key( simparams2, rdata ) != dskey,
+          "meniscus changes key", 0 );
+
+   // Solute keys differ by component and by data set
+   US_Model::SimulationComponent comp2 = comp;
+   QByteArray skey  = US_SimCache::solute_key( dskey, comp );
+   check( skey == US_SimCache::solute_key( dskey, comp ),
+          "solute key repeatable", skey.size() );
+
+   comp2.s       *= 1.0001;
+   check( skey != US_SimCache::solute_key( dskey, comp2 ),
+          "sedimentation changes solute key", 0 );
+
+   check( skey != US_SimCache::solute_key(
+                     US_SimCache::dataset_key( simparams2, rdata ), comp ),
+          "data set changes solute key", 0 );
+}
+
+// Cached simulations, data sets and A'A matrices come back unchanged
+static void test_cache( void )
+{
+   US_SimulationParameters   simparams;
+   US_DataIO::RawData        simdat;
+   US_DataIO::RawData        simget;
+   US_Model::SimulationComponent comp;
+
+   US_SimCache::set_budget( 16 );
+   US_SimCache::clear();
+
+   fill_grid( simdat, 10, 50, 1.0 );
+   fill_grid( simget, 10, 50, 0.0 );
+   comp.s         = 3.0e-13;
+
+   QByteArray dskey = US_SimCache::dataset_key( simparams, simdat );
+   QByteArray skey  = US_SimCache::solute_key( dskey, comp );
+
+   check( ! US_SimCache::fetch( skey, simget ), "fetch before store", 0 );
+
+   US_SimCache::store( skey, simdat );
+   bool found     = US_SimCache::fetch( skey, simget );
+   check( found  &&  same_readings( simget, simdat ), "simulation round trip",
+          simget.scanData[ 9 ].rvalues[ 49 ] );
+
+   // A simulation of another grid size is not returned
+   US_DataIO::RawData simsmall;
+   fill_grid( simsmall, 10, 40, 0.0 );
+   check( ! US_SimCache::fetch( skey, simsmall ), "other grid size misses",
+          40 );
+
+   int hits;
+   int misses;
+   int entries;
+   US_SimCache::statistics( hits, misses, entries );
+   check( hits == 1  &&  misses == 2  &&  entries == 1, "cache statistics",
+          hits );
+
+   // Whole data sets
+   US_DataIO::RawData sdata;
+   US_SimCache::store_data( skey, simdat );
+   found          = US_SimCache::fetch_data( skey, sdata );
+   check( found  &&  same_readings( sdata, simdat ), "data set round trip",
+          sdata.scanData.size() );
+
+   // A'A matrices
+   QVector< double > ata;
+   QVector< double > atag;
+
+   for ( int ii = 0; ii < 400; ii++ )
+      ata << 1.0 / ( ii + 1 );
+
+   US_SimCache::store_gram( dskey, ata );
+   found          = US_SimCache::fetch_gram( dskey, atag );
+   check( found  &&  atag == ata, "A'A round trip", atag.size() );
+   check( ! US_SimCache::fetch_gram( skey, atag ), "A'A other key misses", 0 );
+
+   // Clearing or disabling the cache drops everything
+   US_SimCache::clear();
+   check( ! US_SimCache::fetch( skey, simget )  &&
+          ! US_SimCache::fetch_gram( dskey, atag ), "clear empties cache", 0 );
+
+   US_SimCache::store( skey, simdat );
+   US_SimCache::set_budget( 0 );
+   US_SimCache::store( skey, simdat );
+   check( ! US_SimCache::fetch( skey, simget ), "disabled cache holds nothing",
+          0 );
+}
+
+// Raw simulation grids survive the basis store, independent of the cache
+static void test_store( void )
+{
+   US_SimulationParameters   simparams;
+   US_DataIO::RawData        sgrid;
+   US_DataIO::RawData        sgget;
+   US_Model::SimulationComponent comp;
+   QString sdir   = QDir::tempPath() + "/us_simcache_test";
+
+   US_SimCache::set_budget( 0 );
+   check( US_SimCache::set_store( sdir, 16 ), "store set up", 16 );
+   clear_store();     // Files of any earlier, interrupted test
+
+   QByteArray sgkey = US_SimCache::simulation_key( simparams );
+   check( ! sgkey.isEmpty(), "simulation key", sgkey.size() );
+
+   US_SimulationParameters simparams2 = simparams;
+   simparams2.firstScanIsConcentration = true;
+   check( US_SimCache::simulation_key( simparams2 ).isEmpty(),
+          "data dependent simulation not stored", 0 );
+
+   fill_grid( sgrid, 20, 300, 2.0 );
+   comp.s         = 5.0e-13;
+   QByteArray skey  = US_SimCache::solute_key( sgkey, comp );
+
+   check( ! US_SimCache::fetch_simout( skey, sgget ), "store miss", 0 );
+
+   US_SimCache::store_simout( skey, sgrid );
+   bool found     = US_SimCache::fetch_simout( skey, sgget );
+   check( found  &&  sgget.xvalues == sgrid.xvalues  &&
+          same_readings( sgget, sgrid )  &&
+          sgget.scanData[ 19 ].seconds == sgrid.scanData[ 19 ].seconds  &&
+          sgget.scanData[ 19 ].omega2t == sgrid.scanData[ 19 ].omega2t,
+          "store round trip", sgget.scanData.size() );
+
+   // A new process (store set up again) finds the same file
+   US_SimCache::set_store( sdir, 16 );
+   sgget          = US_DataIO::RawData();
+   found          = US_SimCache::fetch_simout( skey, sgget );
+   int hits;
+   int misses;
+   long int kbytes  = US_SimCache::store_statistics( hits, misses );
+   check( found  &&  same_readings( sgget, sgrid )  &&  kbytes > 0,
+          "store reopened", kbytes );
+
+   // Remove the test store
+   QString vdir   = US_SimCache::store_directory();
+   clear_store();
+   QDir().rmdir( vdir );
+   QDir().rmdir( sdir );
+
+   US_SimCache::set_store( QString( "" ), 0 );
+   check( ! US_SimCache::fetch_simout( skey, sgget ), "disabled store", 0 );
+}
+
+int main( void )
+{
+   test_keys();
+   test_cache();
+   test_store();
+
+   qDebug() << ( nfail == 0 ? "All simulation cache tests passed"
+                            : "Simulation cache tests FAILED:" )
+            << nfail;
+   return ( nfail == 0 ) ? 0 : 1;
+}
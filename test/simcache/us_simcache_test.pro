@@ -0,0 +1,19 @@
+# Test of the simulation cache and basis store of US_SimCache (console program)
+include( ../../local.pri )
+
+CONFIG      += $${DEBUGORRELEASE} qt thread warn console
+TEMPLATE     = app
+QT          -= gui
+DEFINES     += LINUX
+
+TARGET       = us_simcache_test
+DESTDIR      = .
+
+MOC_DIR      = ./moc
+OBJECTS_DIR  = ./obj
+
+SOURCES      = us_simcache_test.cpp
+
+INCLUDEPATH  += ../../utils
+DEPENDPATH   += ../../utils
+LIBS         += -lus_utils -L../../lib
@@ -24,8 +24,10 @@ TRANSLATIONS = $${TARGET}_DE_de.ts
 # progressed to a point where us_femglobal can be removed
 
 HEADERS      = us_analyte.h       \
+               us_astfem_grid.h   \
                us_astfem_math.h   \
                us_astfem_rsa.h    \
+               us_blas.h          \
                us_buffer.h        \
                us_cfa_data.h      \
                us_constants.h     \
@@ -54,6 +56,7 @@ HEADERS      = us_analyte.h       \
                us_report.h        \
                us_rotor.h         \
                us_settings.h      \
+               us_sim_cache.h     \
                us_simparms.h      \
                us_solute.h        \
                us_solution.h      \
@@ -69,6 +72,7 @@ HEADERS      = us_analyte.h       \
                us_zsolute.h
 
 SOURCES      = us_analyte.cpp       \
+               us_astfem_grid.cpp   \
                us_astfem_math.cpp   \
                us_astfem_rsa.cpp    \
                us_buffer.cpp        \
@@ -99,6 +103,7 @@ SOURCES      = us_analyte.cpp       \
                us_report.cpp        \
                us_rotor.cpp         \
                us_settings.cpp      \
+               us_sim_cache.cpp     \
                us_simparms.cpp      \
                us_solute.cpp        \
                us_solution.cpp      \
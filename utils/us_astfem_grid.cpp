@@ -0,0 +1,278 @@
+//! \file us_astfem_grid.cpp
+#include "us_astfem_grid.h"
+#include "us_astfem_math.h"
+#include "us_settings.h"
+#include "us_util.h"
+
+US_AstfemGrid::US_AstfemGrid( US_SimulationParameters& params )
+{
+   meshType       = (int)params.meshType;
+   fixedGrid      = ( params.gridType == US_SimulationParameters::FIXED );
+   nreused        = 0;
+}
+
+US_AstfemGrid::~US_AstfemGrid()
+{
+   qDeleteAll( entries );
+}
+
+// Get the entry for given grid limits, building it on first use
+const US_AstfemGrid::Entry* US_AstfemGrid::entry( double meniscus,
+      double bottom, int npoints )
+{
+   QMutexLocker locker( &mutex );
+
+   for ( int ii = 0; ii < entries.size(); ii++ )
+   {
+      Entry* gentry  = entries[ ii ];
+
+      if ( gentry->meniscus == meniscus  &&  gentry->bottom == bottom  &&
+           gentry->npoints  == npoints )
+      {
+         nreused++;
+         return gentry;
+      }
+   }
+
+   Entry* gentry  = new Entry;
+   gentry->meniscus = meniscus;
+   gentry->bottom   = bottom;
+   gentry->npoints  = npoints;
+
+   fixed_mesh( meshType, meniscus, bottom, npoints, gentry->x );
+
+   if ( fixedGrid )
+      build_coefs( gentry );
+
+   entries << gentry;
+
+   return gentry;
+}
+
+// Return statistics of entries built and reused
+int US_AstfemGrid::statistics( int& nreuse )
+{
+   QMutexLocker locker( &mutex );
+
+   nreuse         = nreused;
+   return entries.size();
+}
+
+// Flag whether a mesh type is independent of the solutes simulated
+bool US_AstfemGrid::shared_mesh( int meshType )
+{
+   return ( meshType == (int)US_SimulationParameters::CLAVERIE    ||
+            meshType == (int)US_SimulationParameters::MOVING_HAT  ||
+            meshType == (int)US_SimulationParameters::USER );
+}
+
+// Generate a mesh that depends only on the grid limits
+void US_AstfemGrid::fixed_mesh( int meshType, double m, double b, int Np,
+                                QVector< double >& x )
+{
+   x.clear();
+   x.reserve( Np * 2 + 2 );
+
+   switch ( meshType )
+   {
+      case (int)US_SimulationParameters::CLAVERIE:
+         // Claverie mesh without left hand refinement
+
+         for ( int i = 0; i < Np; i++ )
+            x .append( m + ( b - m ) * i / ( Np - 1 ) );
+         break;
+
+      case (int)US_SimulationParameters::MOVING_HAT:
+         // Moving Hat (Peter Schuck's Mesh) w/o left hand side refinement
+
+         x .append( m );
+
+         // Standard Schuck grids
+         for ( int i = 1; i < Np - 1; i++ )
+            x .append( m * pow( b / m, ( i - 0.5 ) / ( Np - 1 ) ) );
+
+         x .append( b );
+         break;
+
+      case (int)US_SimulationParameters::USER:
+         // User defined mesh generated from data file
+         {
+            QFile f( US_Settings::appBaseDir() + "/etc/mesh.dat" );
+
+            if ( f.open( QIODevice::ReadOnly ) )
+            {
+               QTextStream ts( &f );
+
+               while ( ! ts.atEnd() )  x .append( ts.readLine().toDouble() );
+
+               f.close();
+
+               if ( qAbs( x[ 0 ] - m ) > 1.0e7 )
+               {
+                  DbgErr() << "The meniscus from the mesh file does not"
+                     " match the set meniscus - using Claverie Mesh instead\n";
+               }
+
+               if ( qAbs( x[ x.size() - 1 ] - b ) > 1.0e7 )
+               {
+                  DbgErr() << "The cell bottom from the mesh file does not"
+                     " match the set cell bottom - using Claverie Mesh"
+                     " instead\n";
+               }
+            }
+            else
+            {
+               DbgErr() << "Could not read the mesh file - "
+                           "using Claverie Mesh instead\n";
+
+               for ( int i = 0; i < Np; i++ )
+                  x .append( m + ( b - m ) * i / ( Np - 1 ) );
+            }
+            break;
+         }
+
+      default:
+         qDebug() << "undefined mesh option\n";
+         break;
+   }
+}
+
+// Assemble fixed-mesh coefficient matrices from element stiffness
+void US_AstfemGrid::assemble_fixed( int Nx, double*** Stif,
+                                    double** CA, double** CB )
+{
+   // Assemble coefficient matrices
+   // elem[ 0 ]; i=0
+   int k = 0;
+   int m = 0;
+   CA[ 1 ][ k ] = Stif[ k ][ 3 ][ 0 ] + Stif[ k ][ 3 ][ 3 ]; // j=3;
+   CA[ 2 ][ k ] = Stif[ k ][ 2 ][ 0 ] + Stif[ k ][ 2 ][ 3 ]; // j=2;
+   CB[ 1 ][ k ] = Stif[ k ][ 0 ][ 0 ] + Stif[ k ][ 0 ][ 3 ]; // j=0;
+   CB[ 2 ][ k ] = Stif[ k ][ 1 ][ 0 ] + Stif[ k ][ 1 ][ 3 ]; // j=1;
+
+   for ( k = 1, m = 0; k < Nx - 1; k++, m++ )
+   {  // loop for all elem
+      // elem k-1: i=1,2
+      CA[ 0 ][ k ]  = Stif[ m ][ 3 ][ 1 ] + Stif[ m ][ 3 ][ 2 ];  // j=3;
+      CA[ 1 ][ k ]  = Stif[ m ][ 2 ][ 1 ] + Stif[ m ][ 2 ][ 2 ];  // j=2;
+      CB[ 0 ][ k ]  = Stif[ m ][ 0 ][ 1 ] + Stif[ m ][ 0 ][ 2 ];  // j=0;
+      CB[ 1 ][ k ]  = Stif[ m ][ 1 ][ 1 ] + Stif[ m ][ 1 ][ 2 ];  // j=1;
+
+      // elem k: i=0,3
+      CA[ 1 ][ k ] += Stif[ k ][ 3 ][ 0 ] + Stif[ k ][ 3 ][ 3 ];  // j=3;
+      CA[ 2 ][ k ]  = Stif[ k ][ 2 ][ 0 ] + Stif[ k ][ 2 ][ 3 ];  // j=2;
+      CB[ 1 ][ k ] += Stif[ k ][ 0 ][ 0 ] + Stif[ k ][ 0 ][ 3 ];  // j=0;
+      CB[ 2 ][ k ]  = Stif[ k ][ 1 ][ 0 ] + Stif[ k ][ 1 ][ 3 ];  // j=1;
+   }
+
+   // elem[ Nx-2 ]; i=1,2
+   k = Nx - 1;
+   m = k  - 1;
+   CA[ 0 ][ k ]  = Stif[ m ][ 3 ][ 1 ] + Stif[ m ][ 3 ][ 2 ];  // j=3;
+   CA[ 1 ][ k ]  = Stif[ m ][ 2 ][ 1 ] + Stif[ m ][ 2 ][ 2 ];  // j=2;
+   CB[ 0 ][ k ]  = Stif[ m ][ 0 ][ 1 ] + Stif[ m ][ 0 ][ 2 ];  // j=0;
+   CB[ 1 ][ k ]  = Stif[ m ][ 1 ][ 1 ] + Stif[ m ][ 1 ][ 2 ];  // j=1;
+}
+
+// Build the mass, diffusion and sedimentation terms of fixed-grid matrices.
+//  On a fixed mesh each element is a dt-high rectangle in (r,t), for which
+//  the local stiffness is  M + dt * ( D * K - sw2 * S ),  with M, K and S
+//  depending only on the element radii. The terms are found from unit
+//  time-step integrations and assembled as the solute matrices would be.
+void US_AstfemGrid::build_coefs( Entry* gentry )
+{
+   const double* xA = gentry->x.constData();
+   int      Nx      = gentry->x.size();
+
+   if ( Nx < 2 )
+      return;
+
+   double*** Stif   = NULL;
+   double**  CA     = NULL;
+   double**  CB     = NULL;
+   double    xd[ 4 ][ 2 ];
+   const double tD[ 3 ] = { 0.0, 1.0, 0.0 };   // D for each unit term
+   const double tS[ 3 ] = { 0.0, 0.0, 1.0 };   // sw2 for each unit term
+
+   gentry->coefs.fill( 0.0, 3 * 3 * 2 * Nx );
+   double*   cm     = gentry->coefs.data();
+
+   US_AstfemMath::initialize_3d( Nx, 4, 4, &Stif );
+   US_AstfemMath::initialize_2d( 3, Nx, &CA );
+   US_AstfemMath::initialize_2d( 3, Nx, &CB );
+
+   for ( int tt = 0; tt < 3; tt++ )
+   {
+      for ( int k = 0; k < Nx - 1; k++ )
+      {  // loop for all elem
+         xd[ 0 ][ 0 ] = xA[ k ];
+         xd[ 0 ][ 1 ] = 0.0;
+         xd[ 1 ][ 0 ] = xA[ k + 1 ];
+         xd[ 1 ][ 1 ] = 0.0;
+         xd[ 2 ][ 0 ] = xA[ k + 1 ];
+         xd[ 2 ][ 1 ] = 1.0;
+         xd[ 3 ][ 0 ] = xA[ k ];
+         xd[ 3 ][ 1 ] = 1.0;
+
+         stfb.CompLocalStif( 4, xd, tD[ tt ], tS[ tt ], Stif[ k ] );
+      }
+
+      assemble_fixed( Nx, Stif, CA, CB );
+
+      // Store the term:  mass as is; diffusion and sedimentation as
+      //  differences from the mass term
+      for ( int bb = 0; bb < 3; bb++ )
+      {
+         double* ca     = cm + ( ( 0 * 3 + bb ) * 3 + tt ) * Nx;
+         double* cb     = cm + ( ( 1 * 3 + bb ) * 3 + tt ) * Nx;
+         double* ca0    = cm + ( ( 0 * 3 + bb ) * 3 ) * Nx;
+         double* cb0    = cm + ( ( 1 * 3 + bb ) * 3 ) * Nx;
+
+         for ( int j = 0; j < Nx; j++ )
+         {
+            ca[ j ]        = ( tt == 0 ) ? CA[ bb ][ j ]
+                                         : ( CA[ bb ][ j ] - ca0[ j ] );
+            cb[ j ]        = ( tt == 0 ) ? CB[ bb ][ j ]
+                                         : ( CB[ bb ][ j ] - cb0[ j ] );
+         }
+      }
+   }
+
+   US_AstfemMath::clear_2d( 3, CB );
+   US_AstfemMath::clear_2d( 3, CA );
+   US_AstfemMath::clear_3d( Nx, 4, Stif );
+}
+
+// Compose a solute's fixed-grid coefficient matrices from the grid terms
+bool US_AstfemGrid::Entry::coefficients( double dt, double D, double sw2,
+      double** CA, double** CB ) const
+{
+   int Nx         = x.size();
+
+   if ( coefs.size() != ( 3 * 3 * 2 * Nx ) )
+      return false;
+
+   const double* cm = coefs.constData();
+   double fD      = dt * D;
+   double fS      = dt * sw2;
+
+   for ( int bb = 0; bb < 3; bb++ )
+   {
+      const double* am = cm + ( ( 0 * 3 + bb ) * 3 ) * Nx;
+      const double* ad = am + Nx;
+      const double* as = ad + Nx;
+      const double* bm = cm + ( ( 1 * 3 + bb ) * 3 ) * Nx;
+      const double* bd = bm + Nx;
+      const double* bs = bd + Nx;
+      double*       ca = CA[ bb ];
+      double*       cb = CB[ bb ];
+
+      for ( int j = 0; j < Nx; j++ )
+      {
+         ca[ j ]        = am[ j ] + fD * ad[ j ] + fS * as[ j ];
+         cb[ j ]        = bm[ j ] + fD * bd[ j ] + fS * bs[ j ];
+      }
+   }
+
+   return true;
+}
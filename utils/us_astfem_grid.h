@@ -0,0 +1,96 @@
+//! \file us_astfem_grid.h
+#ifndef US_ASTFEM_GRID_H
+#define US_ASTFEM_GRID_H
+
+#include <QtCore>
+
+#include "us_extern.h"
+#include "us_simparms.h"
+#include "us_stiffbase.h"
+
+//! \brief Grid context shared by the simulations of a data set
+//!
+//! The radial mesh of the Claverie, Moving Hat and User mesh types and,
+//! on a fixed grid, the finite element coefficient matrices depend only
+//! on the meniscus, bottom and number of points, not on the solute. This
+//! class builds them once for each set of limits and lets every
+//! US_Astfem_RSA object simulating the data set borrow them. The element
+//! stiffness is linear in the time step, D and s*omega^2, so the assembled
+//! matrices are kept as three terms that each solute scales by its own
+//! dt, D and sw2. Entries are built on first use; all methods are
+//! thread-safe.
+//!
+class US_UTIL_EXTERN US_AstfemGrid
+{
+   public:
+      //! \brief Mesh and coefficient terms for one set of grid limits
+      class US_UTIL_EXTERN Entry
+      {
+         public:
+         double            meniscus;  //!< Meniscus used to build the mesh
+         double            bottom;    //!< Bottom used to build the mesh
+         int               npoints;   //!< Simulation points requested
+         QVector< double > x;         //!< Radial mesh
+         QVector< double > coefs;     //!< Mass, diffusion, sedimentation
+                                      //!<  terms of the CA and CB bands
+
+         //! \brief Compose fixed-grid coefficient matrices for a solute
+         //! \param dt   Time step
+         //! \param D    Diffusion coefficient
+         //! \param sw2  s times omega squared
+         //! \param CA   Left hand side matrix (3 bands of x.size() values)
+         //! \param CB   Right hand side matrix (3 bands of x.size() values)
+         //! \returns    Flag if coefficient terms were available
+         bool coefficients( double, double, double, double**, double** ) const;
+      };
+
+      //! \brief Create a grid context for a data set
+      //! \param params  Simulation parameters of the data set
+      US_AstfemGrid( US_SimulationParameters& );
+
+      //! \brief Delete the grid context and its entries
+      ~US_AstfemGrid();
+
+      //! \brief Get the entry for given grid limits, building it if need be
+      //! \param meniscus Current meniscus
+      //! \param bottom   Current bottom
+      //! \param npoints  Simulation points
+      //! \returns        Entry, owned by the grid context
+      const Entry* entry( double, double, int );
+
+      //! \brief Return the count of entries built and of entries reused
+      //! \param nreuse   Returned count of times an entry was reused
+      //! \returns        Count of entries built
+      int  statistics( int& );
+
+      //! \brief Determine if a mesh type does not depend on the solutes
+      //! \param meshType Mesh type (US_SimulationParameters::MeshType)
+      //! \returns        Flag if the mesh depends only on the grid limits
+      static bool shared_mesh( int );
+
+      //! \brief Generate a mesh that does not depend on the solutes
+      //! \param meshType Mesh type: CLAVERIE, MOVING_HAT or USER
+      //! \param meniscus Meniscus
+      //! \param bottom   Bottom
+      //! \param npoints  Simulation points
+      //! \param x        Returned radial mesh
+      static void fixed_mesh( int, double, double, int, QVector< double >& );
+
+      //! \brief Assemble fixed-mesh coefficient matrices from element stiffness
+      //! \param Nx    Number of mesh points
+      //! \param Stif  Element stiffness matrices (Nx-1 of 4 x 4)
+      //! \param CA    Left hand side matrix bands
+      //! \param CB    Right hand side matrix bands
+      static void assemble_fixed( int, double***, double**, double** );
+
+   private:
+      QMutex              mutex;      // Lock for entry lookup and build
+      QList< Entry* >     entries;    // Entries built so far
+      US_StiffBase        stfb;       // Element stiffness integration
+      int                 meshType;   // Mesh type of the data set
+      bool                fixedGrid;  // Flag if the grid is fixed
+      int                 nreused;    // Count of entries reused
+
+      void build_coefs( Entry* );
+};
+#endif
@@ -97,25 +97,180 @@ void US_AstfemMath::zero_2d( int val1, int val2, double** matrix )
          matrix[ i ][ j ] = 0.0;
 }
 
+// Per-thread pool of work blocks from which matrices are carved.
+//  Blocks are kept after release and reused by later requests, growing
+//  to the largest size asked for, so repeated ASTFEM calculations in a
+//  thread settle into a fixed set of blocks and stop calling the heap.
+class US_AstfemArena
+{
+   public:
+      US_AstfemArena() : nheap( 0 ), nborrow( 0 ) {}
+
+      ~US_AstfemArena()
+      {
+         for ( int ii = 0; ii < blocks.size(); ii++ )
+            delete [] blocks[ ii ];
+      }
+
+      // Borrow a block of at least ndbls doubles
+      double* borrow( long ndbls )
+      {
+         int  bfit  = -1;     // Smallest free block that fits
+         int  bgrow = -1;     // Largest free block that does not
+
+         for ( int ii = 0; ii < blocks.size(); ii++ )
+         {
+            if ( inuse[ ii ] )
+               continue;
+
+            if ( sizes[ ii ] >= ndbls )
+            {
+               if ( bfit < 0  ||  sizes[ ii ] < sizes[ bfit ] )
+                  bfit        = ii;
+            }
+            else if ( bgrow < 0  ||  sizes[ ii ] > sizes[ bgrow ] )
+               bgrow       = ii;
+         }
+
+         nborrow++;
+
+         if ( bfit < 0 )
+         {  // Grow a free block, or add a new one
+            if ( bgrow < 0 )
+            {
+               bgrow       = blocks.size();
+               blocks << NULL;
+               sizes  << 0L;
+               inuse  << false;
+            }
+
+            delete [] blocks[ bgrow ];
+            blocks[ bgrow ] = new double [ ndbls ];
+            sizes [ bgrow ] = ndbls;
+            bfit        = bgrow;
+            nheap++;
+         }
+
+         inuse[ bfit ] = true;
+         return blocks[ bfit ];
+      }
+
+      // Return a block to the pool
+      void release( void* block )
+      {
+         for ( int ii = 0; ii < blocks.size(); ii++ )
+         {
+            if ( (void*)blocks[ ii ] == block )
+            {
+               inuse[ ii ]   = false;
+               return;
+            }
+         }
+
+         qDebug() << "*ERROR* AstfemMath: block released by a thread"
+                     " other than the one that allocated it";
+      }
+
+      // Free all blocks not currently in use
+      void trim( void )
+      {
+         for ( int ii = blocks.size() - 1; ii >= 0; ii-- )
+         {
+            if ( ! inuse[ ii ] )
+            {
+               delete [] blocks[ ii ];
+               blocks.removeAt( ii );
+               sizes .removeAt( ii );
+               inuse .removeAt( ii );
+            }
+         }
+      }
+
+      QList< double* > blocks;   // Pool blocks
+      QList< long >    sizes;    // Block sizes in doubles
+      QList< bool >    inuse;    // Flags of blocks currently borrowed
+      long             nheap;    // Count of heap allocations
+      long             nborrow;  // Count of blocks borrowed
+};
+
+static QThreadStorage< US_AstfemArena* > arenas;
+
+// Return the arena for the current thread, creating it if need be
+static US_AstfemArena* thread_arena( void )
+{
+   if ( ! arenas.hasLocalData() )
+      arenas.setLocalData( new US_AstfemArena );
+
+   return arenas.localData();
+}
+
+// Doubles needed to hold a given count of pointers
+static long ptr_dbls( long nptrs )
+{
+   return ( nptrs * (long)sizeof( void* ) + (long)sizeof( double ) - 1 )
+          / (long)sizeof( double );
+}
+
 void US_AstfemMath::initialize_2d( int val1, int val2, double*** matrix )
 {
-   *matrix = new double* [ val1 ];
+   // Row pointers followed by the rows, in one block from the arena
+   long    npdbl  = ptr_dbls( val1 );
+   long    ndata  = (long)val1 * (long)val2;
+   double* block  = thread_arena()->borrow( npdbl + ndata );
+   double* data   = block + npdbl;
+
+   *matrix = (double**)block;
+
+   for ( long j = 0; j < ndata; j++ )
+      data[ j ] = 0.0;
 
    for ( int i = 0; i < val1; i++ )
-   {
-      (*matrix)[ i ] = new double [ val2 ];
-      
-      for ( int j = 0; j < val2; j++ )
-         (*matrix)[ i ][ j ] = 0.0;
-      
-   }
+      (*matrix)[ i ] = data + (long)i * val2;
 }
 
-void US_AstfemMath::clear_2d( int val1, double** matrix )
+void US_AstfemMath::clear_2d( int, double** matrix )
 {
-   for ( int i = 0; i < val1; i++ ) delete [] matrix[i];
-   
-   delete [] matrix;
+   if ( matrix != NULL )
+      thread_arena()->release( (void*)matrix );
+}
+
+void US_AstfemMath::arena_stats( int& nblocks, long& kbytes,
+                                 long& nheap, long& nborrow )
+{
+   US_AstfemArena* arena = thread_arena();
+   long ndbls     = 0L;
+
+   for ( int ii = 0; ii < arena->sizes.size(); ii++ )
+      ndbls         += arena->sizes[ ii ];
+
+   nblocks        = arena->blocks.size();
+   kbytes         = ( ndbls * (long)sizeof( double ) + 1023L ) / 1024L;
+   nheap          = arena->nheap;
+   nborrow        = arena->nborrow;
+}
+
+void US_AstfemMath::arena_trim( void )
+{
+   thread_arena()->trim();
+}
+
+// Return the matrices of a scope to the thread's arena
+US_AstfemMath::ArenaScope::~ArenaScope()
+{
+   for ( int ii = blocks.size() - 1; ii >= 0; ii-- )
+      thread_arena()->release( blocks[ ii ] );
+}
+
+void US_AstfemMath::ArenaScope::add( double** matrix )
+{
+   if ( matrix != NULL )
+      blocks << (void*)matrix;
+}
+
+void US_AstfemMath::ArenaScope::add( double*** matrix )
+{
+   if ( matrix != NULL )
+      blocks << (void*)matrix;
 }
 
 double US_AstfemMath::minval( const QVector< double >& value )
@@ -163,56 +318,38 @@ double US_AstfemMath::maxval( const QVector< US_Model::SimulationComponent >& va
 void US_AstfemMath::initialize_3d( 
       int val1, int val2, int val3, double**** matrix )
 {
-   *matrix = new double** [ val1 ];
+   // Plane pointers, row pointers, then the data, in one arena block
+   long    nrows  = (long)val1 * (long)val2;
+   long    npdbl  = ptr_dbls( val1 + nrows );
+   long    ndata  = nrows * (long)val3;
+   double* block  = thread_arena()->borrow( npdbl + ndata );
+   double** rows  = (double**)block + val1;
+   double* data   = block + npdbl;
+
+   *matrix = (double***)block;
+
+   for ( long k = 0; k < ndata; k++ )
+      data[ k ] = 0.0;
+
+   for ( long j = 0; j < nrows; j++ )
+      rows[ j ] = data + j * val3;
 
    for ( int i = 0; i < val1; i++ )
-   {
-      (*matrix)[ i ] = new double *[ val2 ];
-      
-      for ( int j = 0; j < val2; j++ )
-      {
-         (*matrix)[ i ][ j ] = new double [ val3 ];
-         
-         for ( int k = 0; k < val3; k++ )
-         {
-            (*matrix)[ i ][ j ][ k ] = 0.0;
-         }
-      }
-   }
+      (*matrix)[ i ] = rows + (long)i * val2;
 }
 
-void US_AstfemMath::clear_3d( int val1, int val2, double*** matrix )
+void US_AstfemMath::clear_3d( int, int, double*** matrix )
 {
-   for ( int i = 0; i < val1; i++ )
-   {
-      for ( int j = 0; j < val2; j++ )
-      {
-         delete [] matrix[ i ][ j ];
-      }
-
-      delete [] matrix[ i ];
-   }
-
-   delete [] matrix;
+   if ( matrix != NULL )
+      thread_arena()->release( (void*)matrix );
 }
 
 void US_AstfemMath::tridiag( double* a, double* b, double* c, 
                              double* r, double* u, int N )
 {
    double bet = b[ 0 ];
-#ifdef NO_DB
-   static QVector< double > gamvec;
-   static int Nsave = 0;
-
-   if ( N > Nsave )
-   {
-      Nsave = N;
-      gamvec.resize( N );
-   }
-#else
-   QVector< double > gamvec( N );
-#endif
-   double* gam = gamvec.data();
+   US_AstfemArena* arena = thread_arena();
+   double* gam = arena->borrow( N );
    
    if ( bet == 0.0 ) qDebug() << "Error 1 in tridiag";
 
@@ -230,6 +367,32 @@ void US_AstfemMath::tridiag( double* a, double* b, double* c,
 
    gam[ 0 ] = gam[ 1 ];
 
+   for ( int j = N - 2; j >= 0; j-- )
+      u[ j ] -= gam[ j + 1 ] * u[ j + 1 ];
+
+   arena->release( gam );
+}
+
+// Single-precision tridiag() with a caller-supplied work array
+void US_AstfemMath::tridiag_f( const float* a, const float* b, const float* c,
+                               const float* r, float* u, float* gam, int N )
+{
+   float bet = b[ 0 ];
+
+   if ( bet == 0.0f ) qDebug() << "Error 1 in tridiag_f";
+
+   u[ 0 ] = r[ 0 ] / bet;
+
+   for ( int j = 1; j < N; j++ )
+   {
+      gam[ j ] = c[ j - 1 ] / bet;
+      bet = b[ j ] - a[ j ] * gam[ j ];
+
+      if ( bet == 0.0f ) qDebug() << "Error 2 in tridiag_f";
+
+      u[ j ] = ( r[ j ] - a[ j ] * u[ j - 1 ] ) / bet;
+   }
+
    for ( int j = N - 2; j >= 0; j-- )
       u[ j ] -= gam[ j + 1 ] * u[ j + 1 ];
 }
@@ -576,14 +739,10 @@ int US_AstfemMath::interpolate( MfemData& expdata, MfemData& simdata,
                            << expdata.scan[ expscan ].time;
 
                   qDebug() << "The simulated data does not cover the entire "
-                              "experimental time range and ends too early!\n"
-                              "exiting...\n";
+                              "experimental time range and ends too early!";
                }
 
-#ifdef NO_DB
-               //MPI_Abort( MPI_COMM_WORLD, -1 );
-#endif
-               exit( -1 );
+               return -1;
             }
          }
 
@@ -735,13 +894,8 @@ int US_AstfemMath::interpolate( MfemData& expdata, MfemData& simdata,
                                          // ii out of scope
  
       qDebug() << "The simulated data radial range does not include the "
-                  "beginning of the experimental data's radii!\n"
-                  "exiting...";
-
-#ifdef NO_DB
-      //MPI_Abort( MPI_COMM_WORLD, -3 );
-#endif
-      exit( -3 );
+                  "beginning of the experimental data's radii!";
+      return -3;
    }
 
    int jj = 0;
@@ -755,14 +909,10 @@ int US_AstfemMath::interpolate( MfemData& expdata, MfemData& simdata,
          if ( jj == tmp_data.radius.size() )
          {
             qDebug() << "The simulated data does not have enough "
-                        "radial points and ends too early!\n"
-                        "exiting...";
+                        "radial points and ends too early!";
 //qDebug() << "jj ii szerad trad erad" << jj << ii << expdata.radius.size()
 // << tmp_data.radius[jj-1] << expdata.radius[ii];
-#ifdef NO_DB
-            //MPI_Abort( MPI_COMM_WORLD, -2 );
-#endif
-            exit( -2 );
+            return -2;
          }
       }
 
@@ -807,6 +957,98 @@ int US_AstfemMath::interpolate( MfemData& expdata, MfemData& simdata,
    return 0;
 }
 
+// Concentration at an experiment time (or omega^2t) between two sim scans
+static inline double time_interp( double conc1, double conc2,
+                                  double skey1, double skey2, double ekey )
+{
+   double a = ( conc2 - conc1 ) / ( skey2 - skey1 );
+   double b = conc2 - a * skey2;
+
+   return ( a * ekey + b );
+}
+
+// Interpolate two bracketing simulation scans onto one experiment scan.
+//  The arithmetic is that of interpolate(), without a temporary scan.
+int US_AstfemMath::interpolate_scan( MfemData& expdata, int escan,
+      QVector< double >& sradius, MfemScan& sscan1, MfemScan& sscan2,
+      bool use_time )
+{
+   MfemScan* exscan = &expdata.scan[ escan ];
+   int    nsconc  = sradius.size();
+   int    neconc  = exscan->conc.size();
+
+   if ( nsconc == 0  ||  neconc == 0 )
+      return 0;
+
+   double e_key   = use_time ? exscan->time      : exscan->omega_s_t;
+   double s_key1  = use_time ? sscan1.time       : sscan1.omega_s_t;
+   double s_key2  = use_time ? sscan2.time       : sscan2.omega_s_t;
+   bool   exact   = ( s_key2 == e_key );
+
+   if ( use_time  &&  ! exact )
+   {  // Interpolate the omega_square_t integral data
+      exscan->omega_s_t = time_interp( sscan1.omega_s_t, sscan2.omega_s_t,
+                                       s_key1, s_key2, e_key );
+   }
+
+   if ( sradius[ 0 ] > expdata.radius[ 0 ] )
+   {
+      qDebug() << "Radius comparison: " << sradius[ 0 ]
+               << " (simulated), " << expdata.radius[ 0 ]
+               << " (experimental)";
+      qDebug() << "The simulated data radial range does not include the "
+                  "beginning of the experimental data's radii!";
+      return -3;
+   }
+
+   const double* srad   = sradius.constData();
+   const double* erad   = expdata.radius.constData();
+   const double* sconc1 = sscan1.conc.constData();
+   const double* sconc2 = sscan2.conc.constData();
+   double*       econc  = exscan->conc.data();
+   int jj         = 0;
+
+   for ( int ii = 0; ii < neconc; ii++ )
+   {
+      while ( srad[ jj ] < erad[ ii ] )
+      {
+         jj++;
+         // make sure we don't overrun bounds:
+         if ( jj == nsconc )
+         {
+            qDebug() << "The simulated data does not have enough "
+                        "radial points and ends too early!";
+            return -2;
+         }
+      }
+
+      double conc2   = exact ? sconc2[ jj ]
+                     : time_interp( sconc1[ jj ], sconc2[ jj ],
+                                    s_key1, s_key2, e_key );
+
+      if ( srad[ jj ] == erad[ ii ] )
+      { // they are the same, so simply update the concentration value:
+         econc[ ii ]   += conc2;
+      }
+      else // interpolation is needed
+      {
+         int    mm        = jj - 1;
+         double radius1   = srad[ mm ];
+         double radius2   = srad[ jj ];
+         double conc1     = exact ? sconc2[ mm ]
+                          : time_interp( sconc1[ mm ], sconc2[ mm ],
+                                         s_key1, s_key2, e_key );
+
+         double a = ( conc2 - conc1 ) / ( radius2 - radius1 );
+         double b = conc2 - a * radius2;
+
+         econc[ ii ]   += ( a * erad[ ii ] + b );
+      }
+   }
+
+   return 0;
+}
+
 void US_AstfemMath::QuadSolver( double* ai, double* bi, double* ci,
       double* di, double* cr, double* solu, int N )
 {
@@ -870,6 +1112,143 @@ void US_AstfemMath::QuadSolver( double* ai, double* bi, double* ci,
    } while ( i != 0 );
 }
 
+void US_AstfemMath::tridiag_batch( const double* a, const double* b,
+      const double* c, const double* r, double* u, int N, int nb )
+{
+   // Systems are interleaved:  element j of system k is at [ j * nb + k ],
+   //  so each sweep step is a contiguous (vectorizable) loop over systems.
+   // The arithmetic for each system is the same as in tridiag().
+   US_AstfemArena* arena = thread_arena();
+   double* gam    = arena->borrow( (long)N * nb );
+   double* bet    = arena->borrow( nb );
+   int     nzero  = 0;
+
+   for ( int k = 0; k < nb; k++ )
+   {
+      bet[ k ] = b[ k ];
+      nzero   += ( bet[ k ] == 0.0 );
+      u  [ k ] = r[ k ] / bet[ k ];
+   }
+
+   if ( nzero > 0 ) qDebug() << "Error 1 in tridiag_batch";
+   nzero   = 0;
+
+   for ( int j = 1; j < N; j++ )
+   {
+      const double* aj = a + j * nb;
+      const double* bj = b + j * nb;
+      const double* cm = c + ( j - 1 ) * nb;
+      const double* rj = r + j * nb;
+      double*       gj = gam + j * nb;
+      double*       uj = u + j * nb;
+      double*       um = uj - nb;
+
+      for ( int k = 0; k < nb; k++ )
+      {
+         gj [ k ] = cm[ k ] / bet[ k ];
+         bet[ k ] = bj[ k ] - aj[ k ] * gj[ k ];
+         nzero   += ( bet[ k ] == 0.0 );
+         uj [ k ] = ( rj[ k ] - aj[ k ] * um[ k ] ) / bet[ k ];
+      }
+   }
+
+   if ( nzero > 0 ) qDebug() << "Error 2 in tridiag_batch";
+
+   for ( int j = N - 2; j >= 0; j-- )
+   {
+      const double* gp = gam + ( j + 1 ) * nb;
+      double*       uj = u + j * nb;
+      const double* up = uj + nb;
+
+      for ( int k = 0; k < nb; k++ )
+         uj[ k ] -= gp[ k ] * up[ k ];
+   }
+
+   arena->release( bet );
+   arena->release( gam );
+}
+
+void US_AstfemMath::QuadSolver_batch( const double* ai, const double* bi,
+      const double* ci, const double* di, double* cr, double* solu,
+      int N, int nb )
+{
+   // Interleaved systems as in tridiag_batch(); the arithmetic for each
+   //  system is the same as in QuadSolver()
+   US_AstfemArena* arena = thread_arena();
+   long    nsoa   = (long)N * nb;
+   double* cb     = arena->borrow( nsoa );
+   double* cc     = arena->borrow( nsoa );
+   double* tmp    = arena->borrow( nb );
+
+   for ( long k = 0; k < nsoa; k++ )
+   {
+      cb[ k ] = bi[ k ];
+      cc[ k ] = ci[ k ];
+   }
+
+   for ( int i = 1; i <= N - 1; i++ )
+   {
+      const double* ca  = ai + i * nb;
+      const double* cdm = di + ( i - 1 ) * nb;
+      double*       cbi = cb + i * nb;
+      double*       cbm = cbi - nb;
+      double*       cci = cc + i * nb;
+      double*       ccm = cci - nb;
+      double*       cri = cr + i * nb;
+      double*       crm = cri - nb;
+
+      for ( int k = 0; k < nb; k++ )
+      {
+         tmp[ k ] = ca[ k ] / cbm[ k ];
+         cbi[ k ] = cbi[ k ] - ccm[ k ] * tmp[ k ];
+         cri[ k ] = cri[ k ] - crm[ k ] * tmp[ k ];
+      }
+
+      if ( i < N - 1 )
+      {
+         for ( int k = 0; k < nb; k++ )
+            cci[ k ] = cci[ k ] - cdm[ k ] * tmp[ k ];
+      }
+   }
+
+   double*       sn = solu + ( N - 1 ) * nb;
+   double*       sm = sn - nb;
+   const double* rn = cr + ( N - 1 ) * nb;
+   const double* rm = rn - nb;
+   const double* bn = cb + ( N - 1 ) * nb;
+   const double* bm = bn - nb;
+   const double* cm = cc + ( N - 2 ) * nb;
+
+   for ( int k = 0; k < nb; k++ )
+   {
+      sn[ k ] =   rn[ k ]                       / bn[ k ];
+      sm[ k ] = ( rm[ k ] - cm[ k ] * sn[ k ] ) / bm[ k ];
+   }
+
+   for ( int i = N - 3; i >= 0; i-- )
+   {
+      double*       si  = solu + i * nb;
+      const double* s1  = si + nb;
+      const double* s2  = s1 + nb;
+      const double* cri = cr + i * nb;
+      const double* cbi = cb + i * nb;
+      const double* cci = cc + i * nb;
+      const double* cdi = di + i * nb;
+
+      for ( int k = 0; k < nb; k++ )
+      {
+         si[ k ] = (   cri[ k ]
+                     - cci[ k ] * s1[ k ]
+                     - cdi[ k ] * s2[ k ] ) /
+                   cbi[ k ];
+      }
+   }
+
+   arena->release( tmp );
+   arena->release( cc );
+   arena->release( cb );
+}
+
 // old version: perform integration on supp(test function) separately 
 // on left Q and right T
 
@@ -36,16 +36,29 @@ class US_UTIL_EXTERN US_AstfemMath
       static void zero_2d      ( int, int, double** );
 
       //! \brief Create a 2d matrix in memory and initilize to all zeros.
+      //!
+      //! The matrix is a single block borrowed from a per-thread arena,
+      //! so it must be deleted by clear_2d() in the same thread.
       //! \param val1   First dimension
       //! \param val2   Second dimension
       //! \param matrix Initialized val1 x val2 matrix
       static void initialize_2d( int, int, double*** );
 
-      //! \brief Delete a 2d matrix in memory
+      //! \brief Delete a 2d matrix in memory (return it to the arena)
       //! \param val1   First dimension
       //! \param matrix val1 x n matrix to be deleted
       static void clear_2d     ( int, double** );
 
+      //! \brief Return work arena statistics for the current thread
+      //! \param nblocks Returned count of blocks held by the arena
+      //! \param kbytes  Returned memory held by the arena in KB
+      //! \param nheap   Returned count of heap allocations made
+      //! \param nborrow Returned count of blocks borrowed
+      static void arena_stats  ( int&, long&, long&, long& );
+
+      //! \brief Free the current thread's arena blocks not in use
+      static void arena_trim   ( void );
+
       //! \brief Find the maximum value in a vector
       //! \param value Vector whose maximum is found
       //! \returns Vector maximum value
@@ -67,6 +80,8 @@ class US_UTIL_EXTERN US_AstfemMath
       static double minval( const QVector< US_Model::SimulationComponent >& );
 
       //! \brief Create a 3d matrix in memory and initilize to all zeros.
+      //!
+      //! As with initialize_2d(), the matrix comes from the thread's arena.
       //! \param val1   First dimension
       //! \param val2   Second dimension
       //! \param val3   Third dimension
@@ -89,6 +104,17 @@ class US_UTIL_EXTERN US_AstfemMath
       static void   tridiag      ( double*, double*, double*, 
                                    double*, double*, int );
 
+      //! \brief Solve a Ax = b where A is tridiagonal, in single precision
+      //! \param a    Array of a values
+      //! \param b    Array of b values
+      //! \param c    Array of c values
+      //! \param r    Array of r values
+      //! \param u    Array of u values
+      //! \param gam  Work array of length N
+      //! \param N    Length of vectors
+      static void   tridiag_f    ( const float*, const float*, const float*,
+                                   const float*, float*, float*, int );
+
       //! \brief Find the positive cubic-root of a cubic polynomial<br>
       //! with a0 <= 0 and<br>
       //! a1, a2 >= 0
@@ -116,7 +142,8 @@ class US_UTIL_EXTERN US_AstfemMath
       //! \param expdata  Experimental data to create, sized on input
       //! \param simdata  Simulation from which to create modeled experiment
       //! \param use_time Flag of whether to use time interpolation
-      //! \returns Success flag: 0 -> success
+      //! \returns Success flag: 0 -> success; negative if the simulation
+      //!          does not cover the experiment times (-1) or radii (-2,-3)
       static int    interpolate  ( MfemData&, MfemData&, bool );  
 
       //! \brief Interpolate one dataset onto another using time or omega^2t
@@ -125,9 +152,23 @@ class US_UTIL_EXTERN US_AstfemMath
       //! \param use_time Flag of whether to use time correction
       //! \param fscan    First update expdata scan index
       //! \param lscan    Last update expdata scan index plus one
-      //! \returns Success flag: 0 -> success
+      //! \returns Success flag: 0 -> success; negative as for interpolate()
       static int    interpolate  ( MfemData&, MfemData&, bool, int, int );  
 
+      //! \brief Interpolate between two simulation scans onto one scan
+      //!        of experimental data, as interpolate() does for each scan.
+      //!        Used to stream output while a simulation steps in time.
+      //! \param expdata  Experimental data to add to, sized on input
+      //! \param escan    Index of the expdata scan to update
+      //! \param sradius  Radius points of the simulation scans
+      //! \param sscan1   Simulation scan before the experiment scan
+      //! \param sscan2   Simulation scan at or after the experiment scan
+      //! \param use_time Flag of whether to use time interpolation
+      //! \returns Success flag: 0 -> success; negative if the simulation
+      //!          does not cover the experiment radii (-2,-3)
+      static int    interpolate_scan( MfemData&, int, QVector< double >&,
+                                      MfemScan&, MfemScan&, bool );
+
       //! \brief Solve Quad-diagonal system
       //! \param ai   The initial a vector
       //! \param bi   The initial b vector
@@ -138,6 +179,38 @@ class US_UTIL_EXTERN US_AstfemMath
       //! \param N    The length of vectors
       static void   QuadSolver   ( double*, double*, double*, double*, 
                                    double*, double*, int);
+
+      //! \brief Solve several tridiagonal systems of the same size together
+      //!
+      //! Vectors hold the nb systems interleaved (structure-of-arrays):
+      //! element j of system k is at index j*nb+k. Each system is solved
+      //! with the same arithmetic as tridiag().
+      //! \param a  Array of a values
+      //! \param b  Array of b values
+      //! \param c  Array of c values
+      //! \param r  Array of r values
+      //! \param u  Array of u values
+      //! \param N  Length of each system
+      //! \param nb Number of systems
+      static void   tridiag_batch( const double*, const double*,
+                                   const double*, const double*,
+                                   double*, int, int );
+
+      //! \brief Solve several Quad-diagonal systems of the same size together
+      //!
+      //! Vectors hold the nb systems interleaved as in tridiag_batch().
+      //! Each system is solved with the same arithmetic as QuadSolver().
+      //! \param ai   The initial a vector
+      //! \param bi   The initial b vector
+      //! \param ci   The initial c vector
+      //! \param di   The initial d vector
+      //! \param cr   The Cr        vector (modified)
+      //! \param solu The calculated solution vector
+      //! \param N    The length of each system
+      //! \param nb   Number of systems
+      static void   QuadSolver_batch( const double*, const double*,
+                                      const double*, const double*,
+                                      double*, double*, int, int );
    
       //! \brief Integration on test function seperately on left Q, right T
       //! \param vx   The vx vector
@@ -356,6 +429,28 @@ class US_UTIL_EXTERN US_AstfemMath
          QVector< MfemScan > scan;     //!< list of scan data
       };
      
+      //! \brief Arena matrices released on leaving a scope
+      //!
+      //! Matrices from initialize_2d() or initialize_3d() that are added
+      //! are returned to the thread's arena when the object is destroyed,
+      //! whatever the exit path of the function holding it.
+      class ArenaScope
+      {
+         public:
+         ~ArenaScope();
+
+         //! \brief Add a 2d matrix to release
+         //! \param matrix Matrix from initialize_2d()
+         void add( double**  matrix );
+
+         //! \brief Add a 3d matrix to release
+         //! \param matrix Matrix from initialize_3d()
+         void add( double*** matrix );
+
+         private:
+         QList< void* > blocks;   //!< arena blocks held
+      };
+
       //! \brief Reaction Group
       class ReactionGroup
       {
@@ -19,8 +19,18 @@ US_Astfem_RSA::US_Astfem_RSA( US_Model&                model,
    use_time        = false;
    time_correction = true;
    simout_flag     = false;
+   stream_flag     = false;
+   stream_out      = false;
+   stream_escan    = 0;
+   stream_nscan    = 0;
+   stream_error    = 0;
    show_movie      = false;
    dbg_level       = 0;
+   agrid           = NULL;
+   gentry          = NULL;
+   nsteps_taken    = 0;
+   nsteps_fixed    = 0;
+   float_flag      = false;
 }
 
 int US_Astfem_RSA::calculate( US_DataIO::RawData& exp_data )
@@ -489,11 +499,22 @@ DbgLv(2) << "RSA:(1) nr1" << nr1 << "r sme"
   << ed->radius[nr1/2-1] << ed->radius[nr1/2] << ed->radius[nr1/2+1]
   << ed->radius[nr1-3]   << ed->radius[nr1-2] << ed->radius[nr1-1];
 
-            // Calculate the simulation for the bulk of the speed step
+            // Calculate the simulation for the bulk of the speed step,
+            //  streaming scans onto the experimental grid if possible
+
+            stream_out    = ( stream_flag  &&  in_step  &&  ! simout_flag );
+            stream_escan  = 0;
+            stream_nscan  = 0;
+            stream_error  = 0;
 
             calculate_ni( step_speed, step_speed,
                           CT0, simdata, false );
 
+            stream_out    = false;
+
+            if ( stream_error < 0 )
+               return -1;
+
             qApp->processEvents();
             if ( stopFlag ) return 1;
 
@@ -507,6 +528,7 @@ DbgLv(2) << "RSA:T   step rpm" << step << sp->rotorspeed
  << "fscan lscan" << fscan << lscan << "dt" << af_params.dt;
 int mmm=simdata.scan.size()-1;
 int kkk=qMin(af_params.time_steps-1,mmm);
+if(mmm>=0) {
 DbgLv(2) << "RSA:T    eomg1 eomg2" << ed->scan[fscan].omega_s_t
  << ed->scan[lscan].omega_s_t << " somg1 somg2"
  << simdata.scan[0].omega_s_t << simdata.scan[mmm].omega_s_t;
@@ -514,6 +536,7 @@ DbgLv(2) << "RSA:T    etim1 etim2" << ed->scan[fscan].time
  << ed->scan[lscan].time << " stim1 stim2"
  << simdata.scan[0].time << simdata.scan[mmm].time << simdata.scan[kkk].time
  << "sssz tsteps" << simdata.scan.size() << af_params.time_steps;
+}
 #ifdef TIMING_RA
 QDateTime clcSt5 = QDateTime::currentDateTime();
 totT4+=(clcSt4.msecsTo(clcSt5));
@@ -527,11 +550,12 @@ DbgLv(2) << "RSA:(2) nr2" << nr2 << "r sme"
   << ed->radius[0]       << ed->radius[1]     << ed->radius[2]
   << ed->radius[nr2/2-1] << ed->radius[nr2/2] << ed->radius[nr2/2+1]
   << ed->radius[nr2-3]   << ed->radius[nr2-2] << ed->radius[nr2-1];
-            if ( in_step )
+            if ( in_step  &&  stream_nscan == 0 )
             {
 //               US_AstfemMath::interpolate( *ed, simdata, use_time,
 //                                           fscan, ++lscan );
-               US_AstfemMath::interpolate( *ed, simdata, use_time );
+               if ( US_AstfemMath::interpolate( *ed, simdata, use_time ) < 0 )
+                  return -1;
 DbgLv(2) << "RSA:T     INTERP in step" << step;
             }
 int nr3=ed->radius.size();
@@ -834,8 +858,20 @@ DbgLv(2) << "RSA:(1) nr1" << nr1 << "r sme"
   << ed->radius[nr1-3]   << ed->radius[nr1-2] << ed->radius[nr1-1];
 
 DbgLv(2) << "RSA:   tsteps sttime" << af_params.time_steps << current_time;
+         stream_out    = ( stream_flag  &&  ! simout_flag  &&
+                           ed->scan[ fscan ].time <= sp->time_last  &&
+                           ed->scan[ lscan ].time >= sp->time_first );
+         stream_escan  = 0;
+         stream_nscan  = 0;
+         stream_error  = 0;
+
          calculate_ra2( step_speed, step_speed, vC0, simdata, false );
 
+         stream_out    = false;
+
+         if ( stream_error < 0 )
+            return -1;
+
          // Set the current time to the last scan of this speed step
          duration      = sp->duration_hours * 3600.0
                        + sp->duration_minutes * 60.0;
@@ -856,11 +892,13 @@ DbgLv(2) << "RSA:(2) nr2" << nr2 << "r sme"
   << ed->radius[nr2/2-1] << ed->radius[nr2/2] << ed->radius[nr2/2+1]
   << ed->radius[nr2-3]   << ed->radius[nr2-2] << ed->radius[nr2-1];
          if ( ed->scan[ fscan ].time <= sp->time_last  &&
-              ed->scan[ lscan ].time >= sp->time_first )
+              ed->scan[ lscan ].time >= sp->time_first  &&
+              stream_nscan == 0 )
          {
 //            US_AstfemMath::interpolate( *ed, simdata, use_time,
 //                                        fscan, ++lscan );
-            US_AstfemMath::interpolate( *ed, simdata, use_time );
+            if ( US_AstfemMath::interpolate( *ed, simdata, use_time ) < 0 )
+               return -1;
          }
 int nr3=ed->radius.size();
 DbgLv(2) << "RSA:(3) nr3" << nr3 << "r sme"
@@ -1361,24 +1399,71 @@ DbgLv(2) << "RSA: init_conc() RETURN CT0[0] CT[n]" << CT0.concentration[0]
 }
 
 // Non-interacting solute, constant speed
+// Calculate the right hand side of a non-interacting time step, in the
+//  form for a fixed grid (0) or a moving mesh for positive (1) or
+//  negative (2) sedimentation
+template< class T > static void ni_rhs( T** CB, const T* C0, T* rhs,
+                                        int Nx, int form )
+{
+   if ( form == 0 )
+   {
+      rhs[ 0 ]       = - CB[ 1 ][ 0 ] * C0[ 0 ]
+                       - CB[ 2 ][ 0 ] * C0[ 1 ];
+
+      for ( int jj = 1; jj < Nx - 1; jj++ )
+      {
+         rhs[ jj ]      = - CB[ 0 ][ jj ] * C0[ jj - 1 ]
+                          - CB[ 1 ][ jj ] * C0[ jj     ]
+                          - CB[ 2 ][ jj ] * C0[ jj + 1 ];
+      }
+
+      int jj         = Nx - 1;
+      rhs[ jj ]      = - CB[ 0 ][ jj ] * C0[ jj - 1 ]
+                       - CB[ 1 ][ jj ] * C0[ jj     ];
+   }
+   else if ( form == 1 )
+   {
+      rhs[ 0 ]       = - CB[ 2 ][ 0 ] * C0[ 0 ];
+      rhs[ 1 ]       = - CB[ 1 ][ 1 ] * C0[ 0 ]
+                       - CB[ 2 ][ 1 ] * C0[ 1 ];
+
+      for ( int jj = 2; jj < Nx; jj++ )
+      {
+         rhs[ jj ]      = - CB[ 0 ][ jj ] * C0[ jj - 2 ]
+                          - CB[ 1 ][ jj ] * C0[ jj - 1 ]
+                          - CB[ 2 ][ jj ] * C0[ jj     ];
+      }
+   }
+   else
+   {
+      for ( int jj = 0; jj < Nx - 2; jj++ )
+      {
+         rhs[ jj ]      = - CB[ 0 ][ jj ] * C0[ jj     ]
+                          - CB[ 1 ][ jj ] * C0[ jj + 1 ]
+                          - CB[ 2 ][ jj ] * C0[ jj + 2 ];
+      }
+
+      int jj         = Nx - 2;
+      rhs[ jj ]      = - CB[ 0 ][ jj ] * C0[ jj     ]
+                       - CB[ 1 ][ jj ] * C0[ jj + 1 ];
+
+      jj             = Nx - 1;
+      rhs[ jj ]      = - CB[ 0 ][ jj ] * C0[ jj ];
+   }
+}
+
+// Copy 3 x Nx coefficient matrix values to single precision
+static void matrix_to_float( double** CM, float** CMf, int Nx )
+{
+   for ( int ii = 0; ii < 3; ii++ )
+      for ( int jj = 0; jj < Nx; jj++ )
+         CMf[ ii ][ jj ] = (float)CM[ ii ][ jj ];
+}
+
 int US_Astfem_RSA::calculate_ni( double rpm_start, double rpm_stop,
       US_AstfemMath::MfemInitial& C_init, US_AstfemMath::MfemData& simdata,
       bool accel )
 {
-#ifdef NO_DB
-   static int      Nsave  = 0;
-   static int      Nsavea = 0;
-   static double** CA = NULL;     // stiffness matrix on left hand side
-                                  // CA[0...Ms-1][0...N-1][4]
-
-   static double** CB = NULL;     // stiffness matrix on right hand side
-                                  // CB[0...Ms-1][0...N-1][4]
-
-   static double** CA1;           // for matrices used in acceleration
-   static double** CA2;
-   static double** CB1;
-   static double** CB2;
-#else
    double** CA = NULL;            // stiffness matrix on left hand side
                                   // CA[0...Ms-1][0...N-1][4]
 
@@ -1390,7 +1475,6 @@ int US_Astfem_RSA::calculate_ni( double rpm_start, double rpm_stop,
    double** CA2;
    double** CB1;
    double** CB2;
-#endif
 
    double*         C0 = NULL;     // C[m][j]: current/next concentration of
                                   // m-th component at x_j
@@ -1482,36 +1566,10 @@ DbgLv(2) << "RSA: mesh_gen size" << nu.count() << "accel" << accel;
    for ( int i = 0; i < Nx; i++ )
       simdata.radius .append( xA[ i ] );
 
-   // Initialize the coefficient matrices
-
-#ifdef NO_DB
-   if ( Nx > Nsave )
-   {
-      if ( Nsave > 0 )
-      {
-         US_AstfemMath::clear_2d( 3, CA );
-         US_AstfemMath::clear_2d( 3, CB );
-      }
+   // Initialize the coefficient matrices (from this thread's work arena)
 
-      Nsave = Nx;
-      US_AstfemMath::initialize_2d( 3, Nsave, &CA );
-      US_AstfemMath::initialize_2d( 3, Nsave, &CB );
-   }
-   else
-   {
-      for ( int ii = 0; ii < 3; ii++ )
-      {
-         for ( int jj = 0; jj < Nx; jj++ )
-         {
-            CA[ ii ][ jj ] = 0.0;
-            CB[ ii ][ jj ] = 0.0;
-         }
-      }
-   }
-#else
    US_AstfemMath::initialize_2d( 3, Nx, &CA );
    US_AstfemMath::initialize_2d( 3, Nx, &CB );
-#endif
 
    bool fixedGrid = ( simparams.gridType == US_SimulationParameters::FIXED );
 #ifdef TIMING_NI
@@ -1539,42 +1597,10 @@ ttT1+=(clcSt1.msecsTo(clcSt2));
    }
    else // For acceleration
    {
-#ifdef NO_DB
-      if ( Nx > Nsavea )
-      {
-         if ( Nsavea > 0 )
-         {
-            US_AstfemMath::clear_2d( 3, CA1 );
-            US_AstfemMath::clear_2d( 3, CB1 );
-            US_AstfemMath::clear_2d( 3, CA2 );
-            US_AstfemMath::clear_2d( 3, CB2 );
-         }
-
-         US_AstfemMath::initialize_2d( 3, Nx, &CA1 );
-         US_AstfemMath::initialize_2d( 3, Nx, &CA2 );
-         US_AstfemMath::initialize_2d( 3, Nx, &CB1 );
-         US_AstfemMath::initialize_2d( 3, Nx, &CB2 );
-         Nsavea = Nx;
-      }
-      else
-      {
-         for ( int ii = 0; ii < 3; ii++ )
-         {
-            for ( int jj = 0; jj < Nx; jj++ )
-            {
-               CA1[ ii ][ jj ] = 0.0;
-               CA2[ ii ][ jj ] = 0.0;
-               CB1[ ii ][ jj ] = 0.0;
-               CB2[ ii ][ jj ] = 0.0;
-            }
-         }
-      }
-#else
       US_AstfemMath::initialize_2d( 3, Nx, &CA1 );
       US_AstfemMath::initialize_2d( 3, Nx, &CA2 );
       US_AstfemMath::initialize_2d( 3, Nx, &CB1 );
       US_AstfemMath::initialize_2d( 3, Nx, &CB2 );
-#endif
 
       sw2 = 0.0;
       ComputeCoefMatrixFixedMesh( af_params.D[ 0 ], sw2, CA1, CB1 );
@@ -1599,8 +1625,53 @@ ttT2+=(clcSt2.msecsTo(clcSt3));
    US_AstfemMath::interpolate_C0( C_init, C0, x );
 //DbgLv(2) << "RSA: interp C0  RTN";
 
+   if ( simparams.dt_tolerance > 0.0  &&  fixedGrid  &&  ! accel )
+   {  // Time evolution with error-controlled step sizes
+      adaptive_ni( rpm_stop, C0, C_init, simdata );
+
+      US_AstfemMath::clear_2d( 3, CA );
+      US_AstfemMath::clear_2d( 3, CB );
+      return 0;
+   }
+
    // Time evolution
    double* right_hand_side = rhVec.data();
+
+   // Form of the right hand side:  fixed grid, or moving mesh for s>0 or s<0
+   int     rhs_form = ( accel || fixedGrid ) ? 0
+                    : ( ( af_params.s[ 0 ] > 0 ) ? 1 : 2 );
+
+   // Single-precision matrices and vectors, for the float mode
+   QVector< float > fltVec;
+   float*  CAf[ 3 ];
+   float*  CBf[ 3 ];
+   float*  C0f  = NULL;
+   float*  C1f  = NULL;
+   float*  rhsf = NULL;
+   float*  gamf = NULL;
+
+   if ( float_flag )
+   {
+      fltVec.resize( Nx * 10 );
+      float*  fvp   = fltVec.data();
+
+      for ( int jj = 0; jj < 3; jj++ )
+      {
+         CAf[ jj ]     = fvp + jj * Nx;
+         CBf[ jj ]     = fvp + ( jj + 3 ) * Nx;
+      }
+
+      C0f           = fvp + 6 * Nx;
+      C1f           = fvp + 7 * Nx;
+      rhsf          = fvp + 8 * Nx;
+      gamf          = fvp + 9 * Nx;
+
+      matrix_to_float( CA, CAf, Nx );
+      matrix_to_float( CB, CBf, Nx );
+
+      for ( int jj = 0; jj < Nx; jj++ )
+         C0f[ jj ]     = (float)C0[ jj ];
+   }
 #ifdef TIMING_NI
 ttT3+=(clcSt3.msecsTo(QDateTime::currentDateTime()));
 clcSt3 = QDateTime::currentDateTime();
@@ -1617,7 +1688,8 @@ clcSt3 = QDateTime::currentDateTime();
 //   int    ltsteps     = ntsteps - 1;
    int    ltsteps     = ntsteps;
 //DbgLv(2) << "RSA: nisteps" << nisteps;
-   simdata.scan  .reserve( nisteps );
+   if ( ! stream_out )
+      simdata.scan  .reserve( nisteps );
 
    // Calculate all time steps (plus a little overlap)
    for ( int ii = 0; ii < nisteps; ii++ )
@@ -1679,12 +1751,20 @@ DbgLv(2) << "TMS:RSA:ni: time omega_s_t" << simscan.time << simscan.omega_s_t
 DbgLv(2) << "RSA: Nx C0size" << Nx << C0Vec.size() << "step-scan"
  << simdata.scan.size() << "rss-now" << US_Memory::rss_now();
 
-      for ( int jj = 0; jj < Nx; jj++ )
-         simscan.conc.append( C0[ jj ] );
+      if ( float_flag )
+      {  // The single-precision solution is widened only for output
+         for ( int jj = 0; jj < Nx; jj++ )
+            simscan.conc.append( (double)C0f[ jj ] );
+      }
+      else
+      {
+         for ( int jj = 0; jj < Nx; jj++ )
+            simscan.conc.append( C0[ jj ] );
+      }
 
 //DbgLv(2) << "RSA:           (4) ii" << ii << "simdata scans"
 //   << simdata.scan.size();
-      simdata.scan.append( simscan );
+      store_scan( simdata, simscan );
 //DbgLv(2) << "RSA:           (5) ii" << ii;
 if(ii==0) DbgLv(2) << "TMS:RSA:ni:  Scan Added";
 #ifdef TIMING_NI
@@ -1695,54 +1775,18 @@ ttT4+=(clcSt4.msecsTo(clcSt5));
       // Sedimentation part:
       // Calculate the right hand side vector
 
-      if ( accel || fixedGrid )
+      if ( float_flag )
       {
-         right_hand_side[ 0 ] = - CB[ 1 ][ 0 ] * C0[ 0 ]
-                                - CB[ 2 ][ 0 ] * C0[ 1 ];
-
-         for ( int jj = 1; jj < Nx - 1; jj++ )
+         if ( accel )
          {
-            right_hand_side[ jj ] = - CB[ 0 ][ jj ] * C0[ jj - 1 ]
-                                    - CB[ 1 ][ jj ] * C0[ jj     ]
-                                    - CB[ 2 ][ jj ] * C0[ jj + 1 ];
+            matrix_to_float( CA, CAf, Nx );
+            matrix_to_float( CB, CBf, Nx );
          }
 
-         int jj = Nx - 1;
-         right_hand_side[ jj ] = - CB[ 0 ][ jj ] * C0[ jj - 1 ]
-                                 - CB[ 1 ][ jj ] * C0[ jj     ];
+         ni_rhs( CBf, C0f, rhsf, Nx, rhs_form );
       }
       else
-      {
-         if ( af_params.s[ 0 ] > 0 )
-         {
-            right_hand_side[ 0 ] = - CB[ 2 ][ 0 ] * C0[ 0 ];
-            right_hand_side[ 1 ] = - CB[ 1 ][ 1 ] * C0[ 0 ]
-                                   - CB[ 2 ][ 1 ] * C0[ 1 ];
-
-            for ( int jj = 2; jj < Nx; jj++ )
-            {
-               right_hand_side[ jj ] = - CB[ 0 ][ jj ] * C0[ jj - 2 ]
-                                       - CB[ 1 ][ jj ] * C0[ jj - 1 ]
-                                       - CB[ 2 ][ jj ] * C0[ jj     ];
-            }
-         }
-         else
-         {
-            for ( int jj = 0; jj < Nx - 2; jj++ )
-            {
-               right_hand_side[ jj ] = - CB[ 0 ][ jj ] * C0[ jj     ]
-                                       - CB[ 1 ][ jj ] * C0[ jj + 1 ]
-                                       - CB[ 2 ][ jj ] * C0[ jj + 2 ];
-            }
-
-            int jj = Nx - 2;
-            right_hand_side[ jj ] = - CB[ 0 ][ jj ] * C0[ jj     ]
-                                    - CB[ 1 ][ jj ] * C0[ jj + 1 ];
-
-            jj = Nx - 1;
-            right_hand_side[ jj ] = -CB[ 0 ][ jj ] * C0[ jj ];
-         }
-      }
+         ni_rhs( CB, C0, right_hand_side, Nx, rhs_form );
 //DbgLv(2) << "RSA:           (6) ii" << ii;
 
 #ifdef TIMING_NI
@@ -1750,7 +1794,17 @@ clcSt6 = QDateTime::currentDateTime();
 ttT5+=(clcSt5.msecsTo(clcSt6));
 #endif
 //DbgLv(2) << "RSA: tridiag";
-      US_AstfemMath::tridiag( CA[0], CA[1], CA[2], right_hand_side, C1, Nx );
+      if ( float_flag )
+      {  // Solve in single precision
+         US_AstfemMath::tridiag_f( CAf[ 0 ], CAf[ 1 ], CAf[ 2 ], rhsf, C1f,
+                                   gamf, Nx );
+
+         float* Ctf    = C0f;
+         C0f           = C1f;
+         C1f           = Ctf;
+      }
+      else
+         US_AstfemMath::tridiag( CA[0], CA[1], CA[2], right_hand_side, C1, Nx );
 //DbgLv(2) << "RSA: tridiag    RTN";
 #ifdef TIMING_NI
 clcSt7 = QDateTime::currentDateTime();
@@ -1758,7 +1812,8 @@ ttT6+=(clcSt6.msecsTo(clcSt7));
 #endif
 
 //DbgLv(2) << "RSA: C1size C0size" << C1Vec.size() << C0Vec.size();
-      for ( int jj = 0; jj < Nx; jj++ ) C0[ jj ] = C1[ jj ];
+      if ( ! float_flag )
+         for ( int jj = 0; jj < Nx; jj++ ) C0[ jj ] = C1[ jj ];
 //DbgLv(2) << "RSA:           (7) ii" << ii;
 
 #ifndef NO_DB
@@ -1767,6 +1822,9 @@ ttT6+=(clcSt6.msecsTo(clcSt7));
          qApp->processEvents();
          if ( stopFlag ) break;
 
+         if ( float_flag )
+            for ( int jj = 0; jj < Nx; jj++ ) C0[ jj ] = (double)C0f[ jj ];
+
          emit new_scan( &x, C0 );
          emit new_time( simscan.time );
          qApp->processEvents();
@@ -1780,6 +1838,8 @@ ttT7+=(clcSt7.msecsTo(clcSt3));
 //DbgLv(2) << "RSA:   ii ltsteps" << ii << ltsteps;
       if ( ii == ltsteps )
       {
+         nsteps_taken       += nisteps;
+         nsteps_fixed       += nisteps;
          C_init.radius       .clear();
          C_init.concentration.clear();
          C_init.radius       .reserve( Nx );
@@ -1787,7 +1847,8 @@ ttT7+=(clcSt7.msecsTo(clcSt3));
          for ( int jj = 0; jj < Nx; jj++ )
          {
             C_init.radius        .append( x [ jj ] );
-            C_init.concentration .append( C1[ jj ] );
+            C_init.concentration .append( float_flag ? (double)C0f[ jj ]
+                                                     : C1[ jj ] );
          }
       }
    } // time loop
@@ -1799,6 +1860,7 @@ clcSt8 = QDateTime::currentDateTime();
 #ifndef NO_DB
    emit new_time( simscan.time );
    qApp->processEvents();
+#endif
    US_AstfemMath::clear_2d( 3, CA );
    US_AstfemMath::clear_2d( 3, CB );
 
@@ -1809,7 +1871,6 @@ clcSt8 = QDateTime::currentDateTime();
       US_AstfemMath::clear_2d( 3, CA2 );
       US_AstfemMath::clear_2d( 3, CB2 );
    }
-#endif
 //DbgLv(2) << "RSA: calc_ni() RETURN Nx" << Nx << "C_init[0] C_init[n]"
 // << C_init.concentration[0] << C_init.concentration[Nx-1];
 
@@ -1839,11 +1900,241 @@ if((nccall%1000)==0) {
 }
 #endif
 DbgLv(2) << "RSA: CALC_NI END - simdata scans points rss"
- << simdata.scan.size() << simdata.scan[0].conc.size() << US_Memory::rss_now();
+ << simdata.scan.size() << Nx << US_Memory::rss_now();
 
    return 0;
 }
 
+// Save a simulation scan of the current time loop. When streaming, the
+//  experiment scans at or before it are interpolated from it and the
+//  previous scan, so that only those two scans are held.
+void US_Astfem_RSA::store_scan( US_AstfemMath::MfemData& simdata,
+                                US_AstfemMath::MfemScan& simscan )
+{
+   if ( ! stream_out )
+   {
+      simdata.scan.append( simscan );
+      return;
+   }
+
+   if ( stream_error < 0 )
+      return;                 // Failed earlier in this time loop
+
+   int    nescan  = af_data.scan.size();
+   double s_key   = use_time ? simscan.time : simscan.omega_s_t;
+
+   if ( stream_nscan == 0 )
+   {  // Skip experiment scans before the start of this time loop
+      while ( stream_escan < nescan  &&
+              ( use_time ? af_data.scan[ stream_escan ].time
+                         : af_data.scan[ stream_escan ].omega_s_t ) < s_key )
+         stream_escan++;
+   }
+
+   while ( stream_escan < nescan  &&
+           ( use_time ? af_data.scan[ stream_escan ].time
+                      : af_data.scan[ stream_escan ].omega_s_t ) <= s_key )
+   {
+      US_AstfemMath::MfemScan& sscan1 = ( stream_nscan > 0 ) ? stream_prev
+                                                             : simscan;
+      stream_error   = US_AstfemMath::interpolate_scan( af_data,
+                          stream_escan, simdata.radius, sscan1, simscan,
+                          use_time );
+
+      if ( stream_error < 0 )
+         return;
+
+      stream_escan++;
+   }
+
+   stream_prev   = simscan;
+   stream_nscan++;
+}
+
+// One Crank-Nicolson step on a fixed grid:  solve CA C1 = -CB C0
+static void fixed_grid_step( double** CA, double** CB, const double* C0,
+                             double* rhs, double* C1, int Nx )
+{
+   rhs[ 0 ]       = - CB[ 1 ][ 0 ] * C0[ 0 ] - CB[ 2 ][ 0 ] * C0[ 1 ];
+
+   for ( int jj = 1; jj < Nx - 1; jj++ )
+   {
+      rhs[ jj ]      = - CB[ 0 ][ jj ] * C0[ jj - 1 ]
+                       - CB[ 1 ][ jj ] * C0[ jj     ]
+                       - CB[ 2 ][ jj ] * C0[ jj + 1 ];
+   }
+
+   int jj         = Nx - 1;
+   rhs[ jj ]      = - CB[ 0 ][ jj ] * C0[ jj - 1 ] - CB[ 1 ][ jj ] * C0[ jj ];
+
+   US_AstfemMath::tridiag( CA[ 0 ], CA[ 1 ], CA[ 2 ], rhs, C1, Nx );
+}
+
+// Time evolution of calculate_ni() on a fixed grid with error-controlled
+//  step sizes. Each step of size h is compared to two steps of h/2, and
+//  the two-step result is kept if the estimated local error, relative to
+//  the peak concentration, is within simparams.dt_tolerance. The next h
+//  is scaled from that estimate, so steps grow as the boundary spreads.
+//  Steps are never shorter than two fixed-size steps, and they end on
+//  experiment scan times so that scans are not interpolated across a
+//  long step. Scans and C_init cover the same times as fixed steps.
+void US_Astfem_RSA::adaptive_ni( double rpm, double* C0,
+      US_AstfemMath::MfemInitial& C_init, US_AstfemMath::MfemData& simdata )
+{
+   double dt_fix   = af_params.dt;
+   double tol      = simparams.dt_tolerance;
+   double omega_s  = sq( rpm * M_PI / 30.0 );
+   double sw2      = af_params.s[ 0 ] * omega_s;
+   double Dcoef    = af_params.D[ 0 ];
+   int    ntsteps  = af_params.time_steps;
+   double t_init   = af_params.start_time + ( ntsteps + 1 ) * dt_fix;
+   double t_end    = af_params.start_time + ( ntsteps + 2 ) * dt_fix;
+   double t_eps    = dt_fix * 1.0e-6;
+   double h_min    = 2.0 * dt_fix;
+   double h_next   = h_min;
+   double h_mats   = -1.0;       // Step size of current matrices
+   double time     = af_params.start_time;
+   int    nescan   = af_data.scan.size();
+   int    escan    = 0;
+   int    naccept  = 0;
+   int    nreject  = 0;
+   bool   have_init = false;
+
+   double** CAf;                 // Matrices for a full step
+   double** CBf;
+   double** CAh;                 // Matrices for a half step
+   double** CBh;
+   US_AstfemMath::initialize_2d( 3, Nx, &CAf );
+   US_AstfemMath::initialize_2d( 3, Nx, &CBf );
+   US_AstfemMath::initialize_2d( 3, Nx, &CAh );
+   US_AstfemMath::initialize_2d( 3, Nx, &CBh );
+
+   QVector< double > CfVec( Nx );
+   QVector< double > ChVec( Nx );
+   QVector< double > rhVec( Nx );
+   double* Cf      = CfVec.data();
+   double* Ch      = ChVec.data();
+   double* rhs     = rhVec.data();
+
+   US_AstfemMath::MfemScan simscan;
+   simscan.rpm          = (int)rpm;
+   simscan.temperature  = af_data.scan[ 0 ].temperature;
+
+   while ( true )
+   {
+      // Record the state at the current time
+      w2t_integral += ( time - last_time ) * omega_s;
+      last_time     = time;
+      simscan.time  = time;
+      simscan.omega_s_t = w2t_integral;
+      simscan.conc.clear();
+      simscan.conc.reserve( Nx );
+
+      for ( int jj = 0; jj < Nx; jj++ )
+         simscan.conc.append( C0[ jj ] );
+
+      store_scan( simdata, simscan );
+
+      if ( time >= ( t_end - t_eps )  ||  stopFlag )
+         break;
+
+      // End the step at the next experiment scan, C_init time, or end time
+      double t_stop = have_init ? t_end : t_init;
+
+      while ( escan < nescan  &&  af_data.scan[ escan ].time <= time + t_eps )
+         escan++;
+
+      if ( escan < nescan  &&  af_data.scan[ escan ].time < t_stop )
+         t_stop        = af_data.scan[ escan ].time;
+
+      while ( true )
+      {
+         double hstep  = qMin( h_next, t_stop - time );
+
+         if ( hstep != h_mats )
+         {  // Coefficient matrices for the full and half step sizes
+            af_params.dt  = hstep;
+            ComputeCoefMatrixFixedMesh( Dcoef, sw2, CAf, CBf );
+            af_params.dt  = hstep * 0.5;
+            ComputeCoefMatrixFixedMesh( Dcoef, sw2, CAh, CBh );
+            af_params.dt  = dt_fix;
+            h_mats        = hstep;
+         }
+
+         fixed_grid_step( CAf, CBf, C0, rhs, Cf, Nx );
+         fixed_grid_step( CAh, CBh, C0, rhs, Ch, Nx );
+         fixed_grid_step( CAh, CBh, Ch, rhs, Ch, Nx );
+
+         // Local error of the two half steps, by Richardson's estimate
+         double cmax   = 0.0;
+         double dmax   = 0.0;
+
+         for ( int jj = 0; jj < Nx; jj++ )
+         {
+            cmax          = qMax( cmax, qAbs( Ch[ jj ] ) );
+            dmax          = qMax( dmax, qAbs( Ch[ jj ] - Cf[ jj ] ) );
+         }
+
+         double error  = ( cmax > 0.0 ) ? ( dmax / ( 3.0 * cmax ) ) : 0.0;
+         double factor = ( error > 0.0 ) ? ( 0.9 * pow( tol / error, 1.0 / 3.0 ) )
+                                         : 4.0;
+
+         if ( error <= tol  ||  hstep <= h_min * ( 1.0 + 1.0e-9 ) )
+         {  // Accept the step and choose the next size
+            for ( int jj = 0; jj < Nx; jj++ )
+               C0[ jj ]      = Ch[ jj ];
+
+            time          = ( ( t_stop - time ) <= hstep ) ? t_stop
+                                                           : ( time + hstep );
+            factor        = qBound( 1.0, factor, 4.0 );
+            h_next        = qMax( h_next, hstep * factor );
+            naccept++;
+            break;
+         }
+
+         // Reject the step and retry with a smaller one
+         h_next        = qMax( h_min, hstep * qBound( 0.2, factor, 0.9 ) );
+         nreject++;
+      }
+
+      if ( ! have_init  &&  time >= ( t_init - t_eps ) )
+      {  // Save the state where the next speed step starts
+         have_init     = true;
+         C_init.radius       .clear();
+         C_init.concentration.clear();
+         C_init.radius       .reserve( Nx );
+         C_init.concentration.reserve( Nx );
+
+         for ( int jj = 0; jj < Nx; jj++ )
+         {
+            C_init.radius        .append( x [ jj ] );
+            C_init.concentration .append( C0[ jj ] );
+         }
+      }
+
+#ifndef NO_DB
+      if ( show_movie )
+      {
+         qApp->processEvents();
+         emit new_scan( &x, C0 );
+         emit new_time( time );
+         qApp->processEvents();
+      }
+#endif
+   }
+
+   US_AstfemMath::clear_2d( 3, CAf );
+   US_AstfemMath::clear_2d( 3, CBf );
+   US_AstfemMath::clear_2d( 3, CAh );
+   US_AstfemMath::clear_2d( 3, CBh );
+
+   nsteps_taken += naccept;
+   nsteps_fixed += ntsteps + 3;
+DbgLv(1) << "RSA:adapt: steps taken,rejected" << naccept << nreject
+ << "fixed-dt steps" << ( ntsteps + 3 ) << "tolerance" << tol
+ << "final h/dt" << ( h_next / dt_fix );
+}
+
 void US_Astfem_RSA::mesh_gen( QVector< double >& nu, int MeshOpt )
 {
 //////////////////////////////////////////////////////////////%
@@ -1870,6 +2161,17 @@ void US_Astfem_RSA::mesh_gen( QVector< double >& nu, int MeshOpt )
    double b  = af_params.current_bottom;
    int    Np = af_params.simpoints;
 
+   gentry    = NULL;
+
+   if ( agrid != NULL  &&  US_AstfemGrid::shared_mesh( MeshOpt ) )
+   {  // Borrow the solute-independent mesh from the shared grid context
+      gentry    = agrid->entry( m, b, Np );
+      x         = gentry->x;
+      Nx        = x.size();
+      xA        = x.data();
+      return;
+   }
+
    x.clear();
    x.reserve( Np * 2 + 2 );
 
@@ -1903,60 +2205,11 @@ void US_Astfem_RSA::mesh_gen( QVector< double >& nu, int MeshOpt )
          break;
 
       case (int)US_SimulationParameters::CLAVERIE:
-         // Claverie mesh without left hand refinement
-
-         for ( int i = 0; i < Np; i++ )
-            x .append( m + ( b - m ) * i / ( Np - 1 ) );
-         break;
-
       case (int)US_SimulationParameters::MOVING_HAT:
-         // Moving Hat (Peter Schuck's Mesh) w/o left hand side refinement
-
-         x .append( m );
-
-         // Standard Schuck grids
-         for ( int i = 1; i < Np - 1; i++ )
-            x .append( m * pow( b / m, ( i - 0.5 ) / ( Np - 1 ) ) );
-
-         x .append( b );
-         break;
-
       case (int)US_SimulationParameters::USER:
-         // User defined mesh generated from data file
-         {
-            QFile f( US_Settings::appBaseDir() + "/etc/mesh.dat" );
-
-            if ( f.open( QIODevice::ReadOnly ) )
-            {
-               QTextStream ts( &f );
-
-               while ( ! ts.atEnd() )  x .append( ts.readLine().toDouble() );
-
-               f.close();
-
-               if ( qAbs( x[ 0 ] - m ) > 1.0e7 )
-               {
-                  DbgErr() << "The meniscus from the mesh file does not"
-                     " match the set meniscus - using Claverie Mesh instead\n";
-               }
-
-               if ( qAbs( x[ x.size() - 1 ] - b ) > 1.0e7 )
-               {
-                  DbgErr() << "The cell bottom from the mesh file does not"
-                     " match the set cell bottom - using Claverie Mesh"
-                     " instead\n";
-               }
-            }
-            else
-            {
-               DbgErr() << "Could not read the mesh file - "
-                           "using Claverie Mesh instead\n";
-
-               for ( int i = 0; i < af_params.simpoints; i++ )
-                  x .append( m + ( b - m ) * i / ( Np - 1 ) );
-            }
-            break;
-         }
+         // Meshes that depend only on the grid limits
+         US_AstfemGrid::fixed_mesh( MeshOpt, m, b, Np, x );
+         break;
 
       case (int)US_SimulationParameters::ASTFVM:
          // Adaptive Space Time Finite Volume Method
@@ -2303,6 +2556,7 @@ void US_Astfem_RSA::mesh_gen_s_neg( const QVector< double >& nu )
 
 void US_Astfem_RSA::mesh_gen_RefL( int N0, int M0 )
 {
+   gentry = NULL;     // Refined mesh is no longer the shared one
    const double PIhalf   = M_PI / 2.0;
    QVector< double > zz;  // temporary array for adaptive grids
    double*           zA;
@@ -2387,24 +2641,16 @@ void US_Astfem_RSA::ComputeCoefMatrixFixedMesh(
       DbgErr() << "***FixedMesh ERROR*** Nx x.size" << Nx << x.size()
          << " params.s[0] D sw2" << af_params.s[0] << D << sw2;
 
-#ifdef NO_DB
-   static int       Nsave = 0;
-   static double*** Stif  = NULL;
    xA = x.data();
 
-   if ( Nx > Nsave )
-   {
-      if ( Nsave > 0 )
-         US_AstfemMath::clear_3d( Nsave, 4, Stif );
-
-      Nsave = Nx + 200;
-      US_AstfemMath::initialize_3d( Nsave, 4, 4, &Stif );
-//qDebug() << "FixedMesh   Nsave" << Nsave;
+   if ( gentry != NULL  &&  gentry->x.size() == Nx  &&
+        gentry->coefficients( af_params.dt, D, sw2, CA, CB ) )
+   {  // Matrices composed from the shared grid context terms
+      return;
    }
-#else
+
    double*** Stif  = NULL;
    US_AstfemMath::initialize_3d( Nx, 4, 4, &Stif );
-#endif
 
    double xd[ 4 ][ 2 ];     // coord for vertices of quad elem
 
@@ -2423,40 +2669,9 @@ void US_Astfem_RSA::ComputeCoefMatrixFixedMesh(
    }
 
    // Assemble coefficient matrices
-   // elem[ 0 ]; i=0
-   int k = 0;
-   int m = 0;
-   CA[ 1 ][ k ] = Stif[ k ][ 3 ][ 0 ] + Stif[ k ][ 3 ][ 3 ]; // j=3;
-   CA[ 2 ][ k ] = Stif[ k ][ 2 ][ 0 ] + Stif[ k ][ 2 ][ 3 ]; // j=2;
-   CB[ 1 ][ k ] = Stif[ k ][ 0 ][ 0 ] + Stif[ k ][ 0 ][ 3 ]; // j=0;
-   CB[ 2 ][ k ] = Stif[ k ][ 1 ][ 0 ] + Stif[ k ][ 1 ][ 3 ]; // j=1;
-
-   for ( k = 1, m = 0; k < Nx - 1; k++, m++ )
-   {  // loop for all elem
-      // elem k-1: i=1,2
-      CA[ 0 ][ k ]  = Stif[ m ][ 3 ][ 1 ] + Stif[ m ][ 3 ][ 2 ];  // j=3;
-      CA[ 1 ][ k ]  = Stif[ m ][ 2 ][ 1 ] + Stif[ m ][ 2 ][ 2 ];  // j=2;
-      CB[ 0 ][ k ]  = Stif[ m ][ 0 ][ 1 ] + Stif[ m ][ 0 ][ 2 ];  // j=0;
-      CB[ 1 ][ k ]  = Stif[ m ][ 1 ][ 1 ] + Stif[ m ][ 1 ][ 2 ];  // j=1;
-
-      // elem k: i=0,3
-      CA[ 1 ][ k ] += Stif[ k ][ 3 ][ 0 ] + Stif[ k ][ 3 ][ 3 ];  // j=3;
-      CA[ 2 ][ k ]  = Stif[ k ][ 2 ][ 0 ] + Stif[ k ][ 2 ][ 3 ];  // j=2;
-      CB[ 1 ][ k ] += Stif[ k ][ 0 ][ 0 ] + Stif[ k ][ 0 ][ 3 ];  // j=0;
-      CB[ 2 ][ k ]  = Stif[ k ][ 1 ][ 0 ] + Stif[ k ][ 1 ][ 3 ];  // j=1;
-   }
-
-   // elem[ Nx-2 ]; i=1,2
-   k = Nx - 1;
-   m = k  - 1;
-   CA[ 0 ][ k ]  = Stif[ m ][ 3 ][ 1 ] + Stif[ m ][ 3 ][ 2 ];  // j=3;
-   CA[ 1 ][ k ]  = Stif[ m ][ 2 ][ 1 ] + Stif[ m ][ 2 ][ 2 ];  // j=2;
-   CB[ 0 ][ k ]  = Stif[ m ][ 0 ][ 1 ] + Stif[ m ][ 0 ][ 2 ];  // j=0;
-   CB[ 1 ][ k ]  = Stif[ m ][ 1 ][ 1 ] + Stif[ m ][ 1 ][ 2 ];  // j=1;
+   US_AstfemGrid::assemble_fixed( Nx, Stif, CA, CB );
 
-#ifndef NO_DB
    US_AstfemMath::clear_3d( Nx, 4, Stif );
-#endif
 int mm=Nx/2;
 DbgLv(2) << "RSA:CCMFM: CA0 sme" << CA[0][0] << CA[0][1] << CA[0][2]
  << CA[0][mm-1] << CA[0][mm] << CA[0][mm+1] << CA[0][mm+2]
@@ -2479,23 +2694,8 @@ void US_Astfem_RSA::ComputeCoefMatrixMovingMeshR(
    double       xd[ 4 ][ 2 ]; // coord for verices of quad elem
    xA = x.data();
 
-#ifdef NO_DB
-   static int       Nsave = 0;
-   static double*** Stif  = NULL;
-
-   if ( Nx > Nsave )
-   {
-      if ( Nsave > 0 )
-         US_AstfemMath::clear_3d( Nsave, 4, Stif );
-
-      Nsave = Nx + 200;
-      US_AstfemMath::initialize_3d( Nsave, 4, 4, &Stif );
-//qDebug() << "MovMeshR   Nsave" << Nsave;
-   }
-#else
    double*** Stif  = NULL;
    US_AstfemMath::initialize_3d( Nx, 4, 4, &Stif );
-#endif
 
    // elem[0]: triangle
    xd[ 0 ][ 0 ] = xA[ 0 ];  xd[ 0 ][ 1 ] = 0.;
@@ -2566,9 +2766,7 @@ void US_Astfem_RSA::ComputeCoefMatrixMovingMeshR(
    CB[ 1 ][ k ] += Stif[ k  ][0][0] + Stif[ k  ][0][1] + Stif[ k ][0][2];
    CB[ 2 ][ k ]  = Stif[ k  ][1][0] + Stif[ k  ][1][1] + Stif[ k ][1][2];
 
-#ifndef NO_DB
    US_AstfemMath::clear_3d( Nx, 4, Stif );
-#endif
 }
 
 void US_Astfem_RSA::ComputeCoefMatrixMovingMeshL(
@@ -2578,22 +2776,8 @@ void US_Astfem_RSA::ComputeCoefMatrixMovingMeshL(
    double       xd[4][2];   // coord for verices of quad elem
    xA = x.data();
 
-#ifdef NO_DB
-   static int       Nsave = 0;
-   static double*** Stif  = NULL;
-
-   if ( Nx > Nsave )
-   {
-      if ( Nsave > 0 )
-         US_AstfemMath::clear_3d( Nsave, 4, Stif );
-
-      Nsave = Nx + 200;
-      US_AstfemMath::initialize_3d( Nsave, 4, 4, &Stif );
-   }
-#else
    double*** Stif  = NULL;
    US_AstfemMath::initialize_3d( Nx, 4, 4, &Stif );
-#endif
 
    // elem[0]: triangle
    xd[0][0] = xA[0];
@@ -2663,9 +2847,7 @@ void US_Astfem_RSA::ComputeCoefMatrixMovingMeshL(
    CA[1][k]  = Stif[k  ][1][1] ;
    CB[0][k]  = Stif[k  ][0][1] ;
 
-#ifndef NO_DB
    US_AstfemMath::clear_3d( Nx, 4, Stif );
-#endif
 }
 
 // Given total concentration of a group of components involved,
@@ -3212,7 +3394,8 @@ int US_Astfem_RSA::calculate_ra2( double rpm_start, double rpm_stop,
    simdata.radius.clear();
    simdata.scan  .clear();
    simdata.radius.reserve( Nx );
-   simdata.scan  .reserve( Nx );
+   if ( ! stream_out )
+      simdata.scan  .reserve( Nx );
    xA        = x.data();
 DbgLv(2) << "RSA:_ra2: Mcomp Nx" << Mcomp << Nx << "x size" << x.size()
  << "D0 nu0 D1 nu1" << af_params.D[0] << nu[0] << af_params.D[1] << nu[1];
@@ -3287,9 +3470,12 @@ DbgLv(2) << "RSA:_ra2:(4) Nx" << Nx << "x size" << x.size();
    double*** CB1;
    double*** CB2;
 
-   // Initialize the coefficient matrices
+   // Initialize the coefficient matrices, released on any return
+   US_AstfemMath::ArenaScope mscope;
    US_AstfemMath::initialize_3d( Mcomp, 4, Nx, &CA );
    US_AstfemMath::initialize_3d( Mcomp, 4, Nx, &CB );
+   mscope.add( CA );
+   mscope.add( CB );
 
    if ( accel ) //  Acceleration, so use fixed grid
    {
@@ -3297,6 +3483,10 @@ DbgLv(2) << "RSA:_ra2:(4) Nx" << Nx << "x size" << x.size();
       US_AstfemMath::initialize_3d( Mcomp, 3, Nx, &CA2 );
       US_AstfemMath::initialize_3d( Mcomp, 3, Nx, &CB1 );
       US_AstfemMath::initialize_3d( Mcomp, 3, Nx, &CB2 );
+      mscope.add( CA1 );
+      mscope.add( CA2 );
+      mscope.add( CB1 );
+      mscope.add( CB2 );
 
       for( int i = 0; i < Mcomp; i++ )
       {
@@ -3388,6 +3578,8 @@ DbgLv(2) << "RSA: smin>0:GlStf: CB[i]:" << CB[i][0][0] << CB[i][1][0]
 DbgLv(2) << "RSA:_ra2:(6) Nx" << Nx << "x size" << x.size();
    US_AstfemMath::initialize_2d( Mcomp, Nx, &C0 );
    US_AstfemMath::initialize_2d( Mcomp, Nx, &C1 );
+   mscope.add( C0 );
+   mscope.add( C1 );
 
    // Here we need the interpolate the initial partial
    // concentration onto new grid x[j]
@@ -3419,7 +3611,45 @@ DbgLv(2) << "RSA: newX3 Nx" << Nx << "C0[00] C0[m0] C0[0n] C0[mn]"
 DbgLv(2) << "RSA: newX3  CT0 CTn" << CT1[0] << CT1[Nx-1];
 
    // Time evolution
+   //  The banded systems of all components, which share the mesh and time
+   //  steps, are solved together in structure-of-arrays form
+   bool    tridiagonal = ( accel || fixedGrid );
+   int     nband   = tridiagonal ? 3 : 4;
+   int     nsoa    = Nx * Mcomp;
+   QVector< double > saVec( nband * nsoa );   // CA bands, interleaved
+   QVector< double > sbVec( nband * nsoa );   // CB bands, interleaved
+   QVector< double > soVec( nsoa );           // Interleaved solution
+   QVector< double > sa1Vec;
+   QVector< double > sa2Vec;
+   QVector< double > sb1Vec;
+   QVector< double > sb2Vec;
+   double* sa      = saVec.data();
+   double* sb      = sbVec.data();
+   double* solv    = soVec.data();
+   rhVec.resize( nsoa );
    double* right_hand_side = rhVec.data();
+
+   if ( accel )
+   {  // Interleave the end-point matrices to be interpolated each step
+      sa1Vec.resize( nband * nsoa );
+      sa2Vec.resize( nband * nsoa );
+      sb1Vec.resize( nband * nsoa );
+      sb2Vec.resize( nband * nsoa );
+      pack_bands( CA1, nband, Mcomp, sa1Vec.data() );
+      pack_bands( CA2, nband, Mcomp, sa2Vec.data() );
+      pack_bands( CB1, nband, Mcomp, sb1Vec.data() );
+      pack_bands( CB2, nband, Mcomp, sb2Vec.data() );
+   }
+   else
+   {  // Interleave the constant matrices
+      pack_bands( CA,  nband, Mcomp, sa );
+      pack_bands( CB,  nband, Mcomp, sb );
+   }
+   const double* sa1 = sa1Vec.data();
+   const double* sa2 = sa2Vec.data();
+   const double* sb1 = sb1Vec.data();
+   const double* sb2 = sb2Vec.data();
+   int     nbsoa   = nband * nsoa;
 #ifndef NO_DB
    int     stepinc = 1000;
    int     stepmax = ( Nt + 2 ) / stepinc + 1;
@@ -3462,7 +3692,7 @@ DbgLv(2) << "RSA: Nx CT0size" << Nx << CT0vec.size() << "step-scan"
 DbgLv(2) << "TMS:RSA:ra:  kkk" << kkk << "CT0[0] CT0[n]"
  << CT0[0] << CT0[Nx-1] << "accel fixedGrid" << accel << fixedGrid;
 
-      simdata.scan .append( simscan );
+      store_scan( simdata, simscan );
 
       // First half step of sedimentation:
 
@@ -3470,94 +3700,15 @@ DbgLv(2) << "TMS:RSA:ra:  kkk" << kkk << "CT0[0] CT0[n]"
       {
          double dval = sq( rpm_current / rpm_stop );
 
-         for ( int i = 0; i < Mcomp; i++ )
+         for ( int k = 0; k < nbsoa; k++ )
          {
-            for ( int j1 = 0; j1 < 3; j1++ )
-            {
-               for ( int j2 = 0; j2 < Nx; j2++ )
-               {
-                  CA[ i ][ j1 ][ j2 ] = CA1[ i ][ j1 ][ j2 ] +
-                               dval * ( CA2[ i ][ j1 ][ j2 ] -
-                                        CA1[ i ][ j1 ][ j2 ] );
-
-                  CB[ i ][ j1 ][ j2 ] = CB1[ i ][ j1 ][ j2 ] +
-                               dval * ( CB2[ i ][ j1 ][ j2 ] -
-                                        CB1[ i ][ j1 ][ j2 ] );
-               }
-            }
+            sa[ k ] = sa1[ k ] + dval * ( sa2[ k ] - sa1[ k ] );
+            sb[ k ] = sb1[ k ] + dval * ( sb2[ k ] - sb1[ k ] );
          }
       }
 
-      if ( accel || fixedGrid )    // For fixed grid
-      {
-         for ( int i = 0; i < Mcomp; i++ )
-         {
-            right_hand_side[ 0 ] = - CB[ i ][ 1 ][ 0 ] * C0[ i ][ 0 ]
-                                   - CB[ i ][ 2 ][ 0 ] * C0[ i ][ 1 ];
-
-            for ( int j = 1; j < Nx - 1; j++ )
-            {
-               right_hand_side[ j ] = - CB[ i ][ 0 ][ j ] * C0[ i ][ j - 1 ]
-                                      - CB[ i ][ 1 ][ j ] * C0[ i ][ j     ]
-                                      - CB[ i ][ 2 ][ j ] * C0[ i ][ j + 1 ];
-            }
-
-            int j = Nx - 1;
-
-            right_hand_side[ j ] = -CB[ i ][ 0 ][ j ] * C0[ i ][ j - 1 ]
-                                  - CB[ i ][ 1 ][ j ] * C0[ i ][ j     ];
-
-            US_AstfemMath::tridiag( CA[ i ][ 0 ], CA[ i ][ 1 ], CA[ i ][ 2 ],
-                                    right_hand_side, C1[ i ], Nx );
-         }
-      }
-
-      else // Moving grid
-      {
-//DbgLv(2) << "TMS:RSA:ra:   (0)MovGrid: C0[00] C0[0n] C0[m0] C0[1n]"
-// << C0[0][0] << C0[0][Nx-1] << C0[Mcomp-1][0] << C0[Mcomp-1][Nx-1];
-//DbgLv(2) << "TMS:RSA:ra:   (0)MovGrid: C1[00] C1[0n] C1[m0] C1[1n]"
-// << C1[0][0] << C1[0][Nx-1] << C1[Mcomp-1][0] << C1[Mcomp-1][Nx-1];
-         for ( int i = 0; i < Mcomp; i++ )
-         {
-            // Calculate the right hand side vector
-            right_hand_side[ 0 ] = - CB[ i ][ 2 ][ 0 ] * C0[ i ][ 0 ]
-                                   - CB[ i ][ 3 ][ 0 ] * C0[ i ][ 1 ];
-
-            right_hand_side[ 1 ] = - CB[ i ][ 1 ][ 1 ] * C0[ i ][ 0 ]
-                                   - CB[ i ][ 2 ][ 1 ] * C0[ i ][ 1 ]
-                                   - CB[ i ][ 3 ][ 1 ] * C0[ i ][ 2 ];
-
-            for ( int j = 2; j < Nx - 1; j++ )
-            {
-               right_hand_side[ j ] = - CB[ i ][ 0 ][ j ] * C0[ i ][ j - 2 ]
-                                      - CB[ i ][ 1 ][ j ] * C0[ i ][ j - 1 ]
-                                      - CB[ i ][ 2 ][ j ] * C0[ i ][ j     ]
-                                      - CB[ i ][ 3 ][ j ] * C0[ i ][ j + 1 ];
-            }
-
-            int j = Nx - 1;
-            right_hand_side[ j ] = - CB[ i ][ 0 ][ j ] * C0[ i ][ j - 2 ]
-                                   - CB[ i ][ 1 ][ j ] * C0[ i ][ j - 1 ]
-                                   - CB[ i ][ 2 ][ j ] * C0[ i ][ j     ];
-
-DbgLv(2) << "TMS:RSA:ra:   MovGrid:  i" << i << "CB[0]" << CB[i][2][0]
- << CB[i][3][0] << CB[i][1][1] << CB[i][2][1] << CB[i][3][1];
-DbgLv(2) << "TMS:RSA:ra:   MovGrid:   i" << i << "CA[0]" << CA[i][0][0]
- << CA[i][1][0] << CA[i][0][0] << CA[i][1][0] << CA[i][2][0];
-            US_AstfemMath::QuadSolver( CA[ i ][ 0 ], CA[ i ][ 1 ], CA[ i ][ 2 ],
-                                       CA[ i ][ 3 ], right_hand_side, C1[ i ],
-                                       Nx );
-DbgLv(2) << "TMS:RSA:ra:   MovGrid:    i" << i << "C1[i]" << C1[i][0]
- << C1[i][Nx-4] << C1[i][Nx-3] << C1[i][Nx-2] << C1[i][Nx-1];
-DbgLv(2) << "TMS:RSA:ra:   MovGrid:    i" << i << "C0[i]" << C0[i][0]
- << C0[i][Nx-4] << C0[i][Nx-3] << C0[i][Nx-2] << C0[i][Nx-1];
-         }
-//DbgLv(2) << "TMS:RSA:ra:   MovGrid: CA[000] rs[0]" << CA[0][0][0]
-// << right_hand_side[0] << "CB[000]" << CB[0][0][0];
-//DbgLv(2) << "TMS:RSA:ra:   MovGrid: C1[00] C1[0n] C1[m0] C1[1n]"
-// << C1[0][0] << C1[0][Nx-1] << C1[Mcomp-1][0] << C1[Mcomp-1][Nx-1];
-      }
+      sediment_step( tridiagonal, Mcomp, sa, sb, C0, C1,
+                     right_hand_side, solv );
 
       // Reaction part: instantaneous reaction at each node
       //
@@ -3595,78 +3746,15 @@ DbgLv(2) << "TMS:RSA:ra(2):   C1[10] C1[11] C1[1k] C1[1n]"
       {
          double dval = sq( rpm_current / rpm_stop );
 
-         for ( int i = 0; i < Mcomp; i++ )
-         {
-            for ( int j1 = 0; j1 < 3; j1++ )
-            {
-               for ( int j2 = 0; j2 < Nx; j2++ )
-               {
-                  CA[ i][ j1 ][ j2 ] = CA1[ i ][ j1 ][ j2 ] +
-                              dval * ( CA2[ i ][ j1 ][ j2 ] -
-                                       CA1[ i ][ j1 ][ j2 ] );
-
-                  CB[ i][ j1 ][ j2 ] = CB1[ i ][ j1 ][ j2 ] +
-                              dval * ( CB2[ i ][ j1 ][ j2 ] -
-                                       CB1[ i ][ j1 ][ j2 ] ) ;
-               }
-            }
-         }
-      }
-
-      if ( accel || fixedGrid )                     // For fixed grid
-      {
-         for ( int i = 0; i < Mcomp; i++ )
+         for ( int k = 0; k < nbsoa; k++ )
          {
-            right_hand_side[ 0 ] = - CB[ i ][ 1 ][ 0 ] * C0[ i ][ 0 ]
-                                   - CB[ i ][ 2 ][ 0 ] * C0[ i ][ 1 ];
-
-            for ( int j = 1; j < Nx - 1; j++ )
-            {
-               right_hand_side[ j ] = - CB[ i ][ 0 ][ j ] * C0[ i ][ j - 1 ]
-                                      - CB[ i ][ 1 ][ j ] * C0[ i ][ j     ]
-                                      - CB[ i ][ 2 ][ j ] * C0[ i ][ j + 1 ];
-            }
-
-            int j = Nx - 1;
-            right_hand_side[ j ] = - CB[ i ][ 0 ][ j ] * C0[ i ][ j - 1 ]
-                                   - CB[ i ][ 1 ][ j ] * C0[ i ][ j     ];
-
-            US_AstfemMath::tridiag( CA[ i ][ 0 ], CA[ i ][ 1 ], CA[ i ][ 2 ],
-                                    right_hand_side, C1[ i ], Nx );
+            sa[ k ] = sa1[ k ] + dval * ( sa2[ k ] - sa1[ k ] );
+            sb[ k ] = sb1[ k ] + dval * ( sb2[ k ] - sb1[ k ] );
          }
       }
-      else // Moving grid
-      {
-         for ( int i = 0; i < Mcomp; i++ )
-         {
-            // Calculate the right hand side vector //
-            right_hand_side[ 0 ] = - CB[ i ][ 2 ][ 0 ] * C0[ i ][ 0 ]
-                                   - CB[ i ][ 3 ][ 0 ] * C0[ i ][ 1 ];
-
-            right_hand_side[ 1 ] = - CB[ i ][ 1 ][ 1 ] * C0[ i ][ 0 ]
-                                   - CB[ i ][ 2 ][ 1 ] * C0[ i ][ 1 ]
-                                   - CB[ i ][ 3 ][ 1 ] * C0[ i ][ 2 ];
-
-            for ( int j = 2; j < Nx - 1; j++ )
-            {
-               right_hand_side[ j ] = - CB[ i ][ 0 ][ j ] * C0[ i ][ j - 2 ]
-                                      - CB[ i ][ 1 ][ j ] * C0[ i ][ j - 1 ]
-                                      - CB[ i ][ 2 ][ j ] * C0[ i ][ j     ]
-                                      - CB[ i ][ 3 ][ j ] * C0[ i ][ j + 1 ];
-            }
-
-            int j = Nx - 1;
-            right_hand_side[ j ] = - CB[ i ][ 0 ][ j ] * C0[ i ][ j - 2 ]
-                                   - CB[ i ][ 1 ][ j ] * C0[ i ][ j - 1 ]
-                                   - CB[ i ][ 2 ][ j ] * C0[ i ][ j     ];
 
-            US_AstfemMath::QuadSolver( CA[ i ][ 0 ], CA[ i ][ 1 ],
-                                       CA[ i ][ 2 ], CA[ i ][ 3 ],
-                                       right_hand_side, C1[ i ], Nx );
-         }
-//DbgLv(2) << "TMS:RSA:ra:   MovGrid: C1[00] C1[0n] C1[m0] C1[1n]"
-// << C1[0][0] << C1[0][Nx-1] << C1[Mcomp-1][0] << C1[Mcomp-1][Nx-1];
-      }
+      sediment_step( tridiagonal, Mcomp, sa, sb, C0, C1,
+                     right_hand_side, solv );
 
       // End of 2nd half step of sedimentation
 
@@ -3726,20 +3814,100 @@ DbgLv(2) << "TMS:RSA:ra2: comp:" << i << "C1[i]:" << C1[i][0] << C1[i][1]
  << C1[i][Nx/2] << C1[i][Nx-3] << C1[i][Nx-2] << C1[i][Nx-1];
    }
 
-   US_AstfemMath::clear_2d(Mcomp, C0);
-   US_AstfemMath::clear_2d(Mcomp, C1);
-   US_AstfemMath::clear_3d(Mcomp, 4, CA);
-   US_AstfemMath::clear_3d(Mcomp, 4, CB);
+   return 0;
+}
+
+// Interleave the first nband bands of per-component coefficient matrices:
+//  element j of band b for component i goes to [ ( b * Nx + j ) * ncomp + i ]
+void US_Astfem_RSA::pack_bands( double*** cm, int nband, int ncomp,
+                                double* soa )
+{
+   for ( int b = 0; b < nband; b++ )
+      for ( int i = 0; i < ncomp; i++ )
+         for ( int j = 0; j < Nx; j++ )
+            soa[ ( b * Nx + j ) * ncomp + i ] = cm[ i ][ b ][ j ];
+}
+
+// One sedimentation (half) step for all components in lockstep:
+//  form the right hand sides from C0 and solve the banded systems into C1
+void US_Astfem_RSA::sediment_step( bool tridiagonal, int ncomp,
+      const double* sa, const double* sb, double** C0, double** C1,
+      double* rhs, double* solv )
+{
+   int nsoa = Nx * ncomp;
+
+   // Interleave the current concentrations
+   for ( int i = 0; i < ncomp; i++ )
+      for ( int j = 0; j < Nx; j++ )
+         solv[ j * ncomp + i ] = C0[ i ][ j ];
+
+   const double* sb0 = sb;
+   const double* sb1 = sb0 + nsoa;
+   const double* sb2 = sb1 + nsoa;
+   const double* g   = solv;
 
-   if ( accel ) // then we have acceleration
+   if ( tridiagonal )    // Fixed grid
    {
-      US_AstfemMath::clear_3d( Mcomp, 3, CA1 );
-      US_AstfemMath::clear_3d( Mcomp, 3, CB1 );
-      US_AstfemMath::clear_3d( Mcomp, 3, CA2 );
-      US_AstfemMath::clear_3d( Mcomp, 3, CB2 );
+      int jl = ( Nx - 1 ) * ncomp;
+
+      for ( int i = 0; i < ncomp; i++ )
+      {
+         rhs[ i ]      = - sb1[ i ] * g[ i ]
+                         - sb2[ i ] * g[ i + ncomp ];
+
+         rhs[ jl + i ] = - sb0[ jl + i ] * g[ jl + i - ncomp ]
+                         - sb1[ jl + i ] * g[ jl + i         ];
+      }
+
+      for ( int k = ncomp; k < jl; k++ )
+      {
+         rhs[ k ] = - sb0[ k ] * g[ k - ncomp ]
+                    - sb1[ k ] * g[ k         ]
+                    - sb2[ k ] * g[ k + ncomp ];
+      }
+
+      US_AstfemMath::tridiag_batch( sa, sa + nsoa, sa + 2 * nsoa,
+                                    rhs, solv, Nx, ncomp );
    }
 
-   return 0;
+   else                  // Moving grid
+   {
+      const double* sb3 = sb2 + nsoa;
+      int jl = ( Nx - 1 ) * ncomp;
+      int n2 = 2 * ncomp;
+
+      for ( int i = 0; i < ncomp; i++ )
+      {
+         int k  = ncomp + i;
+
+         rhs[ i ]      = - sb2[ i ] * g[ i ]
+                         - sb3[ i ] * g[ i + ncomp ];
+
+         rhs[ k ]      = - sb1[ k ] * g[ k - ncomp ]
+                         - sb2[ k ] * g[ k         ]
+                         - sb3[ k ] * g[ k + ncomp ];
+
+         rhs[ jl + i ] = - sb0[ jl + i ] * g[ jl + i - n2    ]
+                         - sb1[ jl + i ] * g[ jl + i - ncomp ]
+                         - sb2[ jl + i ] * g[ jl + i         ];
+      }
+
+      for ( int k = n2; k < jl; k++ )
+      {
+         rhs[ k ] = - sb0[ k ] * g[ k - n2    ]
+                    - sb1[ k ] * g[ k - ncomp ]
+                    - sb2[ k ] * g[ k         ]
+                    - sb3[ k ] * g[ k + ncomp ];
+      }
+
+      US_AstfemMath::QuadSolver_batch( sa, sa + nsoa, sa + 2 * nsoa,
+                                       sa + 3 * nsoa, rhs, solv, Nx, ncomp );
+   }
+
+   // De-interleave the new concentrations
+   for ( int i = 0; i < ncomp; i++ )
+      for ( int j = 0; j < Nx; j++ )
+         C1[ i ][ j ] = solv[ j * ncomp + i ];
 }
 
 void US_Astfem_RSA::GlobalStiff( double* xb, double** ca,
@@ -3858,6 +4026,84 @@ void US_Astfem_RSA::GlobalStiff( double* xb, double** ca,
    US_AstfemMath::clear_3d( Nx, 6, Stif );
 }
 
+// Simulate a model in both double and single precision on the grid of
+//  given data and return the RMSD (and maximum) of their difference.
+//  The data is returned with the single precision simulation.
+double US_Astfem_RSA::compare_precision( US_Model& model,
+      US_SimulationParameters& params, US_DataIO::RawData& sim_data,
+      double& maxdiff )
+{
+   US_DataIO::RawData dsim = sim_data;
+   int    nscans   = dsim.scanCount();
+   int    npoints  = dsim.pointCount();
+
+   for ( int ss = 0; ss < nscans; ss++ )
+      dsim.scanData[ ss ].rvalues.fill( 0.0, npoints );
+
+   US_DataIO::RawData fsim = dsim;
+
+   US_Astfem_RSA astfem_d( model, params );
+   astfem_d.calculate( dsim );
+
+   US_Astfem_RSA astfem_f( model, params );
+   astfem_f.set_float_flag( true );
+   astfem_f.calculate( fsim );
+
+   double sumsq    = 0.0;
+   maxdiff         = 0.0;
+
+   for ( int ss = 0; ss < nscans; ss++ )
+   {
+      const double* dvals = dsim.scanData[ ss ].rvalues.constData();
+      const double* fvals = fsim.scanData[ ss ].rvalues.constData();
+
+      for ( int rr = 0; rr < npoints; rr++ )
+      {
+         double diff     = fvals[ rr ] - dvals[ rr ];
+         sumsq          += sq( diff );
+         maxdiff         = qMax( maxdiff, qAbs( diff ) );
+      }
+   }
+
+   int    ntotal   = nscans * npoints;
+   sim_data        = fsim;
+
+   return ( ntotal > 0 ) ? sqrt( sumsq / (double)ntotal ) : 0.0;
+}
+
+// Interpolate a raw simulation grid (calculate() output with simout_flag
+//  set) onto an experiment grid, as calculate() does at the end of a
+//  single speed step
+int US_Astfem_RSA::interpolate_simout( US_DataIO::RawData& sim_grid,
+                                       US_DataIO::RawData& exp_data )
+{
+   int nescan     = exp_data.scanCount();
+
+   if ( nescan < 1  ||  sim_grid.scanCount() < 1  ||
+        simparams.speed_step.size() != 1 )
+      return -1;
+
+   // Experiment scans outside of the speed step are left zero
+   US_SimulationParameters::SpeedProfile* sp = &simparams.speed_step[ 0 ];
+
+   if ( exp_data.scanData[ 0          ].seconds > sp->time_last   ||
+        exp_data.scanData[ nescan - 1 ].seconds < sp->time_first )
+      return 0;
+
+   US_AstfemMath::MfemData edata;
+   US_AstfemMath::MfemData sdata;
+   load_mfem_data( exp_data, edata );
+   load_mfem_data( sim_grid, sdata );
+
+   if ( US_AstfemMath::interpolate( edata, sdata, use_time ) < 0 )
+      return -1;
+
+   for ( int ii = 0; ii < nescan; ii++ )
+      exp_data.scanData[ ii ].rvalues = edata.scan[ ii ].conc;
+
+   return 0;
+}
+
 void US_Astfem_RSA::load_mfem_data( US_DataIO::RawData&      edata,
                                     US_AstfemMath::MfemData& fdata )
 {
@@ -8,6 +8,7 @@
 #include "us_simparms.h"
 #include "us_dataIO.h"
 #include "us_astfem_math.h"
+#include "us_astfem_grid.h"
 #include "us_stiffbase.h"
 
 #ifndef DbgLv
@@ -53,10 +54,57 @@ class US_UTIL_EXTERN US_Astfem_RSA : public QObject
       //!              input experiment grid.
       void set_simout_flag     ( bool flag ){ simout_flag     = flag; };
 
+      //! \brief Interpolate a raw simulation grid onto an experiment grid.
+      //!        The grid is that output by calculate() with simout_flag set,
+      //!        for a single speed step of a non-interacting model, so
+      //!        that one simulation may be shared by data sets.
+      //! \param sim_grid  Raw simulation grid data.
+      //! \param exp_data  Data with the experiment grid, initialized to
+      //!                  zero, whose concentrations are filled.
+      //! \returns         Zero if interpolated, else -1.
+      int  interpolate_simout  ( US_DataIO::RawData&, US_DataIO::RawData& );
+
+      //! \brief Set a flag for whether to stream output.
+      //! \param flag  Flag for whether to interpolate onto experiment scans
+      //!              as each scan time is passed, instead of keeping
+      //!              all time steps of a speed step and interpolating
+      //!              afterwards (the default). Ignored for simout_flag.
+      void set_stream_flag     ( bool flag ){ stream_flag     = flag; };
+
+      //! \brief Set a flag for whether to step in single precision.
+      //! \param flag  Flag for whether non-interacting time steps are
+      //!              solved in float (for screening fits), instead of
+      //!              double. Mesh, coefficients and output stay double.
+      void set_float_flag      ( bool flag ){ float_flag      = flag; };
+
+      //! \brief Compare single and double precision simulations.
+      //! \param model     Model to simulate
+      //! \param params    Simulation parameters
+      //! \param sim_data  Data with the grid to simulate on, returned
+      //!                  with the single precision simulation
+      //! \param maxdiff   Returned maximum absolute difference
+      //! \returns         RMSD of float from double simulation values
+      static double compare_precision( US_Model&, US_SimulationParameters&,
+                                       US_DataIO::RawData&, double& );
+
       //! \brief Set a flag for the debug print level
       //! \param flag  Integer debug print level (dbg_level).
       void set_debug_flag      ( int  flag ){ dbg_level       = flag; };
 
+      //! \brief Set a grid context shared with other simulations of the
+      //!        same data set, from which the mesh and fixed-grid
+      //!        coefficient terms are borrowed when they are solute-free.
+      //! \param grid  Pointer to the grid context (NULL for none).
+      void set_grid            ( US_AstfemGrid* grid ){ agrid = grid; };
+
+      //! \brief Return the time step counts of calculations so far.
+      //!        They differ only for adaptive steps (a fixed grid with
+      //!        simulation parameter dt_tolerance set).
+      //! \param fixed  Returned count of steps that fixed dt would take.
+      //! \returns      Count of time steps actually taken.
+      int  time_step_counts    ( int& fixed )
+      { fixed = nsteps_fixed; return nsteps_taken; };
+
    signals:
       //! \brief Signal that a calculate_ni()/calculate_ra2() step is complete.
       //!
@@ -112,7 +160,16 @@ class US_UTIL_EXTERN US_Astfem_RSA : public QObject
       
       bool show_movie;
       bool simout_flag;
+      bool stream_flag;       //!< Stream output onto experiment scans
+      bool float_flag;        //!< Step in single precision
+      bool stream_out;        //!< Streaming in the current time loop
+      int  stream_escan;      //!< Next experiment scan to stream to
+      int  stream_nscan;      //!< Simulation scans streamed so far
+      int  stream_error;      //!< Error of a streamed interpolation, or 0
+      US_AstfemMath::MfemScan stream_prev; //!< Last simulation scan streamed
       US_StiffBase stfb0;
+      US_AstfemGrid*               agrid;   //!< Shared grid context
+      const US_AstfemGrid::Entry*  gentry;  //!< Grid entry for current mesh
 
       //! Keep track of time globally for w2t_integral calculation
       double last_time;      
@@ -120,6 +177,8 @@ class US_UTIL_EXTERN US_Astfem_RSA : public QObject
       double w2t_integral;    //!< Keep track of w2t_integral value globally
       int    Nx;              //!< Number of points used in radial direction
       int    dbg_level;
+      int    nsteps_taken;    //!< Time steps taken
+      int    nsteps_fixed;    //!< Time steps taken, if fixed size
       
       US_AstfemMath::AstFemParameters af_params;
       US_AstfemMath::MfemData         af_data;
@@ -140,6 +199,8 @@ class US_UTIL_EXTERN US_Astfem_RSA : public QObject
 
       int    calculate_ni   ( double, double, US_AstfemMath::MfemInitial&,
                               US_AstfemMath::MfemData&, bool );
+      void   adaptive_ni    ( double, double*, US_AstfemMath::MfemInitial&,
+                              US_AstfemMath::MfemData& );
       void   mesh_gen       ( QVector< double >&, int );
       void   mesh_gen_s_pos ( const QVector< double >& );
       void   mesh_gen_s_neg ( const QVector< double >& );
@@ -162,6 +223,12 @@ class US_UTIL_EXTERN US_Astfem_RSA : public QObject
       void   GlobalStiff      ( double*, double**, double**,
                                 double, double );
 
+      void   pack_bands       ( double***, int, int, double* );
+      void   sediment_step    ( bool, int, const double*, const double*,
+                                double**, double**, double*, double* );
+
+      void   store_scan     ( US_AstfemMath::MfemData&,
+                              US_AstfemMath::MfemScan& );
       void   load_mfem_data ( US_DataIO::RawData&, US_AstfemMath::MfemData& );         
       void   store_mfem_data( US_DataIO::RawData&, US_AstfemMath::MfemData& );         
 
@@ -0,0 +1,50 @@
+//! \file us_blas.h
+#ifndef US_BLAS_H
+#define US_BLAS_H
+
+//! \brief Optional BLAS/LAPACK backend
+//!
+//! When the library is built with US_BLAS defined (see local.pri and
+//! library.pri), the CBLAS and LAPACKE interfaces of an optimized
+//! BLAS/LAPACK (OpenBLAS, MKL, ...) are used for the matrix products and
+//! factorizations of US_Matrix, US_LM and the NNLS normal equations.
+//! Otherwise, and for matrices whose rows are not contiguous, the
+//! hand-written code is used.
+
+#ifdef US_BLAS
+#include <cblas.h>
+#include <lapacke.h>
+#endif
+
+class US_Blas
+{
+   public:
+      //! \brief Flag if the BLAS/LAPACK backend was built in
+      static inline bool enabled( void )
+      {
+#ifdef US_BLAS
+         return true;
+#else
+         return false;
+#endif
+      }
+
+      //! \brief Flag if a row-pointer matrix has its rows stored
+      //!  contiguously (as from US_Matrix::construct()), so that it may
+      //!  be passed to BLAS as a row-major array
+      //! \param AA      The matrix array of row pointers
+      //! \param rows    The number of rows
+      //! \param columns The number of columns
+      static inline bool contiguous( double** AA, int rows, int columns )
+      {
+         if ( ! enabled()  ||  AA == 0  ||  rows < 1  ||  columns < 1 )
+            return false;
+
+         for ( int ii = 1; ii < rows; ii++ )
+            if ( AA[ ii ] != AA[ 0 ] + ii * columns )
+               return false;
+
+         return true;
+      }
+};
+#endif
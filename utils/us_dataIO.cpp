@@ -98,6 +98,61 @@ double US_DataIO::RawData::temperature_spread() const
    return qAbs( smax - smin );
 }
 
+// Create empty edited data, holding its own readings
+US_DataIO::EditedData::EditedData()
+{
+   shared_values  = NULL;
+}
+
+// Copy edited data, giving the copy its own readings
+US_DataIO::EditedData::EditedData( const EditedData& edata )
+{
+   shared_values  = NULL;
+   copyFields( edata );
+}
+
+// Assign edited data, giving the target its own readings
+US_DataIO::EditedData& US_DataIO::EditedData::operator=(
+      const EditedData& edata )
+{
+   if ( this != &edata )
+   {
+      shared_values  = NULL;
+      copyFields( edata );
+   }
+
+   return *this;
+}
+
+// Copy the fields of edited data, materializing any shared readings
+void US_DataIO::EditedData::copyFields( const EditedData& edata )
+{
+   expType        = edata.expType;
+   speedData      = edata.speedData;
+   runID          = edata.runID;
+   editID         = edata.editID;
+   dataType       = edata.dataType;
+   cell           = edata.cell;
+   channel        = edata.channel;
+   wavelength     = edata.wavelength;
+   description    = edata.description;
+   editGUID       = edata.editGUID;
+   dataGUID       = edata.dataGUID;
+   meniscus       = edata.meniscus;
+   plateau        = edata.plateau;
+   baseline       = edata.baseline;
+   ODlimit        = edata.ODlimit;
+   floatingData   = edata.floatingData;
+   xvalues        = edata.xvalues;
+   scanData       = edata.scanData;
+
+   if ( edata.shared_values != NULL )
+   {
+      shared_values  = edata.shared_values;
+      detach();
+   }
+}
+
 // Return the count of readings points
 int US_DataIO::EditedData::pointCount( )
 {
@@ -131,18 +186,27 @@ double US_DataIO::EditedData::scWavelength( int wavx )
 // Get the readings value at given scan,radius indecies
 double US_DataIO::EditedData::value( int scnx, int radx )
 {
+   if ( shared_values != NULL )
+      return shared_values[ scnx * xvalues.size() + radx ];
+
    return scanData[ scnx ].rvalues[ radx ];
 }
 
 // Get the readings value at given scan,radius indecies
 double US_DataIO::EditedData::reading( int scnx, int radx )
 {
+   if ( shared_values != NULL )
+      return shared_values[ scnx * xvalues.size() + radx ];
+
    return scanData[ scnx ].rvalues[ radx ];
 }
 
 // Set the readings value at given scan,radius indecies
 bool US_DataIO::EditedData::setValue( int scnx, int radx, double value )
 {
+   if ( shared_values != NULL )
+      detach();                  // Changes go to private readings
+
    if ( scnx < 0  ||  scnx >= scanData.size()  ||
         radx < 0  ||  radx >= scanData[ scnx ].rvalues.size() )
       return false;
@@ -159,6 +223,24 @@ double US_DataIO::EditedData::std_dev( int scnx, int radx )
    return ( use_stddev ? scn->stddevs[ radx ] : 0.0 );
 }
 
+// Copy shared readings back into the scans and stop reading them
+void US_DataIO::EditedData::detach( void )
+{
+   int npoints    = xvalues.size();
+
+   for ( int ss = 0; ss < scanData.size(); ss++ )
+   {
+      const double* svals = shared_values + ss * npoints;
+      QVector< double >* rvals = &scanData[ ss ].rvalues;
+      rvals->resize( npoints );
+
+      for ( int rr = 0; rr < npoints; rr++ )
+         (*rvals)[ rr ] = svals[ rr ];
+   }
+
+   shared_values  = NULL;
+}
+
 // Calculate the average temperature value across scans
 double US_DataIO::EditedData::average_temperature() const
 {
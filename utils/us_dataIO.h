@@ -5,6 +5,8 @@
 #include <QtCore>
 #include "us_extern.h"
 
+class US_MPI_SharedData;
+
 //! \brief Data structures and methods to read/write experimental data
 //!
 /*! The US_DataIO class provides data structures and static methods to
@@ -207,6 +209,14 @@ class US_UTIL_EXTERN US_DataIO
          QVector< double > xvalues;  //!< Wavelength or radius information
          QVector< Scan >   scanData; //!< The actual data. Interpolated omitted
 
+         EditedData();
+
+         //! \brief Copy edited data.  The copy always holds its own
+         //!  readings, even where the source reads them from memory
+         //!  shared among processes.
+         EditedData( const EditedData& );
+         EditedData& operator=( const EditedData& );
+
          int    pointCount  ( void );        //!< Number of readings points
          int    scanCount   ( void );        //!< Number of scans
          int    xindex      ( double );      //!< Get index of X (radius) value
@@ -218,6 +228,16 @@ class US_UTIL_EXTERN US_DataIO
          double std_dev     ( int, int );    //!< Get std.dev. for scan,radius
          double average_temperature() const; //!< Calculate average temperature
          double temperature_spread () const; //!< Calculate temperature spread
+
+         private:
+         // Readings held outside the scans (scan-major), or NULL.
+         //  Only set by US_MPI_SharedData (us_mpi_analysis).
+         const double* shared_values;
+
+         void   copyFields  ( const EditedData& ); // Copy all but readings
+         void   detach      ( void );  // Copy shared readings into the scans
+
+         friend class ::US_MPI_SharedData;
       };
 
       //! The CCW data after edits are applied
@@ -6,6 +6,7 @@
 #include "us_astfem_rsa.h"
 #include "us_settings.h"
 #include "us_dataIO.h"
+#include "us_sim_cache.h"
 
 /////////////////////////
 //
@@ -469,6 +470,47 @@ DbgLv(2) << "SaltD: asim_data avg.temp." << asim_data->average_temperature();
 DbgLv(2) << "SaltD: Nx" << Nx << "r0 rn ri" << sa_data.radius( 0 )
  << sa_data.radius( Nx - 1 ) << simparms.radial_resolution;
 
+   // The salt simulation depends only on the salt component, simulation
+   //  parameters and grid, so it is shared by all solvers that use them
+   //  (within the simulation cache budget)
+   QByteArray skey = US_SimCache::dataset_key( simparms, sa_data );
+
+   if ( ! skey.isEmpty() )
+      skey       = US_SimCache::solute_key( skey, model.components[ 0 ] );
+
+   if ( skey.isEmpty()  ||  ! US_SimCache::fetch_data( skey, sa_data ) )
+   {
+      simulate_salt();
+
+      if ( ! skey.isEmpty() )
+         US_SimCache::store_data( skey, sa_data );
+   }
+
+   Nt         = sa_data.scanCount();
+   Nx         = sa_data.pointCount();
+DbgLv(2) << "SaltD:  key" << skey.toHex().left( 32 ) << "Nt Nx" << Nt << Nx;
+
+   //xs         = new double [ Nx ];
+   //Cs0        = new double [ Nx ];
+   //Cs1        = new double [ Nx ];
+   xsVec .fill( 0.0, Nx );
+   Cs0Vec.fill( 0.0, Nx );
+   Cs1Vec.fill( 0.0, Nx );
+   xs         = xsVec .data();
+   Cs0        = Cs0Vec.data();
+   Cs1        = Cs1Vec.data();
+
+   for ( int jj = 0; jj < Nx; jj++ )
+   {  // set salt radius array
+      xs[ jj ]     = sa_data.radius( jj );
+   }
+DbgLv(2) << "SaltD:  Nx" << Nx << "xs sme" << xs[0] << xs[1] << xs[2]
+ << xs[Nx/2-1] << xs[Nx/2] << xs[Nx-2+1] << xs[Nx-3] << xs[Nx-2] << xs[Nx-1];
+};
+
+// Simulate the salt component (astfem) and limit its concentrations
+void US_LammAstfvm::SaltData::simulate_salt( void )
+{
    US_Astfem_RSA* astfem = new US_Astfem_RSA( model, simparms );
 
    //astfem->setTimeInterpolation( true );
@@ -480,7 +522,6 @@ DbgLv(2) << "SaltD: Nx" << Nx << "r0 rn ri" << sa_data.radius( 0 )
          sa_data.setValue( ii, jj, 0.0 );
 
 DbgLv(2) << "SaltD: model comps" << model.components.size();
-DbgLv(2) << "SaltD: amodel comps" << amodel.components.size();
 DbgLv(2) << "SaltD: comp0 s d s_conc" << model.components[0].s
  << model.components[0].D << model.components[0].signal_concentration;
 DbgLv(2) << "SaltD:fem: m b  s D  rpm" << simparms.meniscus << simparms.bottom
@@ -499,6 +540,7 @@ DbgLv(2) << "SaltD: (2)Nx" << Nx << "r0 r1 rm rn" << sa_data.radius(0)
  << sa_data.radius(1) << sa_data.radius(Nx-2) << sa_data.radius(Nx-1);
 
    astfem->calculate( sa_data );            // solve equations to create data
+   delete astfem;                           // astfem solver no longer needed
 
    Nt         = sa_data.scanCount();
    Nx         = sa_data.pointCount();
@@ -556,16 +598,6 @@ DbgLv(2) << "SaltD:  salt *NaN* ii jj adj-saltv" << ii << jj << saltv;
    }
 DbgLv(2) << "SaltD:  salt ampl limit changes" << nchg;
 
-   //xs         = new double [ Nx ];
-   //Cs0        = new double [ Nx ];
-   //Cs1        = new double [ Nx ];
-   xsVec .fill( 0.0, Nx );
-   Cs0Vec.fill( 0.0, Nx );
-   Cs1Vec.fill( 0.0, Nx );
-   xs         = xsVec .data();
-   Cs0        = Cs0Vec.data();
-   Cs1        = Cs1Vec.data();
-
    if ( dbg_level > 2 )
    { // save a copy of the salt data set so that it may be plotted for QC
       QString safile  = US_Settings::resultDir() + "/salt_data";
@@ -575,16 +607,7 @@ DbgLv(2) << "SaltD:  salt ampl limit changes" << nchg;
       safile       = safile + "/salt_data.RA.1.S.260.auc";
       US_DataIO::writeRawData( safile, sa_data );
    }
-
-   delete astfem;                           // astfem solver no longer needed
-
-   for ( int jj = 0; jj < Nx; jj++ )
-   {  // set salt radius array
-      xs[ jj ]     = sa_data.radius( jj );
-   }
-DbgLv(2) << "SaltD:  Nx" << Nx << "xs sme" << xs[0] << xs[1] << xs[2]
- << xs[Nx/2-1] << xs[Nx/2] << xs[Nx-2+1] << xs[Nx-3] << xs[Nx-2] << xs[Nx-1];
-};
+}
 
 US_LammAstfvm::SaltData::~SaltData()
 {
@@ -598,15 +621,20 @@ US_LammAstfvm::SaltData::~SaltData()
 
 void US_LammAstfvm::SaltData::initSalt()
 {
-   t0         = sa_data.scanData[ 0 ].seconds; // times of 1st 2 salt scans
-   t1         = sa_data.scanData[ 1 ].seconds;
+   // Read-only access, so that cache-shared salt data is never detached
+   const QVector< US_DataIO::Scan >& sscans = sa_data.scanData;
+   const double* sv0 = sscans[ 0 ].rvalues.constData();
+   const double* sv1 = sscans[ 1 ].rvalues.constData();
+
+   t0         = sscans[ 0 ].seconds;           // times of 1st 2 salt scans
+   t1         = sscans[ 1 ].seconds;
    scn        = 2;                             // index to next scan to use
-   Nt         = sa_data.scanCount() - 2;       // scan count less two used here
+   Nt         = sscans.size() - 2;             // scan count less two used here
         
    for ( int j = 0; j < Nx; j++ )
    {  // get 1st two salt arrays from 1st two salt scans
-      Cs0[ j ]   = sa_data.value( 0, j );
-      Cs1[ j ]   = sa_data.value( 1, j );
+      Cs0[ j ]   = sv0[ j ];
+      Cs1[ j ]   = sv1[ j ];
    }
 int k=Nx/2;
 int n=Nx-1;
@@ -630,10 +658,12 @@ DbgLv(2) << "SaltD:ntrp:  N t t1 Nt Nx" << N << t << t1 << Nt << Nx
       Cs0   = Cs1;
       Cs1   = tmp;    // swap Cs0 and Cs1
 
-      t1    = sa_data.scanData[ scn ].seconds;
+      const US_DataIO::Scan& sscan = sa_data.scanData.at( scn );
+      const double*          svals = sscan.rvalues.constData();
+      t1    = sscan.seconds;
 
       for ( int j = 0; j < Nx; j++ )
-         Cs1[ j ]   = sa_data.value( scn, j );
+         Cs1[ j ]   = svals[ j ];
 
       Nt --;             // Nt = time level left
       scn++;
@@ -725,6 +755,8 @@ DbgLv(2) << "LFvm:  m b" << param_m << param_b;
 
    //err_tol         = 1.0e-4;
    err_tol         = 1.0e-5;
+   nthreads        = 1;
+   worker          = false;
 }
 
 // destroy
@@ -756,15 +788,42 @@ int US_LammAstfvm::calculate( US_DataIO::RawData& sim_data )
    qApp->processEvents();
 #endif
 
-   // update concentrations for each model component
-   for ( int ii = 0; ii < model.components.size(); ii++ )
-   {
-      int rc = solve_component( ii );
+   int ncomp  = model.components.size();
+   int nthr   = qMin( nthreads, ncomp );
+
+   if ( nthr > 1  &&  ! movieFlag )
+   {  // determine the non-ideal case, as the first component would
+      comp_x     = 0;
+      int rc     = nonIdealCaseNo();
+
+      if ( rc != 0 )
+         return rc;
+
+      if ( NonIdealCaseNo == 2 )
+         nthr       = 1;         // co-sedimenting:  salt data is shared
+   }
+   else
+      nthr       = 1;
+
+   if ( nthr > 1 )
+   {  // solve components concurrently
+      int rc = solve_threaded( nthr );
 
       if ( rc != 0 )
          return rc;
    }
 
+   else
+   {  // update concentrations for each model component
+      for ( int ii = 0; ii < ncomp; ii++ )
+      {
+         int rc = solve_component( ii );
+
+         if ( rc != 0 )
+            return rc;
+      }
+   }
+
 #ifndef NO_DB
    emit calc_done();
    qApp->processEvents();
@@ -817,8 +876,11 @@ int US_LammAstfvm::solve_component( int compx )
    QVector< double > rads;
 
 #ifndef NO_DB
-   emit comp_progress( compx + 1 );
-   qApp->processEvents();
+   if ( ! worker )
+   {
+      emit comp_progress( compx + 1 );
+      qApp->processEvents();
+   }
 #endif
 
    if ( nonIdealCaseNo() != 0 )            // set non-ideal case number
@@ -1091,7 +1153,8 @@ DbgLv(2) << "LAsc:   co[0] co[H] co[N]  kt" << af_data.scan[kt].conc[0]
          istep++;  // bump progress step
 
 #ifndef NO_DB
-         if ( ( ( kt / ktinc ) * ktinc ) == kt  ||  ( kt + 1 ) == nts )
+         if ( ! worker  &&
+              ( ( ( kt / ktinc ) * ktinc ) == kt  ||  ( kt + 1 ) == nts ) )
          {  // signal progress at every "ktinc'th" scan or final one
             emit calc_progress( istep );
 DbgLv(2) << "LAsc: istep" << istep;
@@ -1101,7 +1164,7 @@ DbgLv(2) << "LAsc: istep" << istep;
 #ifndef NO_DB
 //      if ( movieFlag  &&
 //         ( ( ( kt / ktinc ) * ktinc ) == kt  ||  ( kt + 1 ) == nts ) )
-      if ( movieFlag )
+      if ( movieFlag  &&  ! worker )
       {
          emit new_scan( &af_data.radius, af_data.scan[ kt ].conc.data() );
          emit new_time( t0 );
@@ -1111,7 +1174,8 @@ DbgLv(2) << "LAsc: istep" << istep;
 
          kt++;    // bump output time(scan) index
 
-         qApp->processEvents();
+         if ( ! worker )
+            qApp->processEvents();
          if ( stopFlag )  break;
       }
 
@@ -1120,7 +1184,8 @@ DbgLv(2) << "LAsc: istep" << istep;
       if ( kt >= nts )
          break;   // if all scans updated, we are done
 
-      qApp->processEvents();
+      if ( ! worker )
+         qApp->processEvents();
       if ( stopFlag )  break;
       // switch x,u arrays for next iteration
       N0    = N1;
@@ -1181,6 +1246,140 @@ DbgLv(2) << "compx" << comp_x << "times 1-6"
    return 0;
 }
 
+// solve components in a number of threads, then sum them in order
+int US_LammAstfvm::solve_threaded( int nthr )
+{
+   int ncomp  = model.components.size();
+   int nts    = af_data.scan.size();
+   int ncs    = af_data.radius.size();
+   int rc     = 0;
+   int ndone  = 0;
+   QVector< QVector< double > > cconcs( ncomp );
+   QList< CompThread* >         cthreads;
+   ncomp_done.fetchAndStoreOrdered( 0 );
+
+   for ( int tt = 0; tt < nthr; tt++ )
+   {
+      CompThread* cthr = new CompThread( this, tt, nthr, cconcs.data() );
+      cthreads << cthr;
+      cthr->start();
+   }
+DbgLv(1) << "LAsc: solve_threaded  ncomp nthr" << ncomp << nthr;
+
+   for ( int tt = 0; tt < nthr; tt++ )
+   {  // wait for threads, reporting progress and passing on any stop
+      while ( ! cthreads[ tt ]->wait( 100 ) )
+      {
+         qApp->processEvents();
+
+         if ( stopFlag )
+         {
+            for ( int jj = 0; jj < nthr; jj++ )
+               cthreads[ jj ]->solver->stopFlag = true;
+         }
+
+#ifndef NO_DB
+         int kdone  = ncomp_done.fetchAndAddOrdered( 0 );
+
+         if ( kdone > ndone )
+         {
+            ndone      = kdone;
+            emit comp_progress( ndone );
+            emit calc_progress( ndone * nts );
+         }
+#endif
+      }
+
+      rc         = qMax( rc, cthreads[ tt ]->rc );
+   }
+
+   qDeleteAll( cthreads );
+
+   if ( rc != 0 )
+      return rc;
+
+   for ( int cc = 0; cc < ncomp; cc++ )
+   {  // sum component concentrations in component order
+      const double* ccv = cconcs[ cc ].constData();
+
+      if ( cconcs[ cc ].size() < nts * ncs )
+         continue;               // not solved (stopped)
+
+      for ( int ii = 0; ii < nts; ii++ )
+      {
+         double* conc = af_data.scan[ ii ].conc.data();
+
+         for ( int jj = 0; jj < ncs; jj++ )
+            conc[ jj ]  += ccv[ jj ];
+
+         ccv       += ncs;
+      }
+   }
+
+   return 0;
+}
+
+// create a component-solving thread with a solver copying parent settings
+US_LammAstfvm::CompThread::CompThread( US_LammAstfvm* parent, int thrx,
+      int nthr, QVector< double >* cconcs )
+   : QThread(), parent( parent ), cconcs( cconcs ), thrx( thrx ),
+     nthr( nthr )
+{
+   rc       = 0;
+   solver   = new US_LammAstfvm( parent->model, parent->simparams );
+
+   solver->dbg_level       = 0;    // the debug trace file is not shared
+   solver->worker          = true; // events and signals stay with parent
+   solver->auc_data        = parent->auc_data;
+   solver->af_data         = parent->af_data;
+   solver->NonIdealCaseNo  = parent->NonIdealCaseNo;
+   solver->density         = parent->density;
+   solver->compressib      = parent->compressib;
+   solver->vbar_salt       = parent->vbar_salt;
+   solver->MeshSpeedFactor = parent->MeshSpeedFactor;
+   solver->MeshRefineOpt   = parent->MeshRefineOpt;
+   solver->err_tol         = parent->err_tol;
+
+   for ( int ii = 0; ii < 6; ii++ )
+   {
+      solver->d_coeff[ ii ]   = parent->d_coeff[ ii ];
+      solver->v_coeff[ ii ]   = parent->v_coeff[ ii ];
+   }
+}
+
+US_LammAstfvm::CompThread::~CompThread()
+{
+   delete solver;
+}
+
+// solve this thread's share of components, saving each one's concentrations
+void US_LammAstfvm::CompThread::run( void )
+{
+   int ncomp  = parent->model.components.size();
+   US_AstfemMath::MfemData* cdata = &solver->af_data;
+   int nts    = cdata->scan.size();
+   int ncs    = cdata->radius.size();
+
+   for ( int cc = thrx; cc < ncomp; cc += nthr )
+   {
+      for ( int ii = 0; ii < nts; ii++ )
+         cdata->scan[ ii ].conc.fill( 0.0, ncs );
+
+      rc         = solver->solve_component( cc );
+
+      if ( rc != 0  ||  solver->stopFlag )
+         break;
+
+      QVector< double >* ccv = &cconcs[ cc ];
+      ccv->reserve( nts * ncs );
+
+      for ( int ii = 0; ii < nts; ii++ )
+         *ccv << cdata->scan[ ii ].conc;
+
+      parent->ncomp_done.ref();
+   }
+}
+
 void US_LammAstfvm::set_buffer( US_Buffer buffer )
 {
    density     = buffer.density;             // for compressibility
@@ -1288,14 +1487,14 @@ void US_LammAstfvm::LammStepSedDiff_C( double t, double dt, int M0,
    double* phiL    = phi         + 3;
    double* phiR    = phiL        + 6; 
 QTime timer;
-static int ktim1=0;
-static int ktim2=0;
-static int ktim3=0;
-static int ktim4=0;
-static int ktim5=0;
-static int ktim6=0;
-static int ktim7=0;
-static int ktim8=0;
+int ktim1=0;
+int ktim2=0;
+int ktim3=0;
+int ktim4=0;
+int ktim5=0;
+int ktim6=0;
+int ktim7=0;
+int ktim8=0;
 timer.start();
 
    // calculate Sv, Dv at t+dt on xg=(xl, xr)
@@ -1580,8 +1779,8 @@ void US_LammAstfvm::AdjustSD( double t, int Nv, double *x, double *u,
    //double  vbar   = model.components[ 0 ].vbar20;
    double  vbar   = model.components[ comp_x ].vbar20;
 QTime timer;
-static int kst1=0;
-static int kst2=0;
+int kst1=0;
+int kst2=0;
 
    switch ( NonIdealCaseNo )
    {
@@ -2091,6 +2290,11 @@ void US_LammAstfvm::setStopFlag( bool flag )
 DbgLv(2) << "setStopFlag" << stopFlag;
 }
 
+void US_LammAstfvm::setThreads( int nthr )
+{
+   nthreads  = qMax( 1, nthr );
+}
+
 void US_LammAstfvm::setMovieFlag( bool flag )
 {
    movieFlag = flag;
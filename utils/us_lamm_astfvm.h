@@ -92,6 +92,12 @@ class US_UTIL_EXTERN US_LammAstfvm : public QObject
             void initSalt();
 
             //! \brief Interpolate concentrations of salt
+            //!
+            //! The salt simulation is shared (read-only) through a cache
+            //! keyed by the salt component, simulation parameters and grid,
+            //! so that only the first solver for a given buffer and
+            //! experiment computes it. The interpolation state is kept
+            //! per instance.
             //! \param N     Number of elements in arrays
             //! \param x     X (radius) array
             //! \param t     Current time value
@@ -117,6 +123,8 @@ class US_UTIL_EXTERN US_LammAstfvm : public QObject
             QVector< double > xsVec;    // Vector for xs
             QVector< double > Cs0Vec;   // Vector for Cs0
             QVector< double > Cs1Vec;   // Vector for Cs1
+
+            void simulate_salt( void );
       };
 
       //! \brief Create Lamm equations AST Finite Volume Method solver
@@ -158,6 +166,15 @@ class US_UTIL_EXTERN US_LammAstfvm : public QObject
       //! \param flag    Flag for whether or not to operate in show-movie mode.
       void setMovieFlag( bool );
 
+      //! \brief Set the number of threads for solving components.
+      //!
+      //! Components of non-interacting models are then solved concurrently,
+      //! each thread with its own mesh and solver state, and summed in
+      //! component order, so results do not depend on the thread count.
+      //! Co-sedimenting models and movie mode are always solved serially.
+      //! \param nthreads Number of threads (1 for serial solving)
+      void setThreads  ( int );
+
    signals:
       //! \brief Signal calculation start and give maximum steps
       //! \param nsteps Number of expected total calculation progress steps
@@ -221,6 +238,8 @@ class US_UTIL_EXTERN US_LammAstfvm : public QObject
 
       bool    stopFlag;        // flag to stop processing
       bool    movieFlag;       // flag to operate in show-movie mode
+      bool    worker;          // flag of solver in a CompThread:
+                               //  no events processed or signals emitted
 
       double  param_m;         // m of cell (meniscus)
       double  param_b;         // b of cell (bottom)
@@ -233,6 +252,29 @@ class US_UTIL_EXTERN US_LammAstfvm : public QObject
       double  d_coeff[ 6 ];    // SD Adjust buffer density coefficients
       double  v_coeff[ 6 ];    // SD Adjust buffer viscosity coefficients
 
+      int     nthreads;        // threads for solving components
+      QAtomicInt ncomp_done;   // components solved by threads
+
+      // Thread to solve a share of the model components
+      class CompThread : public QThread
+      {
+         public:
+            CompThread( US_LammAstfvm*, int, int, QVector< double >* );
+            ~CompThread();
+
+            void run( void );
+
+            US_LammAstfvm*     parent;   // Parent solver
+            US_LammAstfvm*     solver;   // Solver for this thread
+            QVector< double >* cconcs;   // Concentrations of each component
+            int                thrx;     // Thread index (0,...)
+            int                nthr;     // Number of solving threads
+            int                rc;       // Return code of solve_component
+      };
+
+      // Solve all components in threads and sum their concentrations
+      int  solve_threaded( int );
+
       // private functions
 
       //! \brief Get the non-ideal case number from model parameters
@@ -32,6 +32,7 @@
 #include <math.h>
 #include <float.h>
 #include "us_lm.h"
+#include "us_blas.h"
 
 // 
 //US_LM::US_LM()
@@ -1041,6 +1042,43 @@ QString US_LM::lm_statmsg( US_LM::LM_Status *status, bool longmsg )
          int i, j, k, kmax, minmn;
          double ajnorm, sum, temp;
 
+#ifdef US_BLAS
+         /*** qrfac: LAPACK factorization, converted to the form above:
+              v (with v(j)=1) and tau of each LAPACK reflector
+              I - tau*v*vT give u = tau*v, so that u(j) = tau. ***/
+
+         QVector< lapack_int > jpvt( n, 0 );
+         QVector< double >     tau( MIN(m, n) );
+         lapack_int            info;
+
+         for (j = 0; j < n; j++)
+            acnorm[j] = (*lm_use_norm)(m, &a[j*m]);
+
+         if (pivot)
+            info = LAPACKE_dgeqp3(LAPACK_COL_MAJOR, m, n, a, m,
+                                  jpvt.data(), tau.data());
+         else
+            info = LAPACKE_dgeqrf(LAPACK_COL_MAJOR, m, n, a, m, tau.data());
+
+         if (info == 0) {
+            minmn = MIN(m, n);
+            for (j = 0; j < n; j++) {
+               if (pivot)
+                  ipvt[j] = jpvt[j] - 1;
+               if (j >= minmn) {
+                  rdiag[j] = 0;
+                  continue;
+               }
+               rdiag[j] = a[j*m+j];
+               temp = tau[j];
+               a[j*m+j] = temp;
+               for (i = j + 1; i < m; i++)
+                  a[j*m+i] *= temp;
+            }
+            return;
+         }
+#endif
+
          /*** qrfac: compute initial column norms and initialize several arrays. ***/
 
          for (j = 0; j < n; j++) {
@@ -2,11 +2,13 @@
 
 #include <stdlib.h>
 #include <math.h>
+#include <float.h>
 #ifdef _BF_NNLS_
 #include <dlfcn.h>
 #endif
 
 #include "us_math2.h"
+#include "us_blas.h"
 #include "us_constants.h"
 #include "us_dataIO.h"
 #include "us_matrix.h"
@@ -1134,6 +1136,612 @@ int US_Math2::nnls( double* a, int a_dim1, int m, int n,
    return ret;
 }
 
+// Accumulate the columns of A'A and A'b assigned to one thread
+static void nnls_gram_cols( const double* a, int a_dim1, int m, int n,
+                            const double* b, double* ata, double* atb,
+                            int thrx, int nthr )
+{
+   // Rows in a block:  keep a block of all columns within about 1 MB
+   const int rblk = qMax( 64, 131072 / qMax( 1, n ) );
+
+   for ( int jj = thrx; jj < n; jj += nthr )
+   {
+      double* atac   = ata + jj * n;
+
+      for ( int ii = 0; ii <= jj; ii++ )
+         atac[ ii ]     = 0.0;
+
+      atb[ jj ]      = 0.0;
+   }
+
+   for ( int r0 = 0; r0 < m; r0 += rblk )
+   {
+      int r1         = qMin( m, r0 + rblk );
+
+      for ( int jj = thrx; jj < n; jj += nthr )
+      {
+         const double* aj = a + jj * a_dim1;
+         double* atac   = ata + jj * n;
+
+         for ( int ii = 0; ii <= jj; ii++ )
+         {
+            const double* ai = a + ii * a_dim1;
+            double sum     = 0.0;
+
+            for ( int rr = r0; rr < r1; rr++ )
+               sum           += ai[ rr ] * aj[ rr ];
+
+            atac[ ii ]    += sum;
+         }
+
+         double sum     = 0.0;
+
+         for ( int rr = r0; rr < r1; rr++ )
+            sum           += aj[ rr ] * b[ rr ];
+
+         atb[ jj ]     += sum;
+      }
+   }
+}
+
+// Thread computing an interleaved subset of the columns of A'A
+class nnls_gram_thr_t : public QThread
+{
+   public:
+      nnls_gram_thr_t( const double* a, int a_dim1, int m, int n,
+                       const double* b, double* ata, double* atb,
+                       int thrx, int nthr )
+         : a( a ), a_dim1( a_dim1 ), m( m ), n( n ), b( b ),
+           ata( ata ), atb( atb ), thrx( thrx ), nthr( nthr ) {}
+
+      void run()
+      {
+         nnls_gram_cols( a, a_dim1, m, n, b, ata, atb, thrx, nthr );
+      }
+
+   private:
+      const double* a;
+      int           a_dim1;
+      int           m;
+      int           n;
+      const double* b;
+      double*       ata;
+      double*       atb;
+      int           thrx;
+      int           nthr;
+};
+
+void US_Math2::nnls_gram( const double* a, int a_dim1, int m, int n,
+                          const double* b, double* ata, double* atb,
+                          double* btb, int nthreads )
+{
+#ifdef US_BLAS
+   // Upper triangle of A'A, and A'b, from the BLAS (which has its threads)
+   cblas_dsyrk( CblasColMajor, CblasUpper, CblasTrans, n, m,
+                1.0, a, a_dim1, 0.0, ata, n );
+   cblas_dgemv( CblasColMajor, CblasTrans, m, n,
+                1.0, a, a_dim1, b, 1, 0.0, atb, 1 );
+#else
+   int nthr       = qMax( 1, qMin( nthreads, n ) );
+
+   // Each thread owns whole columns, so sums do not depend on nthr
+   QList< nnls_gram_thr_t* > threads;
+
+   for ( int tt = 1; tt < nthr; tt++ )
+   {
+      nnls_gram_thr_t* thr = new nnls_gram_thr_t( a, a_dim1, m, n, b,
+                                                  ata, atb, tt, nthr );
+      threads << thr;
+      thr->start();
+   }
+
+   nnls_gram_cols( a, a_dim1, m, n, b, ata, atb, 0, nthr );
+
+   for ( int tt = 0; tt < threads.size(); tt++ )
+   {
+      threads[ tt ]->wait();
+      delete threads[ tt ];
+   }
+#endif
+
+   // Mirror the upper triangle into the lower
+   for ( int jj = 0; jj < n; jj++ )
+      for ( int ii = 0; ii < jj; ii++ )
+         ata[ jj + ii * n ] = ata[ ii + jj * n ];
+
+   if ( btb != NULL )
+   {
+      double sum     = 0.0;
+
+      for ( int rr = 0; rr < m; rr++ )
+         sum           += b[ rr ] * b[ rr ];
+
+      *btb           = sum;
+   }
+}
+
+// Accumulate the columns of a sparse A'A and A'b assigned to one thread
+static void nnls_gram_csc_cols( const double* a_vals, const int* a_rows,
+                                const int* a_cptr, int m, int n,
+                                const double* b, double* ata, double* atb,
+                                int thrx, int nthr )
+{
+   QVector< double > workv( m, 0.0 );
+   double* work   = workv.data();
+
+   for ( int jj = thrx; jj < n; jj += nthr )
+   {
+      double* atac   = ata + jj * n;
+      int     kj0    = a_cptr[ jj ];
+      int     kj1    = a_cptr[ jj + 1 ];
+      double  sum    = 0.0;
+
+      // Scatter column j into the work vector and form A'b
+      for ( int kk = kj0; kk < kj1; kk++ )
+      {
+         work[ a_rows[ kk ] ] = a_vals[ kk ];
+         sum           += a_vals[ kk ] * b[ a_rows[ kk ] ];
+      }
+
+      atb[ jj ]      = sum;
+
+      for ( int ii = 0; ii <= jj; ii++ )
+      {  // Gather column i against column j
+         sum            = 0.0;
+
+         for ( int kk = a_cptr[ ii ]; kk < a_cptr[ ii + 1 ]; kk++ )
+            sum           += a_vals[ kk ] * work[ a_rows[ kk ] ];
+
+         atac[ ii ]     = sum;
+      }
+
+      for ( int kk = kj0; kk < kj1; kk++ )
+         work[ a_rows[ kk ] ] = 0.0;
+   }
+}
+
+// Thread computing an interleaved subset of the columns of a sparse A'A
+class nnls_gram_csc_thr_t : public QThread
+{
+   public:
+      nnls_gram_csc_thr_t( const double* a_vals, const int* a_rows,
+                           const int* a_cptr, int m, int n,
+                           const double* b, double* ata, double* atb,
+                           int thrx, int nthr )
+         : a_vals( a_vals ), a_rows( a_rows ), a_cptr( a_cptr ), m( m ),
+           n( n ), b( b ), ata( ata ), atb( atb ), thrx( thrx ),
+           nthr( nthr ) {}
+
+      void run()
+      {
+         nnls_gram_csc_cols( a_vals, a_rows, a_cptr, m, n, b, ata, atb,
+                             thrx, nthr );
+      }
+
+   private:
+      const double* a_vals;
+      const int*    a_rows;
+      const int*    a_cptr;
+      int           m;
+      int           n;
+      const double* b;
+      double*       ata;
+      double*       atb;
+      int           thrx;
+      int           nthr;
+};
+
+void US_Math2::nnls_gram_csc( const double* a_vals, const int* a_rows,
+                              const int* a_cptr, int m, int n,
+                              const double* b, double* ata, double* atb,
+                              double* btb, int nthreads )
+{
+   int nthr       = qMax( 1, qMin( nthreads, n ) );
+
+   QList< nnls_gram_csc_thr_t* > threads;
+
+   for ( int tt = 1; tt < nthr; tt++ )
+   {
+      nnls_gram_csc_thr_t* thr = new nnls_gram_csc_thr_t( a_vals, a_rows,
+                                    a_cptr, m, n, b, ata, atb, tt, nthr );
+      threads << thr;
+      thr->start();
+   }
+
+   nnls_gram_csc_cols( a_vals, a_rows, a_cptr, m, n, b, ata, atb, 0, nthr );
+
+   for ( int tt = 0; tt < threads.size(); tt++ )
+   {
+      threads[ tt ]->wait();
+      delete threads[ tt ];
+   }
+
+   // Mirror the upper triangle into the lower
+   for ( int jj = 0; jj < n; jj++ )
+      for ( int ii = 0; ii < jj; ii++ )
+         ata[ jj + ii * n ] = ata[ ii + jj * n ];
+
+   if ( btb != NULL )
+   {
+      double sum     = 0.0;
+
+      for ( int rr = 0; rr < m; rr++ )
+         sum           += b[ rr ] * b[ rr ];
+
+      *btb           = sum;
+   }
+}
+
+/*****************************************************************************
+ *
+ *  Compute the NNLS gradient w = A'b - A'A x for a solution that is
+ *  non-zero only in the passive set.
+ */
+static void nnls_gradient( const double* ata, const double* atb, int n,
+                           const int* pidx, int np, const double* x,
+                           double* w )
+{
+   for ( int jj = 0; jj < n; jj++ )
+   {
+      const double* atac = ata + jj * n;
+      double sum     = atb[ jj ];
+
+      for ( int kk = 0; kk < np; kk++ )
+         sum           -= atac[ pidx[ kk ] ] * x[ pidx[ kk ] ];
+
+      w[ jj ]        = sum;
+   }
+}
+
+int US_Math2::nnls_normal( const double* ata, const double* atb, int n,
+                           double* x, double btb, double* rnorm,
+                           bool warm, int* nchange )
+{
+   /* Check the parameters and data */
+   if ( n <= 0 || ata == NULL || atb == NULL || x == NULL ) return 2;
+
+   QVector< double > wVec( n );     // Gradient, A'b - A'A x
+   QVector< double > sVec( n );     // Passive-set subproblem solution
+   QVector< double > xVec( n );     // Solution before the current step
+   QVector< double > cVec( n * n ); // Cholesky work space
+   QVector< int >    pVec( n );     // Passive-set indices
+   QVector< char >   inP ( n, 0 );  // Flags of passive-set membership
+   QVector< char >   excl( n, 0 );  // Flags of columns not to enter
+   double* w      = wVec.data();
+   double* s      = sVec.data();
+   double* xold   = xVec.data();
+   double* chw    = cVec.data();
+   int*    pidx   = pVec.data();
+   int     np     = 0;
+   int     ret    = 0;
+   int     iter   = 0;
+   int     itmax  = n * 3;
+   int     nouter = 0;
+   int     nchg   = 0;
+
+   /* Tolerance for the gradient, from the 1-norm of A'A */
+   double anorm   = 0.0;
+
+   for ( int jj = 0; jj < n; jj++ )
+   {
+      double csum    = 0.0;
+
+      for ( int ii = 0; ii < n; ii++ )
+         csum          += fabs( ata[ ii + jj * n ] );
+
+      anorm          = qMax( anorm, csum );
+   }
+
+   double tol     = 10.0 * DBL_EPSILON * anorm * (double)n;
+
+   for ( int jj = 0; jj < n; jj++ )
+   {
+      if ( warm  &&  x[ jj ] > 0.0 )
+      {  /* Warm start:  initial passive set is the positive input values */
+         inP [ jj ]     = 1;
+         pidx[ np++ ]   = jj;
+      }
+      else
+         x[ jj ]        = 0.0;
+
+      w[ jj ]        = atb[ jj ];
+   }
+
+   /* Reduce any initial passive set until its solution is positive */
+   while ( np > 0 )
+   {
+      if ( !_nnls_psolve( ata, atb, n, pidx, np, chw, s ) )
+      {  /* Dependent initial columns:  fall back to a cold start */
+         for ( int kk = 0; kk < np; kk++ )
+         {
+            x  [ pidx[ kk ] ] = 0.0;
+            inP[ pidx[ kk ] ] = 0;
+         }
+
+         nchg          += np;
+         np             = 0;
+         break;
+      }
+
+      int    kp     = 0;
+
+      for ( int kk = 0; kk < np; kk++ )
+      {
+         int jj         = pidx[ kk ];
+
+         if ( s[ kk ] > 0.0 )
+         {
+            x   [ jj ]     = s[ kk ];
+            pidx[ kp++ ]   = jj;
+         }
+         else
+         {
+            x  [ jj ]      = 0.0;
+            inP[ jj ]      = 0;
+         }
+      }
+
+      if ( kp == np )
+      {  /* Feasible:  start from the passive-set solution */
+         nnls_gradient( ata, atb, n, pidx, np, x, w );
+         break;
+      }
+
+      nchg          += ( np - kp );
+      np             = kp;
+   }
+
+   /* Main loop:  bring the column of largest positive gradient into P */
+   while ( np < n )
+   {
+      int    jmax   = -1;
+      double wmax   = tol;
+
+      for ( int jj = 0; jj < n; jj++ )
+      {
+         if ( !inP[ jj ]  &&  !excl[ jj ]  &&  w[ jj ] > wmax )
+         {
+            wmax          = w[ jj ];
+            jmax          = jj;
+         }
+      }
+
+      if ( jmax < 0 )
+         break;
+
+      if ( ++nouter > itmax )
+      {
+         ret           = 1;
+         break;
+      }
+
+      inP [ jmax ]   = 1;
+      pidx[ np++ ]   = jmax;
+
+      if ( !_nnls_psolve( ata, atb, n, pidx, np, chw, s ) )
+      {  /* Dependent column:  drop it until the solution changes */
+         inP [ jmax ]   = 0;
+         excl[ jmax ]   = 1;
+         np--;
+         continue;
+      }
+
+      if ( s[ np - 1 ] <= 0.0 )
+      {  /* Entering column would not be positive:  as in nnls(), which
+            zeroes w[jmax], try the next candidate until x changes */
+         inP [ jmax ]   = 0;
+         excl[ jmax ]   = 1;
+         np--;
+         continue;
+      }
+
+      nchg++;
+
+      for ( int jj = 0; jj < n; jj++ )
+         xold[ jj ]     = x[ jj ];
+
+      /* Secondary loop:  step back toward feasibility */
+      while ( true )
+      {
+         double alpha   = 2.0;
+         int    kmin    = -1;
+
+         for ( int kk = 0; kk < np; kk++ )
+         {
+            if ( s[ kk ] <= 0.0 )
+            {
+               int    jj     = pidx[ kk ];
+               double dd     = x[ jj ] - s[ kk ];
+               double tt     = ( dd > 0.0 ) ? ( x[ jj ] / dd ) : 0.0;
+
+               if ( tt < alpha )
+               {
+                  alpha         = tt;
+                  kmin          = kk;
+               }
+            }
+         }
+
+         if ( kmin < 0 )
+            break;
+
+         if ( ++iter > itmax )
+         {
+            ret           = 1;
+            break;
+         }
+
+         /* Interpolate and move non-positive values out of P */
+         int    jmin   = pidx[ kmin ];
+         int    kp     = 0;
+
+         for ( int kk = 0; kk < np; kk++ )
+         {
+            int jj         = pidx[ kk ];
+            x[ jj ]       += alpha * ( s[ kk ] - x[ jj ] );
+
+            if ( jj == jmin  ||  x[ jj ] <= 0.0 )
+            {
+               x  [ jj ]      = 0.0;
+               inP[ jj ]      = 0;
+               nchg++;
+            }
+            else
+               pidx[ kp++ ]   = jj;
+         }
+
+         np             = kp;
+
+         if ( np == 0 )
+            break;
+
+         if ( !_nnls_psolve( ata, atb, n, pidx, np, chw, s ) )
+         {  /* Reduced set numerically singular:  keep the feasible
+               interpolated point as the subproblem solution */
+            for ( int kk = 0; kk < np; kk++ )
+               s[ kk ]        = x[ pidx[ kk ] ];
+
+            break;
+         }
+      }
+
+      if ( ret != 0 )
+         break;
+
+      /* Accept the subproblem solution and update the gradient */
+      for ( int jj = 0; jj < n; jj++ )
+      {
+         if ( !inP[ jj ] )
+            x[ jj ]        = 0.0;
+      }
+
+      for ( int kk = 0; kk < np; kk++ )
+         x[ pidx[ kk ] ] = s[ kk ];
+
+      /* Excluded columns may enter again only once x has changed */
+      bool   moved  = false;
+
+      for ( int jj = 0; jj < n  &&  !moved; jj++ )
+         moved          = ( x[ jj ] != xold[ jj ] );
+
+      if ( moved )
+      {
+         for ( int jj = 0; jj < n; jj++ )
+            excl[ jj ]     = 0;
+      }
+      else
+         excl[ jmax ]   = 1;
+
+      nnls_gradient( ata, atb, n, pidx, np, x, w );
+   } /* end of main loop */
+
+   /* Residual norm:  |Ax-b|**2 = b'b - x'A'b - x'(A'b - A'A x) */
+   if ( rnorm != NULL )
+   {
+      double sm      = btb;
+
+      for ( int jj = 0; jj < n; jj++ )
+         sm            -= x[ jj ] * ( atb[ jj ] + w[ jj ] );
+
+      *rnorm         = sqrt( qMax( 0.0, sm ) );
+   }
+
+   if ( nchange != NULL )
+      *nchange       = nchg;
+
+   return ret;
+}
+
+int US_Math2::nnls_ne( double* a, int a_dim1, int m, int n,
+                       double* b, double* x, double* rnorm, int nthreads,
+                       bool warm, int* nchange )
+{
+   /* Check the parameters and data */
+   if ( m <= 0 || n <= 0 || a == NULL || b == NULL || x == NULL ) return 2;
+
+   QVector< double > ataVec( n * n );
+   QVector< double > atbVec( n );
+   double btb     = 0.0;
+
+   nnls_gram( a, a_dim1, m, n, b, ataVec.data(), atbVec.data(), &btb,
+              nthreads );
+
+   return nnls_normal( ataVec.constData(), atbVec.constData(), n, x,
+                       btb, rnorm, warm, nchange );
+}
+
+/*****************************************************************************
+ *
+ *  Solve the normal equations restricted to the passive set:
+ *    (A'A)[P,P] s = (A'b)[P]
+ *  by Cholesky decomposition into the np by np work array chw[].
+ *  Function returns false if the submatrix is not positive definite.
+ */
+bool US_Math2::_nnls_psolve( const double* ata, const double* atb, int n,
+                             const int* pidx, int np, double* chw,
+                             double* s )
+{
+   /* Lower-triangular factor, column-major */
+   for ( int kj = 0; kj < np; kj++ )
+   {
+      const double* atac = ata + pidx[ kj ] * n;
+
+      for ( int ki = kj; ki < np; ki++ )
+         chw[ ki + kj * np ] = atac[ pidx[ ki ] ];
+   }
+
+   for ( int kj = 0; kj < np; kj++ )
+   {
+      double* cj     = chw + kj * np;
+      double  diag   = cj[ kj ];
+      double  dorig  = diag;
+
+      for ( int kk = 0; kk < kj; kk++ )
+         diag          -= chw[ kj + kk * np ] * chw[ kj + kk * np ];
+
+      if ( diag <= ( 16.0 * DBL_EPSILON * dorig )  ||  dorig <= 0.0 )
+         return false;
+
+      diag           = sqrt( diag );
+      cj[ kj ]       = diag;
+
+      for ( int ki = kj + 1; ki < np; ki++ )
+      {
+         double sum     = cj[ ki ];
+
+         for ( int kk = 0; kk < kj; kk++ )
+            sum           -= chw[ ki + kk * np ] * chw[ kj + kk * np ];
+
+         cj[ ki ]       = sum / diag;
+      }
+   }
+
+   /* Forward substitution, L y = (A'b)[P] */
+   for ( int ki = 0; ki < np; ki++ )
+   {
+      double sum     = atb[ pidx[ ki ] ];
+
+      for ( int kk = 0; kk < ki; kk++ )
+         sum           -= chw[ ki + kk * np ] * s[ kk ];
+
+      s[ ki ]        = sum / chw[ ki + ki * np ];
+   }
+
+   /* Back substitution, L' s = y */
+   for ( int ki = np - 1; ki >= 0; ki-- )
+   {
+      const double* ci = chw + ki * np;
+      double sum     = s[ ki ];
+
+      for ( int kk = ki + 1; kk < np; kk++ )
+         sum           -= ci[ kk ] * s[ kk ];
+
+      s[ ki ]        = sum / ci[ ki ];
+   }
+
+   return true;
+}
+
 /*****************************************************************************
  *
  *  Compute orthogonal rotation matrix:
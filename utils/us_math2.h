@@ -262,6 +262,113 @@ class US_UTIL_EXTERN US_Math2
          int*    indexp = NULL
          );
 
+      /*! \brief Compute the normal-equations products of a matrix.
+
+      Computes the n by n product A'A, the n-vector A'b and, optionally,
+      the scalar b'b for a column-major m by n matrix A. The product is
+      accumulated over blocks of rows so that the columns of a block
+      remain in cache. Threads each compute whole columns of A'A, so the
+      results do not depend on the number of threads. Both triangles of
+      A'A are filled. When built with the BLAS backend (US_BLAS), the
+      products come from dsyrk and dgemv, and nthreads is not used.
+
+      \param a        The m by n column-major matrix A (unchanged).
+      \param a_dim1   Storage increment between columns of a[].
+      \param m        Rows of A.
+      \param n        Columns of A.
+      \param b        The m-vector B (unchanged).
+      \param ata      On exit, the n by n matrix A'A.
+      \param atb      On exit, the n-vector A'b.
+      \param btb      If not NULL, on exit contains b'b.
+      \param nthreads Number of threads to use in computing A'A.
+      */
+      static void nnls_gram( const double* a, int a_dim1, int m, int n,
+                             const double* b, double* ata, double* atb,
+                             double* btb = NULL, int nthreads = 1 );
+
+      /*! \brief Compute the normal-equations products of a sparse matrix.
+
+      As nnls_gram(), for an m by n matrix A held in compressed-column
+      form:  the nonzero values of column j, with their row indices in
+      ascending order, are a_vals[k] and a_rows[k] for k from a_cptr[j]
+      to a_cptr[j+1]-1. Each column of A'A is computed by scattering one
+      column into a work vector and gathering against the others, so the
+      work is proportional to n times the count of nonzero values rather
+      than to n*n*m. Threads each compute whole columns of A'A, and both
+      triangles of A'A are filled.
+
+      \param a_vals   Nonzero values of A, column by column.
+      \param a_rows   Row index of each nonzero value.
+      \param a_cptr   Start of each column in a_vals[] (n+1 values).
+      \param m        Rows of A.
+      \param n        Columns of A.
+      \param b        The m-vector B (unchanged).
+      \param ata      On exit, the n by n matrix A'A.
+      \param atb      On exit, the n-vector A'b.
+      \param btb      If not NULL, on exit contains b'b.
+      \param nthreads Number of threads to use in computing A'A.
+      */
+      static void nnls_gram_csc( const double* a_vals, const int* a_rows,
+                                 const int* a_cptr, int m, int n,
+                                 const double* b, double* ata, double* atb,
+                                 double* btb = NULL, int nthreads = 1 );
+
+      /*! \brief NNLS of the normal equations (A'A) x = A'b.
+
+      An active-set NNLS (Bro and De Jong's "fast NNLS" variant of the
+      Lawson-Hanson algorithm) applied to the n by n normal equations.
+      Subproblems are solved by Cholesky decomposition of the passive-set
+      submatrix. A column found to be linearly dependent on the current
+      passive set is not brought into the solution. Returns as for nnls().
+
+      With a warm start, the positive values of x[] on entry (typically
+      the solution of a previous, related problem) form the initial
+      passive set. That set is first reduced until its subproblem
+      solution is positive, so that a good guess of the solution support
+      needs only a few active-set changes.
+
+      \param ata      The n by n matrix A'A (unchanged).
+      \param atb      The n-vector A'b (unchanged).
+      \param n        Order of the system.
+      \param x        On exit, the solution vector. On entry, if warm
+                      is true, the initial solution estimate.
+      \param btb      The scalar b'b, used to compute rnorm.
+      \param rnorm    If not NULL, on exit the Euclidean norm of the
+                      residual vector A*x-b.
+      \param warm     Flag to start from the passive set of input x[].
+      \param nchange  If not NULL, on exit the number of active-set
+                      changes (columns added or removed) made.
+      */
+      static int nnls_normal( const double* ata, const double* atb, int n,
+                              double* x, double btb = 0.0,
+                              double* rnorm = NULL, bool warm = false,
+                              int* nchange = NULL );
+
+      /*! \brief NNLS via the normal equations, with the nnls() interface.
+
+      Solves the same problem as nnls(), but by forming A'A and A'b with
+      nnls_gram() and solving them with nnls_normal(). Unlike nnls(),
+      the contents of a[] and b[] are left unchanged. Since the normal
+      equations square the condition number, this is intended for
+      tall, well-conditioned (for example, regularized) problems.
+
+      \param a        The m by n column-major matrix A.
+      \param a_dim1   Storage increment between columns of a[].
+      \param m        Rows of A.
+      \param n        Columns of A.
+      \param b        The m-vector B.
+      \param x        On exit, the solution vector. On entry, if warm
+                      is true, the initial solution estimate.
+      \param rnorm    If not NULL, on exit the residual norm.
+      \param nthreads Number of threads to use in forming A'A.
+      \param warm     Flag to warm start as in nnls_normal().
+      \param nchange  If not NULL, on exit the active-set change count.
+      */
+      static int nnls_ne( double* a, int a_dim1, int m, int n,
+                          double* b, double* x, double* rnorm = NULL,
+                          int nthreads = 1, bool warm = false,
+                          int* nchange = NULL );
+
       /*! \brief Remove high frequency noise from a signal
           \param array   Data to be smoothed.  This array will be modified.
           \param smooth  Number of values to smooth to be considered when 
@@ -297,6 +404,8 @@ class US_UTIL_EXTERN US_Math2
       static void _nnls_g1 ( double a, double b, double*, double*, double* );
       static int  _nnls_h12( int, int, int, int m, double*, int,
                              double*, double *, int, int, int );
+      static bool _nnls_psolve( const double*, const double*, int,
+                                const int*, int, double*, double* );
 };
 #endif
 
@@ -2,6 +2,7 @@
 
 #include "us_matrix.h"
 #include "us_math2.h"
+#include "us_blas.h"
 
 #include <QtCore>
 
@@ -97,6 +98,25 @@ bool US_Matrix::Cholesky_Decomposition( double** a, int n )
    double sum;
    double diff;
 
+#ifdef US_BLAS
+   if ( US_Blas::contiguous( a, n, n ) )
+   {  // Factor the lower triangle with LAPACK
+      if ( LAPACKE_dpotrf( LAPACK_ROW_MAJOR, 'L', n, a[ 0 ], n ) != 0 )
+      {
+         qDebug() << "Cholesky_Decomposition not positive definite.";
+         return false;
+      }
+
+      for ( int i = 0; i < n - 1; i++ )
+      {
+         for ( int j = i + 1; j < n; j++ ) 
+            a[ i ][ j ] = 0.0;
+      }
+
+      return true;
+   }
+#endif
+
    for ( int i = 0; i < n; i++ )
    {
       sum = 0.0;
@@ -144,6 +164,17 @@ bool US_Matrix::Cholesky_Decomposition( double** a, int n )
 */
 bool US_Matrix::Cholesky_SolveSystem( double** L, double* b, int n ) 
 {
+#ifdef US_BLAS
+   if ( US_Blas::contiguous( L, n, n ) )
+   {  // Forward and backward substitution with BLAS
+      cblas_dtrsv( CblasRowMajor, CblasLower, CblasNoTrans, CblasNonUnit,
+                   n, L[ 0 ], n, b, 1 );
+      cblas_dtrsv( CblasRowMajor, CblasLower, CblasTrans,   CblasNonUnit,
+                   n, L[ 0 ], n, b, 1 );
+      return true;
+   }
+#endif
+
 QString t;
    // Forward substitution:
    for ( int i = 0; i < n; i++ )
@@ -229,6 +260,16 @@ double** US_Matrix::construct( QVector< double* >& QVm,
 //   since that is all that is required in Cholesky decomposition.
 void US_Matrix::tmm( double** AA, double** CC, int rows, int columns )
 {
+#ifdef US_BLAS
+   if ( US_Blas::contiguous( AA, rows, columns )  &&
+        US_Blas::contiguous( CC, columns, columns ) )
+   {  // Symmetric rank-k update for the lower triangle
+      cblas_dsyrk( CblasRowMajor, CblasLower, CblasTrans, columns, rows,
+                   1.0, AA[ 0 ], columns, 0.0, CC[ 0 ], columns );
+      return;
+   }
+#endif
+
    QVector< double > ATvec( rows );
    double* ATrow = ATvec.data();            // Array for a transpose row
 
@@ -309,6 +350,18 @@ void US_Matrix::tvv( double** AA, double* bb, double* cc,
 void US_Matrix::mmm( double** AA, double** BB, double** CC,
       int rows, int size, int columns )
 {
+#ifdef US_BLAS
+   if ( US_Blas::contiguous( AA, rows, size    )  &&
+        US_Blas::contiguous( BB, size, columns )  &&
+        US_Blas::contiguous( CC, rows, columns ) )
+   {
+      cblas_dgemm( CblasRowMajor, CblasNoTrans, CblasNoTrans,
+                   rows, columns, size, 1.0, AA[ 0 ], size,
+                   BB[ 0 ], columns, 0.0, CC[ 0 ], columns );
+      return;
+   }
+#endif
+
    for ( int ii = 0; ii < rows; ii++ )
    {
       for ( int jj = 0; jj < columns; jj++ )
@@ -432,6 +485,28 @@ void US_Matrix::print_matrix( double** A, int rows, int columns )
 
 void US_Matrix::LU_Decomposition( double** matrix, int* index, bool parity, int n )
 {
+#ifdef US_BLAS
+   if ( US_Blas::contiguous( matrix, n, n ) )
+   {  // LAPACK factors in the same form:  unit L below, U on and above
+      //  the diagonal, with each row interchange recorded in index
+      QVector< lapack_int > ipiv( n );
+
+      if ( LAPACKE_dgetrf( LAPACK_ROW_MAJOR, n, n, matrix[ 0 ], n,
+                           ipiv.data() ) > 0 )
+         qDebug() << "Singular Matrix";
+
+      for ( int j = 0; j < n; j++ )
+      {
+         index[ j ] = ipiv[ j ] - 1;
+
+         // replace zeroes on the diagonal with a small number.
+         if ( matrix[ j ][ j ] == 0.0 ) matrix[ j ][ j ] = 1.0E-20;
+      }
+
+      return;
+   }
+#endif
+
    // imax is position of largest element in the row.
    int imax = 0;
    
@@ -848,6 +923,21 @@ void ata_d_thr_t::run() {
 
 void US_Matrix::calc_A_transpose_A(double ***A, double ***product, unsigned int rows, unsigned int columns, unsigned int threads)
 {
+#ifdef US_BLAS
+   if ( US_Blas::contiguous( *A, rows, columns )  &&
+        US_Blas::contiguous( *product, columns, columns ) )
+   {  // Dense symmetric rank-k update, then fill the upper triangle
+      cblas_dsyrk( CblasRowMajor, CblasLower, CblasTrans, columns, rows,
+                   1.0, (*A)[ 0 ], columns, 0.0, (*product)[ 0 ], columns );
+
+      for ( unsigned int i = 0; i < columns; i++ )
+         for ( unsigned int j = i + 1; j < columns; j++ )
+            (*product)[ i ][ j ] = (*product)[ j ][ i ];
+
+      return;
+   }
+#endif
+
    QVector <dpairs> data_pairs, m, n;
    QVector <QVector <dpairs> > dataarray;
    dpairs temp_pair;
@@ -0,0 +1,631 @@
+//! \file us_sim_cache.cpp
+#include "us_sim_cache.h"
+#include "us_defines.h"
+
+#define DEF_BUDGET_MB 0            // Default cache memory budget in MB
+#define STORE_MAGIC   0x55533342   // "US3B":  basis store file
+#define STORE_VERSION 2            // Basis store file format version
+#define STORE_SUFFIX  ".bas"       // Basis store file name suffix
+
+static QMutex cache_mutex;                                  // Cache lock
+static QCache< QByteArray, QVector< double > > sim_cache( DEF_BUDGET_MB * 640 );
+static int    budget_mb  = DEF_BUDGET_MB;                   // Budget in MB
+static int    cache_hits = 0;                               // Fetches found
+static int    cache_miss = 0;                               // Fetches missed
+static QCache< QByteArray, QVector< double > > gram_cache( DEF_BUDGET_MB * 256 );
+static int    gram_hits  = 0;                               // A'A found
+static int    gram_miss  = 0;                               // A'A missed
+static QCache< QByteArray, US_DataIO::RawData > data_cache( DEF_BUDGET_MB * 128 );
+
+static QMutex  store_mutex;                                 // Store lock
+static QString store_dir;                 // Basis store directory (or empty)
+static qint64  store_limit = 0;                             // Limit in bytes
+static qint64  store_bytes = 0;                             // Bytes used
+static QStringList    store_files;          // Store files known, oldest first
+static QList< qint64 > store_sizes;                         // Their sizes
+static int     store_hits  = 0;                             // Reads found
+static int     store_miss  = 0;                             // Reads missed
+
+// Compose the versioned key of a basis store file and return its path.
+//  Simulations by another release are not reused.
+static QString store_path( const QByteArray& skey, QByteArray& vkey )
+{
+   vkey           = US_Version.toLatin1() + '|' + skey;
+
+   return store_dir + "/" + QString( QCryptographicHash::hash(
+             vkey, QCryptographicHash::Md5 ).toHex() ) + STORE_SUFFIX;
+}
+
+// Return the header length of a basis store file with a given key length
+static int store_header( int klen )
+{
+   return ( 4 * sizeof( qint32 ) + klen + 7 ) & ~7;
+}
+
+// Read values from the basis store (memory-mapped), if present
+static bool store_read( const QByteArray& skey, QVector< double >& cvals )
+{
+   QByteArray vkey;
+   QString    path;
+
+   {
+      QMutexLocker locker( &store_mutex );
+
+      if ( store_dir.isEmpty() )
+         return false;
+
+      path           = store_path( skey, vkey );
+   }
+
+   QFile  filei( path );
+   bool   found   = false;
+
+   if ( filei.open( QIODevice::ReadOnly ) )
+   {
+      qint64 fsize   = filei.size();
+      int    hlen    = store_header( vkey.size() );
+      uchar* fmap    = ( fsize > hlen ) ? filei.map( 0, fsize ) : NULL;
+
+      if ( fmap != NULL )
+      {  // Verify the header and full key, then copy the values
+         const qint32* hdr = (const qint32*)fmap;
+         int    nvals   = hdr[ 3 ];
+
+         if ( hdr[ 0 ] == STORE_MAGIC  &&  hdr[ 1 ] == STORE_VERSION  &&
+              hdr[ 2 ] == vkey.size()  &&  nvals > 0  &&
+              fsize == hlen + (qint64)nvals * sizeof( double )  &&
+              memcmp( fmap + 4 * sizeof( qint32 ), vkey.constData(),
+                      vkey.size() ) == 0 )
+         {
+            cvals.resize( nvals );
+            memcpy( cvals.data(), fmap + hlen, nvals * sizeof( double ) );
+            found          = true;
+         }
+
+         filei.unmap( fmap );
+      }
+   }
+
+   QMutexLocker locker( &store_mutex );
+
+   if ( found )
+      store_hits++;
+   else
+      store_miss++;
+
+   return found;
+}
+
+// Remove the oldest basis store files known until usage is well under the
+//  limit. A file already removed by another process sharing the store is
+//  simply dropped from the list.
+static void store_prune( void )
+{
+   qint64 target  = ( store_limit / 10 ) * 9;
+
+   while ( store_bytes > target  &&  ! store_files.isEmpty() )
+   {
+      QFile::remove( store_files.takeFirst() );
+      store_bytes   -= store_sizes.takeFirst();
+   }
+}
+
+// List the files of the basis store (once, when it is set up)
+static void store_measure( void )
+{
+   QDir dir( store_dir );
+   QFileInfoList finfs = dir.entryInfoList(
+         QStringList( QString( "*" ) + STORE_SUFFIX ), QDir::Files,
+         QDir::Time | QDir::Reversed );
+
+   for ( int jj = 0; jj < finfs.size(); jj++ )
+   {
+      store_files << finfs[ jj ].absoluteFilePath();
+      store_sizes << finfs[ jj ].size();
+      store_bytes   += finfs[ jj ].size();
+   }
+}
+
+// Write values to the basis store.  The file is completed under a
+//  temporary name and then renamed, so that concurrent processes sharing
+//  the store never read a partial file.
+static void store_write( const QByteArray& skey, const QVector< double >& cvals )
+{
+   QByteArray vkey;
+   QString    path;
+
+   {
+      QMutexLocker locker( &store_mutex );
+
+      if ( store_dir.isEmpty() )
+         return;
+
+      path           = store_path( skey, vkey );
+   }
+
+   if ( QFile::exists( path ) )
+      return;
+
+   int    hlen    = store_header( vkey.size() );
+   qint32 hdr[ 4 ];
+   hdr[ 0 ]       = STORE_MAGIC;
+   hdr[ 1 ]       = STORE_VERSION;
+   hdr[ 2 ]       = vkey.size();
+   hdr[ 3 ]       = cvals.size();
+
+   QByteArray fdata( hlen, '\0' );
+   memcpy( fdata.data(), hdr, sizeof( hdr ) );
+   memcpy( fdata.data() + sizeof( hdr ), vkey.constData(), vkey.size() );
+   fdata.append( (const char*)cvals.constData(),
+                 cvals.size() * sizeof( double ) );
+
+   QTemporaryFile fileo( path + ".XXXXXX" );
+   fileo.setAutoRemove( false );
+
+   if ( ! fileo.open() )
+      return;
+
+   bool   ok      = ( fileo.write( fdata ) == fdata.size() );
+   QString tpath  = fileo.fileName();
+   fileo.close();
+
+   if ( ! ok  ||  ! QFile::rename( tpath, path ) )
+   {  // Failed, or another process stored the same values first
+      QFile::remove( tpath );
+      return;
+   }
+
+   QMutexLocker locker( &store_mutex );
+
+   store_files   << path;
+   store_sizes   << fdata.size();
+   store_bytes   += fdata.size();
+
+   if ( store_bytes > store_limit )
+      store_prune();
+}
+
+// Set the memory budget in megabytes (0 disables the cache)
+void US_SimCache::set_budget( int megabytes )
+{
+   QMutexLocker locker( &cache_mutex );
+
+   budget_mb      = qMax( 0, megabytes );
+
+   if ( budget_mb == 0 )
+   {
+      sim_cache .clear();
+      gram_cache.clear();
+      data_cache.clear();
+   }
+
+   // Cost of each entry is in kilobytes;  A'A gets a quarter of the budget,
+   //  whole data sets an eighth and single-solute columns the rest
+   sim_cache .setMaxCost( budget_mb * 640 );
+   gram_cache.setMaxCost( budget_mb * 256 );
+   data_cache.setMaxCost( budget_mb * 128 );
+}
+
+// Return the memory budget in megabytes
+int US_SimCache::budget( void )
+{
+   QMutexLocker locker( &cache_mutex );
+
+   return budget_mb;
+}
+
+// Remove all entries and reset statistics
+void US_SimCache::clear( void )
+{
+   QMutexLocker locker( &cache_mutex );
+
+   sim_cache.clear();
+   gram_cache.clear();
+   data_cache.clear();
+   cache_hits     = 0;
+   cache_miss     = 0;
+   gram_hits      = 0;
+   gram_miss      = 0;
+}
+
+// Set the basis store directory and size limit (0 MB disables the store)
+bool US_SimCache::set_store( const QString& directory, int megabytes )
+{
+   QMutexLocker locker( &store_mutex );
+
+   store_dir      = QString( "" );
+   store_limit    = (qint64)qMax( 0, megabytes ) * 1024 * 1024;
+   store_bytes    = 0;
+   store_hits     = 0;
+   store_miss     = 0;
+   store_files.clear();
+   store_sizes.clear();
+
+   if ( store_limit == 0  ||  directory.isEmpty() )
+      return true;
+
+   // Each format version has its own subdirectory
+   QString sdir   = directory + QString( "/v%1" ).arg( STORE_VERSION );
+
+   if ( ! QDir().mkpath( sdir ) )
+      return false;
+
+   store_dir      = QDir( sdir ).absolutePath();
+   store_measure();
+   store_prune();
+
+   return true;
+}
+
+// Return the basis store directory (empty if disabled)
+QString US_SimCache::store_directory( void )
+{
+   QMutexLocker locker( &store_mutex );
+
+   return store_dir;
+}
+
+// Return basis store hit/miss counts and current kilobytes used
+long int US_SimCache::store_statistics( int& hits, int& misses )
+{
+   QMutexLocker locker( &store_mutex );
+
+   hits           = store_hits;
+   misses         = store_miss;
+
+   return (long int)( store_bytes / 1024 );
+}
+
+// Add the simulation parameters that affect the Lamm equation solution
+//  to a fingerprint
+static void simparams_print( QDataStream& ds,
+                             US_SimulationParameters& simparams )
+{
+   ds << simparams.simpoints << (int)simparams.meshType
+      << (int)simparams.gridType << simparams.dt_tolerance
+      << simparams.radial_resolution
+      << simparams.meniscus << simparams.bottom << simparams.temperature
+      << simparams.band_forming << simparams.band_volume
+      << simparams.rotorcoeffs[ 0 ] << simparams.rotorcoeffs[ 1 ]
+      << simparams.firstScanIsConcentration << simparams.cp_sector
+      << simparams.cp_pathlen << simparams.cp_angle << simparams.cp_width
+      << simparams.mesh_radius;
+
+   for ( int jj = 0; jj < simparams.speed_step.size(); jj++ )
+   {
+      US_SimulationParameters::SpeedProfile* sp = &simparams.speed_step[ jj ];
+      ds << sp->duration_minutes << sp->delay_minutes << sp->w2t_first
+         << sp->w2t_last << sp->avg_speed << sp->duration_hours
+         << sp->delay_hours << sp->time_first << sp->time_last << sp->scans
+         << sp->rotorspeed << sp->acceleration << sp->acceleration_flag;
+   }
+
+   for ( int jj = 0; jj < simparams.sim_speed_prof.size(); jj++ )
+   {
+      US_SimulationParameters::SimSpeedProf* sp
+                       = &simparams.sim_speed_prof[ jj ];
+      ds << sp->acceleration << sp->w2t_b_accel << sp->w2t_e_accel
+         << sp->w2t_e_step << sp->avg_speed << sp->rotorspeed << sp->duration
+         << sp->time_b_accel << sp->time_e_accel << sp->time_f_scan
+         << sp->time_l_scan;
+   }
+}
+
+// Compose the fingerprint of a data grid (edited or raw) and parameters
+template< class T > static QByteArray grid_key(
+      US_SimulationParameters& simparams, T& edata )
+{
+   QByteArray dskey;
+
+   if ( US_SimCache::budget() == 0 )
+      return dskey;
+
+   QByteArray  fprint;
+   QDataStream ds( &fprint, QIODevice::WriteOnly );
+
+   simparams_print( ds, simparams );
+
+   // Experiment grid:  radii and scan times (but not the data readings)
+   ds << edata.xvalues;
+
+   for ( int ss = 0; ss < edata.scanData.size(); ss++ )
+   {
+      US_DataIO::Scan* escan = &edata.scanData[ ss ];
+      ds << escan->seconds << escan->omega2t << escan->rpm
+         << escan->temperature;
+   }
+
+   dskey          = QCryptographicHash::hash( fprint, QCryptographicHash::Md5 );
+
+   return dskey;
+}
+
+// Compose the fingerprint of the data set grid and simulation parameters
+QByteArray US_SimCache::dataset_key( US_SimulationParameters& simparams,
+                                     US_DataIO::EditedData& edata )
+{
+   return grid_key( simparams, edata );
+}
+
+// Compose the fingerprint of a raw data grid and simulation parameters
+QByteArray US_SimCache::dataset_key( US_SimulationParameters& simparams,
+                                     US_DataIO::RawData& rdata )
+{
+   return grid_key( simparams, rdata );
+}
+
+// Compose the fingerprint of the simulation grid alone, for the basis store.
+//  Simulations that depend on the data grid are not stored:  those with
+//  the first scan as initial concentration, with steps adapted to scan
+//  times, or with more than one speed step.
+QByteArray US_SimCache::simulation_key( US_SimulationParameters& simparams )
+{
+   QByteArray sgkey;
+
+   if ( store_directory().isEmpty()  ||
+        simparams.firstScanIsConcentration  ||
+        simparams.dt_tolerance > 0.0  ||
+        simparams.speed_step.size() != 1 )
+      return sgkey;
+
+   QByteArray  fprint;
+   QDataStream ds( &fprint, QIODevice::WriteOnly );
+
+   simparams_print( ds, simparams );
+
+   sgkey          = QCryptographicHash::hash( fprint, QCryptographicHash::Md5 );
+
+   return sgkey;
+}
+
+// Compose the key for one experiment-space component and data set
+QByteArray US_SimCache::solute_key( const QByteArray& dskey,
+                                    US_Model::SimulationComponent& comp )
+{
+   const int ncvals = 8;
+   double cvals[ ncvals ];
+   cvals[ 0 ]     = comp.s;
+   cvals[ 1 ]     = comp.D;
+   cvals[ 2 ]     = comp.vbar20;
+   cvals[ 3 ]     = comp.mw;
+   cvals[ 4 ]     = comp.f_f0;
+   cvals[ 5 ]     = comp.sigma;
+   cvals[ 6 ]     = comp.delta;
+   cvals[ 7 ]     = comp.signal_concentration;
+
+   QByteArray skey( dskey );
+   skey.append( (const char*)cvals, sizeof( double ) * ncvals );
+
+   return skey;
+}
+
+// Fetch simulated concentrations for a key, if present
+bool US_SimCache::fetch( const QByteArray& skey, US_DataIO::RawData& simdat )
+{
+   QVector< double > cvals;
+   int    nscans  = simdat.scanCount();
+   int    npoints = simdat.pointCount();
+
+   {  // Copy (shallow) the cached vector while the cache is locked.
+      //  An entry of a different size is counted as a miss.
+      QMutexLocker locker( &cache_mutex );
+      QVector< double >* cached = sim_cache.object( skey );
+
+      if ( cached == NULL  ||  cached->size() != ( nscans * npoints ) )
+      {
+         cache_miss++;
+         return false;
+      }
+
+      cvals          = *cached;
+      cache_hits++;
+   }
+
+   const double* cv = cvals.constData();
+
+   for ( int ss = 0; ss < nscans; ss++ )
+   {
+      double* rv     = simdat.scanData[ ss ].rvalues.data();
+
+      for ( int rr = 0; rr < npoints; rr++ )
+         rv[ rr ]       = *(cv++);
+   }
+
+   return true;
+}
+
+// Store simulated concentrations for a key
+void US_SimCache::store( const QByteArray& skey, US_DataIO::RawData& simdat )
+{
+   int nscans     = simdat.scanCount();
+   int npoints    = simdat.pointCount();
+   QVector< double >* cvals = new QVector< double >( nscans * npoints );
+   double* cv     = cvals->data();
+
+   for ( int ss = 0; ss < nscans; ss++ )
+   {
+      const double* rv = simdat.scanData[ ss ].rvalues.constData();
+
+      for ( int rr = 0; rr < npoints; rr++ )
+         *(cv++)        = rv[ rr ];
+   }
+
+   int cost       = qMax( 1, ( cvals->size() * (int)sizeof( double )
+                               + skey.size() + 1023 ) / 1024 );
+
+   QMutexLocker locker( &cache_mutex );
+
+   if ( budget_mb == 0 )
+   {
+      delete cvals;
+      return;
+   }
+
+   // The cache takes ownership (and deletes any entry over budget)
+   sim_cache.insert( skey, cvals, cost );
+}
+
+// Fetch a raw simulation grid from the basis store, if present.
+//  Values are the scan and point counts, the radii, then the time,
+//  omega2t and concentrations of each scan.
+bool US_SimCache::fetch_simout( const QByteArray& sgkey,
+                                US_DataIO::RawData& sgrid )
+{
+   QVector< double > gvals;
+
+   if ( ! store_read( sgkey, gvals )  ||  gvals.size() < 2 )
+      return false;
+
+   const double* gv = gvals.constData();
+   int    nscans  = (int)gv[ 0 ];
+   int    npoints = (int)gv[ 1 ];
+
+   if ( nscans < 1  ||  npoints < 1  ||
+        gvals.size() != ( 2 + npoints + nscans * ( 2 + npoints ) ) )
+      return false;
+
+   gv            += 2;
+   sgrid.xvalues.resize( npoints );
+   sgrid.scanData.resize( nscans );
+
+   for ( int rr = 0; rr < npoints; rr++ )
+      sgrid.xvalues[ rr ] = *(gv++);
+
+   for ( int ss = 0; ss < nscans; ss++ )
+   {
+      US_DataIO::Scan* gscan = &sgrid.scanData[ ss ];
+      gscan->seconds = *(gv++);
+      gscan->omega2t = *(gv++);
+      gscan->rvalues.resize( npoints );
+      double* rv     = gscan->rvalues.data();
+
+      for ( int rr = 0; rr < npoints; rr++ )
+         rv[ rr ]       = *(gv++);
+   }
+
+   return true;
+}
+
+// Store a raw simulation grid in the basis store
+void US_SimCache::store_simout( const QByteArray& sgkey,
+                                US_DataIO::RawData& sgrid )
+{
+   int nscans     = sgrid.scanCount();
+   int npoints    = sgrid.pointCount();
+
+   if ( nscans < 1  ||  npoints < 1 )
+      return;
+
+   QVector< double > gvals( 2 + npoints + nscans * ( 2 + npoints ) );
+   double* gv     = gvals.data();
+   *(gv++)        = (double)nscans;
+   *(gv++)        = (double)npoints;
+
+   for ( int rr = 0; rr < npoints; rr++ )
+      *(gv++)        = sgrid.xvalues[ rr ];
+
+   for ( int ss = 0; ss < nscans; ss++ )
+   {
+      US_DataIO::Scan* gscan = &sgrid.scanData[ ss ];
+      const double* rv = gscan->rvalues.constData();
+      *(gv++)        = gscan->seconds;
+      *(gv++)        = gscan->omega2t;
+
+      for ( int rr = 0; rr < npoints; rr++ )
+         *(gv++)        = rv[ rr ];
+   }
+
+   store_write( sgkey, gvals );
+}
+
+// Fetch a simulated data set for a key, if present
+bool US_SimCache::fetch_data( const QByteArray& dkey,
+                              US_DataIO::RawData& sdata )
+{
+   QMutexLocker locker( &cache_mutex );
+   US_DataIO::RawData* cached = data_cache.object( dkey );
+
+   if ( cached == NULL )
+      return false;
+
+   sdata          = *cached;      // Shallow copy of shared data
+
+   return true;
+}
+
+// Store a simulated data set for a key
+void US_SimCache::store_data( const QByteArray& dkey,
+                              US_DataIO::RawData& sdata )
+{
+   int cost       = qMax( 1, ( sdata.scanCount() * sdata.pointCount()
+                               * (int)sizeof( double ) + dkey.size()
+                               + 1023 ) / 1024 );
+
+   QMutexLocker locker( &cache_mutex );
+
+   if ( budget_mb == 0 )
+      return;
+
+   // The cache takes ownership (and deletes any entry over budget)
+   data_cache.insert( dkey, new US_DataIO::RawData( sdata ), cost );
+}
+
+// Fetch an A'A matrix for a key, if present
+bool US_SimCache::fetch_gram( const QByteArray& gkey, QVector< double >& ata )
+{
+   QMutexLocker locker( &cache_mutex );
+   QVector< double >* cached = gram_cache.object( gkey );
+
+   if ( cached == NULL )
+   {
+      gram_miss++;
+      return false;
+   }
+
+   ata            = *cached;      // Shallow copy
+   gram_hits++;
+
+   return true;
+}
+
+// Store an A'A matrix for a key
+void US_SimCache::store_gram( const QByteArray& gkey,
+                              const QVector< double >& ata )
+{
+   QVector< double >* cvals = new QVector< double >( ata );
+   int cost       = qMax( 1, ( ata.size() * (int)sizeof( double )
+                               + gkey.size() + 1023 ) / 1024 );
+
+   QMutexLocker locker( &cache_mutex );
+
+   if ( budget_mb == 0 )
+   {
+      delete cvals;
+      return;
+   }
+
+   gram_cache.insert( gkey, cvals, cost );
+}
+
+// Return A'A hit/miss counts and entry count
+int US_SimCache::gram_statistics( int& hits, int& misses )
+{
+   QMutexLocker locker( &cache_mutex );
+
+   hits           = gram_hits;
+   misses         = gram_miss;
+
+   return gram_cache.count();
+}
+
+// Return hit/miss counts, entry count and current kilobytes used
+long int US_SimCache::statistics( int& hits, int& misses, int& entries )
+{
+   QMutexLocker locker( &cache_mutex );
+
+   hits           = cache_hits;
+   misses         = cache_miss;
+   entries        = sim_cache.count();
+
+   return (long int)sim_cache.totalCost();
+}
@@ -0,0 +1,171 @@
+//! \file us_sim_cache.h
+#ifndef US_SIM_CACHE_H
+#define US_SIM_CACHE_H
+
+#include <QtCore>
+
+#include "us_extern.h"
+#include "us_dataIO.h"
+#include "us_model.h"
+#include "us_simparms.h"
+
+//! \brief Bounded cache of single-solute simulations
+//!
+//! This class keeps the simulated concentrations for single-component
+//! models, keyed by the experiment-space component attributes and by a
+//! fingerprint of the simulation parameters and edited data grid. It
+//! allows calc_residuals() to skip repeated Lamm equation solutions for
+//! solutes that reappear in refinement iterations and Monte Carlo passes.
+//! Least recently used entries are dropped once the memory budget is
+//! exceeded. A quarter of the budget holds the normal-equation matrices
+//! (A'A) of solved simulation sets, so that a set solved again against
+//! new data (as in Monte Carlo iterations) only needs A'b recomputed.
+//! An eighth holds whole simulated data sets, such as the co-sedimenting
+//! salt of ASTFVM solutions; the rest holds single-solute columns.
+//! The cache is disabled until a budget is set (us_mpi_analysis job
+//! parameter simcache_mb).
+//!
+//! Simulations may also be kept in a persistent basis store on disk,
+//! shared by processes and runs that use the same simulation parameters.
+//! The store holds the raw simulation grid of each solute, before it is
+//! interpolated onto a data grid, so that data sets (cells) differing only
+//! in their scan times and radii share it. Store files are memory-mapped
+//! for reading, versioned by file format and release, and the oldest are
+//! removed when the store exceeds its size limit. The store is used
+//! whether or not the memory cache is enabled.
+//! All methods are static and thread-safe.
+//!
+class US_UTIL_EXTERN US_SimCache
+{
+   public:
+      //! \brief Set the memory budget of the cache
+      //!
+      //! \param megabytes Budget in MB (0, the default, to disable the cache)
+      static void set_budget( int );
+
+      //! \brief Return the memory budget of the cache
+      //!
+      //! \returns      Budget in MB (0 if disabled)
+      static int budget( void );
+
+      //! \brief Remove all cached simulations
+      static void clear( void );
+
+      //! \brief Set the persistent basis store of simulations
+      //!
+      //! \param directory Store directory (created if need be)
+      //! \param megabytes Store size limit in MB (0 to disable the store)
+      //! \returns         Flag if the store could be set up
+      static bool set_store( const QString&, int );
+
+      //! \brief Return the basis store directory (empty if disabled)
+      static QString store_directory( void );
+
+      //! \brief Return cumulative basis store statistics
+      //!
+      //! \param hits      Returned count of reads found
+      //! \param misses    Returned count of reads not found
+      //! \returns         Disk space currently used by the store in KB
+      static long int store_statistics( int&, int& );
+
+      //! \brief Compose the fingerprint of a data set's simulation grid
+      //!
+      //! \param simparams Simulation parameters for the data set
+      //! \param edata     Edited data supplying the radius/time grid
+      //! \returns         Data set key (empty if the cache is disabled)
+      static QByteArray dataset_key( US_SimulationParameters&,
+                                     US_DataIO::EditedData& );
+
+      //! \brief Compose the fingerprint of a raw data simulation grid
+      //!
+      //! \param simparams Simulation parameters for the data set
+      //! \param rdata     Raw data supplying the radius/time grid
+      //! \returns         Data set key (empty if the cache is disabled)
+      static QByteArray dataset_key( US_SimulationParameters&,
+                                     US_DataIO::RawData& );
+
+      //! \brief Compose the fingerprint of a simulation grid for the store
+      //!
+      //! \param simparams Simulation parameters for the data set
+      //! \returns         Simulation key (empty if the store is disabled, or
+      //!                  if the simulation depends on the data grid)
+      static QByteArray simulation_key( US_SimulationParameters& );
+
+      //! \brief Compose the key for a component simulated for a data set
+      //!
+      //! \param dskey     Data set key from dataset_key() (or
+      //!                  simulation_key())
+      //! \param comp      Experiment-space model component
+      //! \returns         Solute simulation key
+      static QByteArray solute_key( const QByteArray&,
+                                    US_Model::SimulationComponent& );
+
+      //! \brief Fetch a cached simulation
+      //!
+      //! \param skey      Solute simulation key
+      //! \param simdat    Simulation data, initialized to the data grid,
+      //!                  whose concentrations are filled if found
+      //! \returns         Flag if the simulation was found in the cache
+      static bool fetch( const QByteArray&, US_DataIO::RawData& );
+
+      //! \brief Store a simulation in the cache
+      //!
+      //! \param skey      Solute simulation key
+      //! \param simdat    Simulation data to save
+      static void store( const QByteArray&, US_DataIO::RawData& );
+
+      //! \brief Fetch a raw simulation grid from the basis store
+      //!
+      //! \param sgkey     Solute key composed from simulation_key()
+      //! \param sgrid     Returned simulation grid data, if found
+      //! \returns         Flag if the simulation was found in the store
+      static bool fetch_simout( const QByteArray&, US_DataIO::RawData& );
+
+      //! \brief Store a raw simulation grid in the basis store
+      //!
+      //! \param sgkey     Solute key composed from simulation_key()
+      //! \param sgrid     Simulation grid data (US_Astfem_RSA simout)
+      static void store_simout( const QByteArray&, US_DataIO::RawData& );
+
+      //! \brief Fetch a cached simulated data set
+      //!
+      //! \param dkey      Key of the data set (as from solute_key())
+      //! \param sdata     Returned simulated data, if found
+      //! \returns         Flag if the data was found in the cache
+      static bool fetch_data( const QByteArray&, US_DataIO::RawData& );
+
+      //! \brief Store a simulated data set in the cache
+      //!
+      //! \param dkey      Key of the data set
+      //! \param sdata     Simulated data to save
+      static void store_data( const QByteArray&, US_DataIO::RawData& );
+
+      //! \brief Fetch a cached A'A matrix
+      //!
+      //! \param gkey      Key of the simulation set (see US_SolveSim)
+      //! \param ata       Returned A'A matrix, if found
+      //! \returns         Flag if the matrix was found in the cache
+      static bool fetch_gram( const QByteArray&, QVector< double >& );
+
+      //! \brief Store an A'A matrix in the cache
+      //!
+      //! \param gkey      Key of the simulation set
+      //! \param ata       A'A matrix to save
+      static void store_gram( const QByteArray&, const QVector< double >& );
+
+      //! \brief Return cumulative A'A cache statistics
+      //!
+      //! \param hits      Returned count of fetches found
+      //! \param misses    Returned count of fetches not found
+      //! \returns         Count of matrices in the cache
+      static int gram_statistics( int&, int& );
+
+      //! \brief Return cumulative cache statistics
+      //!
+      //! \param hits      Returned count of fetches found
+      //! \param misses    Returned count of fetches not found
+      //! \param entries   Returned count of simulations in the cache
+      //! \returns         Memory currently used by the cache in KB
+      static long int statistics( int&, int&, int& );
+};
+#endif
@@ -20,6 +20,7 @@ US_SimulationParameters::US_SimulationParameters()
    simpoints         = 200;
    meshType          = ASTFEM;
    gridType          = MOVING;
+   dt_tolerance      = 0.0;
    radial_resolution = 0.001;
    meniscus          = 5.8;
    bottom            = 7.2;
@@ -664,6 +665,9 @@ int US_SimulationParameters::load_simparms( QString fname )
             astr  = a.value( "simpoints"   ).toString();
             if ( !astr.isEmpty() )
                simpoints    = astr.toInt();
+            astr  = a.value( "dttolerance" ).toString();
+            if ( !astr.isEmpty() )
+               dt_tolerance = astr.toDouble();
             astr  = a.value( "radialres"   ).toString();
             if ( !astr.isEmpty() )
                radial_resolution = astr.toDouble();
@@ -772,6 +776,10 @@ int US_SimulationParameters::save_simparms( QString fname )
       xml.writeAttribute   ( "meshType",    QString( mesh[ (int)meshType ] ) );
       xml.writeAttribute   ( "gridType",    QString( grid[ (int)gridType ] ) );
       xml.writeAttribute   ( "simpoints",   QString::number( simpoints ) );
+
+      if ( dt_tolerance > 0.0 )
+         xml.writeAttribute   ( "dttolerance", QString::number( dt_tolerance ) );
+
       xml.writeAttribute   ( "radialres", QString::number( radial_resolution ));
       xml.writeAttribute   ( "meniscus",    QString::number( meniscus ) );
       xml.writeAttribute   ( "bottom",      QString::number( bottom ) );
@@ -1225,6 +1233,7 @@ void US_SimulationParameters::debug( void )
    qDebug() << "Simpoints       :" << simpoints;
    qDebug() << "Mesh Type       :" << meshType;
    qDebug() << "Grid Type       :" << gridType;
+   qDebug() << "Time Step Toler.:" << dt_tolerance;
    qDebug() << "Radial Res      :" << radial_resolution;
    qDebug() << "Meniscus        :" << meniscus;
    qDebug() << "Bottom Pos      :" << bottom_position;
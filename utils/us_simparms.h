@@ -154,6 +154,9 @@ class US_UTIL_EXTERN US_SimulationParameters
    int       simpoints;         //!< number of radial grid points used in sim
    MeshType  meshType;          //!< Type of radial grid 
    GridType  gridType;          //!< Designation if grid is fixed or can move
+   double    dt_tolerance;      //!< Local error tolerance (relative to peak
+                                //!< concentration) for adaptive time steps
+                                //!< on a fixed grid (0 for fixed steps)
    double    radial_resolution; //!< The radial datapoint increment/resolution 
                                 //!< of the final data
    double    meniscus;          //!< Meniscus position at first constant speed
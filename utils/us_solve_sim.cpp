@@ -29,6 +29,11 @@ US_SolveSim::US_SolveSim( QList< DataSet* >& data_sets, int thrnrank,
    dbg_level    = 0;         // Default: no debug prints
    dbg_timing   = false;     // Default: no debug timing prints
    banddthr     = false;     // Default: no bandform data_threshold
+   sim_vals_p   = NULL;      // No current calc_residuals simulation
+   bf_data      = NULL;
+   sim_out      = NULL;
+   sim_zero     = NULL;
+   sim_fchk     = NULL;
 
    // If band-forming, possibly read in threshold control values
    if ( data_sets[ 0 ]->simparams.band_forming )
@@ -83,6 +88,9 @@ US_SolveSim::Simulation::Simulation()
    dbg_level     = 0;
    dbg_timing    = false;
    noisflag      = 0;
+   nthreads      = 1;
+   nnls_mode     = 0;
+   sim_precision = 0;
 }
 
 // Static function to check the grid size implied by data and model
@@ -92,6 +100,7 @@ bool US_SolveSim::checkGridSize( QList< DataSet* >& data_sets,
    const long tstep_max = 10000L;
    bool   too_large = false;
    double s_show    = s_max * 1.0e13;
+   int    dbg_level = US_Settings::us_debug();
    smsg             = QString( "" );
 
    for ( int dd = 0; dd < data_sets.size(); dd++ )
@@ -122,9 +131,17 @@ bool US_SolveSim::checkGridSize( QList< DataSet* >& data_sets,
 //if(thrnrank==1) DbgLv(1) << "CK: tsteps" << tsteps << "dt omg rpm" << dt << omega_s << rpm_max
 // << "bot men rat sfac spts tmax" << bottom << meniscus << lgbmrat << somgfac << rsimpts << time_max;
 
+      // Adaptive steps (dt_tolerance on a fixed grid) are counted by
+      //  simulating the largest solute, since their number is only known
+      //  once taken
+      if ( tsteps > tstep_max  &&  sparams->dt_tolerance > 0.0  &&
+           sparams->gridType == US_SimulationParameters::FIXED )
+         tsteps           = adaptive_steps( data_sets[ dd ], s_max );
+
       if ( tsteps > tstep_max )
       {
-qDebug() << "CK: tsteps" << tsteps << "dt omg rpm" << dt << omega_s << rpm_max
+if ( dbg_level > 0 )
+ qDebug() << "CK: tsteps" << tsteps << "dt omg rpm" << dt << omega_s << rpm_max
  << "bot men rat sfac spts tmax" << bottom << meniscus << lgbmrat
  << somgfac << rsimpts << time_max;
          too_large       = true;
@@ -145,6 +162,36 @@ qDebug() << "CK: tsteps" << tsteps << "dt omg rpm" << dt << omega_s << rpm_max
    return too_large;
 }
 
+// Count the time steps that adaptive stepping takes for the largest solute
+//  of a data set. A frictional ratio of 4 gives a sharp boundary and so
+//  many steps. Scans are streamed, so that only a few are held.
+long US_SolveSim::adaptive_steps( DataSet* dset, double s_max )
+{
+   US_Model model;
+   model.components.resize( 1 );
+   US_Model::SimulationComponent* sc = &model.components[ 0 ];
+   sc->s          = s_max;
+   sc->D          = 0.0;
+   sc->mw         = 0.0;
+   sc->f_f0       = 4.0;
+   sc->vbar20     = dset->vbar20;
+   US_Model::calc_coefficients( *sc );
+
+   US_DataIO::RawData simdat;
+   US_AstfemMath::initSimData( simdat, dset->run_data, 0.0 );
+
+   US_Astfem_RSA astfem_rsa( model, dset->simparams );
+   astfem_rsa.set_stream_flag( true );
+   astfem_rsa.calculate( simdat );
+
+   int  nfixed;
+   long ntaken    = (long)astfem_rsa.time_step_counts( nfixed );
+
+if ( US_Settings::us_debug() > 0 )
+ qDebug() << "CK: adaptive steps" << ntaken << "fixed" << nfixed;
+   return ntaken;
+}
+
 // Check the grid size implied by data and model (class method)
 bool US_SolveSim::check_grid_size( double s_max, QString& smsg )
 {
@@ -216,17 +263,14 @@ if(thrnrank<2) DbgLv(1) << "CR:zthr lthr mxod mfac"
 DbgLv(1) << "   CR:na nb nx" << navals << narows << nsolutes
  << "  nt ns" << ntotal << nsolutes;
 
-   QVector< double > nnls_a( navals,   0.0 );
+   QVector< double > nnls_a;            // Sized once A's form is known
    QVector< double > nnls_b( narows,   0.0 );
    QVector< double > nnls_x( nsolutes, 0.0 );
    QVector< double > tinvec( ntinois,  0.0 );
    QVector< double > rinvec( nrinois,  0.0 );
 
-   // Set up for a single-component model
-   US_Model model;
-   model.components.resize( 1 );
-
-   US_Model::SimulationComponent zcomponent; // Zeroed component to init models
+   // Set up the zeroed component used to init single-component models
+   zcomponent       = US_Model::SimulationComponent();
    zcomponent.s     = 0.0;
    zcomponent.D     = 0.0;
    zcomponent.mw    = 0.0;
@@ -281,6 +325,24 @@ DebugTime("BEG:calcres");
    }
 DbgLv(1) << "   CR:B fill kodl" << kodl;
 
+   // Band-forming and ODlimit-substituted A matrices are largely zero.
+   //  When the normal equations are chosen (nnls_mode 1) and only the
+   //  NNLS uses A, hold it in compressed-column form (nonzero values and
+   //  their rows, by column) and form the normal equations from it.
+   //  Lawson-Hanson (nnls_mode 0) keeps the dense A.
+   bool sparse_a = ( ( banddthr  ||  kodl > 0 )  &&
+                     ! calc_ti  &&  ! calc_ri  &&
+                     ( ASave == NULL  ||  BSave == NULL )  &&
+                     sim_vals.nnls_mode == 1 );
+   QVector< double > csc_vals;          // Sparse A nonzero values
+   QVector< int >    csc_rows;          // Sparse A row of each value
+   QVector< int >    csc_cptr;          // Sparse A start of each column
+
+   if ( sparse_a )
+      csc_cptr << 0;
+   else
+      nnls_a.fill( 0.0, navals );
+
 #if 0
    // If needed, scale the alpha used in A-matrix appendix diagonals
    if ( tikreg )
@@ -296,472 +358,317 @@ DbgLv(1) << "   CR:B fill kodl" << kodl;
    simulations.reserve( nsolutes * dataset_count );
 
    // Simulate data using models, each with a single s,f/f0 component
-   int    increp  = nsolutes / 10;                 // Progress report increment
-          increp  = ( increp < 10 ) ? 10 : increp;
-   int    kstep   = 0;                             // Progress step count
    int    ka      = 0;                             // nnls_a output index
    int    ksols   = 0;
-   int    stype   = data_sets[ offset ]->solute_type;
-DbgLv(1) << "   CR:BF STYPE" << stype;
+   s_type         = data_sets[ offset ]->solute_type;
+   use_zsols      = use_zsol;
+DbgLv(1) << "   CR:BF STYPE" << s_type;
+
+   // Compose simulation-cache fingerprints of each data set's grid,
+   //  and basis store fingerprints of each simulation grid
+   dskeys.clear();
+   sgkeys.clear();
+
+   for ( int ee = offset; ee < lim_offs; ee++ )
+   {
+      QByteArray dskey = US_SimCache::dataset_key( data_sets[ ee ]->simparams,
+                                                   data_sets[ ee ]->run_data );
+      QByteArray sgkey = US_SimCache::simulation_key(
+                                                   data_sets[ ee ]->simparams );
+
+      // Single precision simulations are cached apart from double ones
+      if ( ! dskey.isEmpty()  &&  sim_vals.sim_precision > 0 )
+         dskey         += 'f';
+
+      if ( ! sgkey.isEmpty()  &&  sim_vals.sim_precision > 0 )
+         sgkey         += 'f';
+
+      dskeys << dskey;
+      sgkeys << sgkey;
+   }
+
+   // Create grid contexts shared by all the simulations of each data set
+   qDeleteAll( dsgrids );
+   dsgrids.clear();
+
+   for ( int ee = offset; ee < lim_offs; ee++ )
+      dsgrids << new US_AstfemGrid( data_sets[ ee ]->simparams );
 
    if ( use_zsol )
       qSort( sim_vals.zsolutes );
    else
       qSort( sim_vals.solutes );
 
-   if ( stype == 0 )
+   if ( s_type == 0 )
    {  // Normal case of varying f/f0 with constant vbar
-      int attr_x     = 0;      // Default X is s
-      int attr_y     = 1;      // Default Y is f/f0
-      int attr_z     = 3;      // Default Z is vbar
-      int smask      = ( attr_x << 6 ) | ( attr_y << 3 ) | attr_z;
+      attr_x         = ATTR_S;    // Default X is s
+      attr_y         = ATTR_K;    // Default Y is f/f0
+      attr_z         = ATTR_V;    // Default Z is vbar
 DataSet* dset=data_sets[0];
 DbgLv(2) << "   CR:BF s20wcorr D20wcorr" << dset->s20w_correction
  << dset->D20w_correction << "manual" << dset->solution_rec.buffer.manual
  << "vbar20" << dset->vbar20;
+   }
 
-      for ( int cc = 0; cc < nsolutes; cc++ )
-      {  // Solve for each solute
-         if ( abort ) return;
-         int bx   = 0;
-
-         for ( int ee = offset; ee < lim_offs; ee++ )
-         {  // Solve for each data set
-            DataSet*               dset  = data_sets[ ee ];
-            US_DataIO::EditedData* edata = banddthr ? &wdata : &dset->run_data;
-            US_DataIO::RawData     simdat;
-            int npoints = edata->pointCount();
-            int nscans  = edata->scanCount();
-            zcomponent.vbar20     = dset->vbar20;
-
-            // Set model with standard space s and k
-            if ( use_zsol )
-            {
-               US_ZSolute::set_mcomp_values( model.components[ 0 ],
-                                             sim_vals.zsolutes[ cc ], smask );
-            }
-            else
-            {
-               model.components[ 0 ] = zcomponent;
-               set_comp_attr( model.components[ 0 ], sim_vals.solutes[ cc ],
-                              attr_x );
-               set_comp_attr( model.components[ 0 ], sim_vals.solutes[ cc ],
-                              attr_y );
-            }
-
-            // Fill in the missing component values
-            model.update_coefficients();
-//DbgLv(1) << "CR:   cc" << cc << "model s,k,w,v,d,c"
-// << model.components[0].s << model.components[0].f_f0
-// << model.components[0].mw << model.components[0].vbar20
-// << model.components[0].D << model.components[0].signal_concentration;
-
-            // Convert to experimental space
-            model.components[ 0 ].s   /= dset->s20w_correction;
-            model.components[ 0 ].D   /= dset->D20w_correction;
-//DbgLv(1) << "CR:     exp.space model s,k,w,v,d,c"
-// << model.components[0].s << model.components[0].f_f0
-// << model.components[0].mw << model.components[0].vbar20
-// << model.components[0].D << model.components[0].signal_concentration;
-
-            // Initialize simulation data with the experiment's grid
-DbgLv(2) << "   CR:111  rss now" << US_Memory::rss_now() << "cc" << cc;
-            US_AstfemMath::initSimData( simdat, *edata, 0.0 );
-DbgLv(2) << "   CR:112  rss now" << US_Memory::rss_now() << "cc" << cc;
-if (dbg_level>1 && thrnrank<2 && cc==0) {
- model.debug(); dset->simparams.debug(); }
-
-            // Calculate Astfem_RSA solution (Lamm equations)
-            US_Astfem_RSA astfem_rsa( model, dset->simparams );
-DbgLv(2) << "   CR:113  rss now" << US_Memory::rss_now() << "cc" << cc;
-
-            astfem_rsa.set_debug_flag( dbg_level );
-
-            astfem_rsa.calculate( simdat );
-
-#if 0
-if (dbg_level>0 && thrnrank==1 && cc==0) {
- model.debug(); dset->simparams.debug(); }
-DbgLv(1) << "CR:  simdat nsc npt" << simdat.scanCount() << simdat.pointCount();
-int nsc=simdat.scanCount();
-int npt=simdat.pointCount();
-int ms=nsc/2;
-int ls=nsc-1;
-int mp=npt/2;
-int lp=npt-1;
-DbgLv(1) << "CR: edat:"
- << edata->value( 0, 0) << edata->value( 0,mp) << edata->value( 0,lp)
- << edata->value(ms, 0) << edata->value(ms,mp) << edata->value(ms,lp)
- << edata->value(ls, 0) << edata->value(ls,mp) << edata->value(ls,lp);
-DbgLv(1) << "CR: sdat:"
- << simdat.value( 0, 0) << simdat.value( 0,mp) << simdat.value( 0,lp)
- << simdat.value(ms, 0) << simdat.value(ms,mp) << simdat.value(ms,lp)
- << simdat.value(ls, 0) << simdat.value(ls,mp) << simdat.value(ls,lp);
-#endif
-DbgLv(2) << "   CR:114  rss now" << US_Memory::rss_now() << "cc" << cc;
-            if ( abort ) return;
-
-            if ( banddthr )
-            {  // If band forming, hold data within thresholds; skip if all-zero
-               if ( data_threshold( &simdat, zerothr, linethr, maxod, mfactor) )
-                  continue;
-
-               ksols++;
-            }
-
-            simulations << simdat;   // Save simulation (each dataset,solute)
-DbgLv(2) << "   CR:115  rss now" << US_Memory::rss_now() << "cc" << cc;
-
-            // Populate the A matrix for the NNLS routine with simulation
-int ks=ka;
-DbgLv(1) << "   CR: A fill kodl" << kodl << "bndthr ksol" << banddthr << ksols
- << "  ks" << ks;
-            if ( kodl == 0 )
-            {  // Normal case of no ODlimit substitutions
-               for ( int ss = 0; ss < nscans; ss++ )
-                  for ( int rr = 0; rr < npoints; rr++ )
-                     nnls_a[ ka++ ] = simdat.value( ss, rr );
-DbgLv(2) << "   CR:116  rss now" << US_Memory::rss_now() << "cc" << cc;
-//if(lim_offs>1&&(thrnrank==1||thrnrank==11))
-DbgLv(1) << "CR: ks ka" << ks << ka
- << "nnA s...k" << nnls_a[ks] << nnls_a[ks+1] << nnls_a[ka-2] << nnls_a[ka-1]
- << "cc ee" << cc << ee;
-            }
-            else
-            {  // Special case where ODlimit substitutions are in B matrix
-               for ( int ss = 0; ss < nscans; ss++ )
-               {
-                  for ( int rr = 0; rr < npoints; rr++ )
-                  {  // Fill A with simulations (or zero where B has zero)
-                     if ( nnls_b[ bx++ ] != 0.0 )
-                        nnls_a[ ka++ ] = simdat.value( ss, rr );
-                     else
-                        nnls_a[ ka++ ] = 0.0;
-                  }
-               }
-            }
-
-DbgLv(1) << "CR: NNLS A filled ee" << ee << lim_offs;
-DbgLv(1) << "CR: NNLS  &simdat" << &simdat;
-DbgLv(1) << "CR: NNLS  &model " << &model;
-DbgLv(1) << "CR: NNLS  &nnls_a" << &nnls_a;
-DbgLv(1) << "CR: NNLS  &simulations" << &simulations;
-DbgLv(1) << "CR: NNLS  astfem_rsa" << &astfem_rsa;
-         }  // Each data set
-DbgLv(1) << "CR: NNLS A filled lo" << lim_offs;
-
-         if ( tikreg )
-         {  // For Tikhonov Regularization append to each column
-            for ( int aa = 0; aa < nsolutes; aa++ )
-            {
-               nnls_a[ ka++ ] = ( aa == cc ) ? alphad : 0.0;
-            }
-         }
-
-         if ( signal_wanted  &&  ++kstep == increp )
-         {  // If asked for and step at increment, signal progress
-            emit work_progress( increp );
-            kstep = 0;                     // Reset step count
-         }
-DbgLv(1) << "CR: NNLS A filled cc" << cc << nsolutes;
-      }   // Each solute
-DbgLv(1) << "CR: NNLS A filled";
-   }   // Constant vbar
-
-   else if ( stype == 1  ||  stype > 9 )
+   else if ( s_type == 1  ||  s_type > 9 )
    {  // Special case of varying vbar with constant f/f0  (or other)
-      int attr_x     = 0;      // Default X is s
-      int attr_y     = 3;      // Default Y is vbar
-      int attr_z     = 1;      // Default fixed is f/f0
-      int smask      = ( attr_x << 6 ) | ( attr_y << 3 ) | attr_z;
+      attr_x         = ATTR_S;    // Default X is s
+      attr_y         = ATTR_V;    // Default Y is vbar
+      attr_z         = ATTR_K;    // Default fixed is f/f0
 
-      if ( stype > 9 )
+      if ( s_type > 9 )
       {  // Explicitly given attribute types
-          attr_x     = ( stype >> 6 ) & 7;
-          attr_y     = ( stype >> 3 ) & 7;
-          attr_z     =   stype        & 7;
-          smask      = stype;
+          attr_x     = ( s_type >> 6 ) & 7;
+          attr_y     = ( s_type >> 3 ) & 7;
+          attr_z     =   s_type        & 7;
       }
-DbgLv(1) << "CR: attr_ x,y,z" << attr_x << attr_y << attr_z << stype << smask
- << "use_zsol" << use_zsol;
 
       if ( ! use_zsol )
       {
          zcomponent.vbar20          = data_sets[ 0 ]->vbar20;
          set_comp_attr( zcomponent, sim_vals.solutes[ 0 ], attr_z );
       }
+   }
 
-      for ( int cc = 0; cc < nsolutes; cc++ )
-      {  // Solve for each solute
-         if ( abort ) return;
-         int bx   = 0;
-DbgLv(1) << "CR: cc" << cc << " use_zsol" << use_zsol;
-
-         for ( int ee = offset; ee < lim_offs; ee++ )
-         {  // Solve for each data set
-            US_Math2::SolutionData  sd;
-            DataSet*               dset  = data_sets[ ee ];
-            US_DataIO::EditedData* edata = banddthr ? &wdata : &dset->run_data;
-            US_DataIO::RawData     simdat;
-            int nscans     = edata->scanCount();
-            int npoints    = edata->pointCount();
-            model.components[ 0 ]  = zcomponent;
-
-            // Set model with standard space s,k,v  (or other 3 attributes)
-            if ( use_zsol )
-            {
-               US_ZSolute::set_mcomp_values( model.components[ 0 ],
-                                             sim_vals.zsolutes[ cc ], smask );
-//DbgLv(1) << "CR:   cc" << cc << "model s,k,w,v,d,c"
-// << model.components[0].s << model.components[0].f_f0
-// << model.components[0].mw << model.components[0].vbar20
-// << model.components[0].D << model.components[0].signal_concentration;
-            }
-            else
-            {
-               set_comp_attr( model.components[ 0 ], sim_vals.solutes[ cc ],
-                              attr_x );
-               set_comp_attr( model.components[ 0 ], sim_vals.solutes[ cc ],
-                              attr_y );
-               set_comp_attr( model.components[ 0 ], sim_vals.solutes[ cc ],
-                              attr_z );
-            }
+   else
+   {  // Special case of custom grid
+      attr_x         = ATTR_S;    // Set X is s
+      attr_y         = ATTR_D;    // Set Y is D
+      attr_z         = ATTR_V;    // Set Z is vbar
+   }
 
-            // Fill in the missing component values
-            model.update_coefficients();
-
-            // Convert to experimental space
-            double avtemp  = dset->temperature;
-            sd.viscosity   = dset->viscosity;
-            sd.density     = dset->density;
-            sd.manual      = dset->manual;
-            sd.vbar20      = model.components[ 0 ].vbar20;
-            sd.vbar        = US_Math2::adjust_vbar20( sd.vbar20, avtemp );
-            US_Math2::data_correction( avtemp, sd );
-
-            model.components[ 0 ].s   /= sd.s20w_correction;
-            model.components[ 0 ].D   /= sd.D20w_correction;
-//DbgLv(1) << "CR:     exp.space model s,k,w,v,d,c"
-// << model.components[0].s << model.components[0].f_f0
-// << model.components[0].mw << model.components[0].vbar20
-// << model.components[0].D << model.components[0].signal_concentration;
-
-            // Initialize simulation data with the experiment's grid
-            US_AstfemMath::initSimData( simdat, *edata, 0.0 );
-if (dbg_level>1 && thrnrank<2 && cc==0) {
- model.debug(); dset->simparams.debug(); }
-DbgLv(1) << "CR:  simdat nsc npt" << simdat.scanCount() << simdat.pointCount();
+   s_mask         = ( attr_x << 6 ) | ( attr_y << 3 ) | attr_z;
+DbgLv(1) << "CR: attr_ x,y,z" << attr_x << attr_y << attr_z << s_type << s_mask
+ << "use_zsol" << use_zsol;
 
-            // Calculate Astfem_RSA solution (Lamm equations)
-            US_Astfem_RSA astfem_rsa( model, dset->simparams );
+   // Compute the simulation for each solute and data set.
+   //  Each (solute,dataset) simulation goes to its own output slot, so
+   //  the results are the same whether computed serially or in threads.
+   int    nsims   = nsolutes * dataset_count;
+   int    nthr    = qMax( 1, qMin( sim_vals.nthreads, nsims ) );
+   long   rss_bef = US_Memory::rss_max( sim_vals.maxrss );
+   QVector< US_DataIO::RawData > simdats( nsims );
+   QVector< int >                simzero( nsims, 0 );
+   QVector< QByteArray >         simkeys( nsims );
+   QVector< double >             simfchk( ( sim_vals.sim_precision == 2 )
+                                          ? ( nsims * 2 ) : 0, -1.0 );
+   sim_vals_p     = &sim_vals;
+   bf_data        = banddthr ? &wdata : NULL;
+   sim_out        = simdats.data();
+   sim_zero       = simzero.data();
+   sim_skey       = simkeys.data();
+   sim_fchk       = ( simfchk.size() > 0 ) ? simfchk.data() : NULL;
+   sim_offs       = offset;
+   sim_ndsets     = dataset_count;
+   sim_nsols      = nsolutes;
+   sim_increp     = qMax( 10, nsolutes / 10 ); // Progress report increment
+   sim_kdone      = 0;                         // Progress reported so far
+   int    khits   = 0;                         // Simulation cache hits
+DbgLv(1) << "   CR: nsims nthr" << nsims << nthr;
+
+   if ( nthr > 1 )
+   {  // Simulate in the calling thread and nthr-1 additional threads
+      QList< SimThread* > sthreads;
+
+      for ( int tt = 1; tt < nthr; tt++ )
+      {
+         SimThread* sthr = new SimThread( this, tt, nthr );
+         sthreads << sthr;
+         sthr->start();
+      }
 
-            astfem_rsa.set_debug_flag( dbg_level );
+      khits          = simulate_solutes( 0, nthr );
 
-            astfem_rsa.calculate( simdat );
-#if 0
-int nsc=simdat.scanCount();
-int npt=simdat.pointCount();
-int ms=nsc/2;
-int ls=nsc-1;
-int mp=npt/2;
-int lp=npt-1;
-DbgLv(1) << "CR: edat:"
- << edata->value( 0, 0) << edata->value( 0,mp) << edata->value( 0,lp)
- << edata->value(ms, 0) << edata->value(ms,mp) << edata->value(ms,lp)
- << edata->value(ls, 0) << edata->value(ls,mp) << edata->value(ls,lp);
-DbgLv(1) << "CR: sdat:"
- << simdat.value( 0, 0) << simdat.value( 0,mp) << simdat.value( 0,lp)
- << simdat.value(ms, 0) << simdat.value(ms,mp) << simdat.value(ms,lp)
- << simdat.value(ls, 0) << simdat.value(ls,mp) << simdat.value(ls,lp);
-#endif
-            if ( abort ) return;
+      for ( int tt = 0; tt < sthreads.size(); tt++ )
+      {
+         sthreads[ tt ]->wait();
+         khits         += sthreads[ tt ]->nhits;
+         delete sthreads[ tt ];
+      }
+   }
 
-            if ( banddthr )
-            {  // If band forming, hold data within thresholds; skip if all-zero
-               if ( data_threshold( &simdat, zerothr, linethr, maxod, mfactor ) )
-                  continue;
+   else
+   {  // Simulate serially
+      khits          = simulate_solutes( 0, 1 );
+   }
+DbgLv(1) << "CR: simcache hits" << khits << "of" << nsims
+ << "budget" << US_SimCache::budget();
+if ( dbg_level > 0  &&  ! US_SimCache::store_directory().isEmpty() )
+{
+ int shits;
+ int smiss;
+ long int skb = US_SimCache::store_statistics( shits, smiss );
+ DbgLv(1) << "CR:  basis store hits,misses" << shits << smiss << "KB" << skb;
+}
 
-               ksols++;
-            }
+   if ( sim_fchk != NULL )
+   {  // Report how single precision simulations compare to double ones
+      int    nchk     = 0;
+      double rmsdmax  = 0.0;
+      double rmsdsum  = 0.0;
+      double diffmax  = 0.0;
 
-            simulations << simdat;   // Save simulation (each datset,solute)
+      for ( int jj = 0; jj < nsims; jj++ )
+      {
+         if ( simfchk[ jj * 2 ] < 0.0 )
+            continue;            // From cache:  not simulated here
 
-            // Populate the A matrix for the NNLS routine with simulation
-DbgLv(1) << "   CR: A-fill  bndthr" << banddthr << "kodl ksols" << kodl << ksols;
-int ks=ka;
-            if ( kodl == 0 )
-            {  // Normal case of no ODlimit substitutions
-               for ( int ss = 0; ss < nscans; ss++ )
-                  for ( int rr = 0; rr < npoints; rr++ )
-                     nnls_a[ ka++ ] = simdat.value( ss, rr );
-            }
-            else
-            {  // Special case where ODlimit substitutions are in B matrix
-               for ( int ss = 0; ss < nscans; ss++ )
-               {
-                  for ( int rr = 0; rr < npoints; rr++ )
-                  {  // Fill A with simulations (or zero where B has zero)
-                     if ( nnls_b[ bx++ ] != 0.0 )
-                        nnls_a[ ka++ ] = simdat.value( ss, rr );
-                     else
-                        nnls_a[ ka++ ] = 0.0;
-                  }
-               }
-            }
+         nchk++;
+         rmsdsum       += simfchk[ jj * 2 ];
+         rmsdmax        = qMax( rmsdmax, simfchk[ jj * 2 ] );
+         diffmax        = qMax( diffmax, simfchk[ jj * 2 + 1 ] );
+      }
 
-//DbgLv(1) << "CR: ks ka" << ks << ka
-// << "nnA s...k" << nnls_a[ks] << nnls_a[ks+1] << nnls_a[ka-2] << nnls_a[ka-1]
-// << "cc ee" << cc << ee << "kodl" << kodl;
-DbgLv(1) << "CR: cc ee" << cc << ee << "ks ka" << ks << ka << "nnls_a sz"
- << nnls_a.count() << "  sz-kd" << (nnls_a.count()-ka);
-         }  // Each data set
+DbgLv(1) << "CR: float check: sims" << nchk << "RMSD max,mean" << rmsdmax
+ << ( ( nchk > 0 ) ? ( rmsdsum / (double)nchk ) : 0.0 )
+ << "max|diff|" << diffmax;
+      sim_fchk       = NULL;
+   }
 
-         if ( tikreg )
-         {  // For Tikhonov Regularization append to each column
-DbgLv(1) << "CR: cc" << cc << " (PRE-tikreg)";
-            for ( int aa = 0; aa < nsolutes; aa++ )
-            {
-               nnls_a[ ka++ ] = ( aa == cc ) ? alphad : 0.0;
-            }
-         }
-DbgLv(1) << "CR:  cc" << cc << " ka" << ka << "nnls_a sz"
- << nnls_a.count() << "  sz-kd" << (nnls_a.count()-ka);
+   for ( int dx = 0; dx < dsgrids.size(); dx++ )
+   {
+      int    ngreuse;
+      int    ngbuilt  = dsgrids[ dx ]->statistics( ngreuse );
+DbgLv(1) << "CR:  dx" << dx << "grid entries built,reused" << ngbuilt << ngreuse;
+      delete dsgrids[ dx ];
+   }
 
-         if ( signal_wanted  &&  ++kstep == increp )
-         {  // If asked for and step at increment, signal progress
-            emit work_progress( increp );
-            kstep = 0;                     // Reset step count
-         }
-      }   // Each solute
-   }  // Constant f/f0  (or other stype>9)
+   dsgrids.clear();
 
-   else
-   {  // Special case of custom grid
-      int attr_x     = 0;      // Set X is s
-      int attr_y     = 4;      // Set Y is D
-      int attr_z     = 3;      // Set Z is vbar
-      int smask      = ( attr_x << 6 ) | ( attr_y << 3 ) | attr_z;
+   sim_vals.maxrss = US_Memory::rss_max( sim_vals.maxrss );
 
-      for ( int cc = 0; cc < nsolutes; cc++ )
-      {  // Solve for each solute
-         if ( abort ) return;
-         int bx   = 0;
+   if ( dbg_timing )
+   {  // Report peak memory and (calling thread) work arena usage
+      int    nablks;
+      long   arenakb;
+      long   naheap;
+      long   naborr;
+      US_AstfemMath::arena_stats( nablks, arenakb, naheap, naborr );
+
+      qDebug() << "w" << thrnrank << "TM: sims maxrss before,after"
+         << rss_bef << sim_vals.maxrss << "arena blocks,KB" << nablks
+         << arenakb << "heap-allocs,borrows" << naheap << naborr;
+   }
 
-         for ( int ee = offset; ee < lim_offs; ee++ )
-         {  // Solve for each data set
-            US_Math2::SolutionData  sd;
-            DataSet*               dset   = data_sets[ ee ];
-            US_DataIO::EditedData* edata  = banddthr ? &wdata : &dset->run_data;
-            US_DataIO::RawData     simdat;
-            int npoints    = edata->pointCount();
-            int nscans     = edata->scanCount();
-            double avtemp  = dset->temperature;
-            zcomponent.vbar20     = dset->vbar20;
-            model.components[ 0 ] = zcomponent;
-
-            if ( use_zsol )
-            {
-               US_ZSolute::set_mcomp_values( model.components[ 0 ],
-                                             sim_vals.zsolutes[ cc ], smask );
-            }
-            else
-            {
-               set_comp_attr( model.components[ 0 ], sim_vals.solutes[ cc ],
-                              attr_x );
-               set_comp_attr( model.components[ 0 ], sim_vals.solutes[ cc ],
-                              attr_y );
-               set_comp_attr( model.components[ 0 ], sim_vals.solutes[ cc ],
-                              attr_z );
-            }
+   // Free this thread's idle ASTFEM work blocks before A is filled
+   US_AstfemMath::arena_trim();
 
-            // Fill in the missing component values
-            model.update_coefficients();
+   if ( abort ) return;
 
-            // Convert to experimental space
-            sd.viscosity   = dset->viscosity;
-            sd.density     = dset->density;
-            sd.manual      = dset->manual;
-            sd.vbar20      = model.components[ 0 ].vbar20;
-            sd.vbar        = US_Math2::adjust_vbar20( sd.vbar20, avtemp );
+   int nwarm    = 0;
 
-            US_Math2::data_correction( avtemp, sd );
+   // Populate the A matrix for the NNLS routine with the simulations
+   for ( int cc = 0; cc < nsolutes; cc++ )
+   {  // Fill columns for each solute
+      int bx   = 0;
+
+      for ( int ee = offset; ee < lim_offs; ee++ )
+      {  // Fill column rows for each data set
+         int jj      = cc * dataset_count + ee - offset;
+         US_DataIO::EditedData* edata = banddthr ? &wdata
+                                                 : &data_sets[ ee ]->run_data;
+         US_DataIO::RawData*    simdat = &simdats[ jj ];
+         int npoints = edata->pointCount();
+         int nscans  = edata->scanCount();
+
+         if ( banddthr )
+         {  // If band forming, skip any all-zero simulation
+            if ( simzero[ jj ] != 0 )
+               continue;
 
-            model.components[ 0 ].s   /= sd.s20w_correction;
-            model.components[ 0 ].D   /= sd.D20w_correction;
+            ksols++;
+         }
 
-            // Initialize simulation data with the experiment's grid
-            US_AstfemMath::initSimData( simdat, *edata, 0.0 );
-if (dbg_level>1 && thrnrank<2 && cc==0) {
- model.debug(); dset->simparams.debug(); }
+         simulations << *simdat;   // Save simulation (each dataset,solute)
 
-            // Calculate Astfem_RSA solution (Lamm equations)
-            US_Astfem_RSA astfem_rsa( model, dset->simparams );
+         if ( ee == offset )
+         {  // Start the column's NNLS estimate from any previous concentration
+            nnls_x[ ka / narows ] = use_zsol ? sim_vals.zsolutes[ cc ].c
+                                             : sim_vals.solutes [ cc ].c;
+            nwarm      += ( nnls_x[ ka / narows ] > 0.0 ) ? 1 : 0;
+         }
 
-            astfem_rsa.set_debug_flag( dbg_level );
+int ks=ka;
+         if ( sparse_a )
+         {  // Keep only the nonzero values (and zero where B has zero)
+            int kr      = ka % narows;
 
-            astfem_rsa.calculate( simdat );
-            if ( abort ) return;
+            for ( int ss = 0; ss < nscans; ss++ )
+            {
+               const double* sv = simdat->scanData[ ss ].rvalues.constData();
 
-            if ( banddthr )
-            {  // If band forming, hold data within thresholds; skip if all-zero
-               if ( data_threshold(&simdat, zerothr, linethr, maxod, mfactor) )
-                  continue;
+               for ( int rr = 0; rr < npoints; rr++, kr++ )
+               {
+                  double aval = ( kodl == 0  ||  nnls_b[ bx++ ] != 0.0 )
+                                ? sv[ rr ] : 0.0;
 
-               ksols++;
+                  if ( aval != 0.0 )
+                  {
+                     csc_vals << aval;
+                     csc_rows << kr;
+                  }
+               }
             }
 
-            simulations << simdat;   // Save simulation (each datset,solute)
+            ka         += nscans * npoints;
+         }
 
-int ks=ka;
-            // Populate the A matrix for the NNLS routine with simulation
-            if ( kodl == 0 )
-            {  // Normal case of no ODlimit substitutions
-               for ( int ss = 0; ss < nscans; ss++ )
-                  for ( int rr = 0; rr < npoints; rr++ )
-                     nnls_a[ ka++ ] = simdat.value( ss, rr );
-            }
-            else
-            {  // Special case where ODlimit substitutions are in B matrix
-               for ( int ss = 0; ss < nscans; ss++ )
-               {
-                  for ( int rr = 0; rr < npoints; rr++ )
-                  {  // Fill A with simulations (or zero where B has zero)
-                     if ( nnls_b[ bx++ ] != 0.0 )
-                        nnls_a[ ka++ ] = simdat.value( ss, rr );
-                     else
-                        nnls_a[ ka++ ] = 0.0;
-                  }
+         else if ( kodl == 0 )
+         {  // Normal case of no ODlimit substitutions
+            for ( int ss = 0; ss < nscans; ss++ )
+               for ( int rr = 0; rr < npoints; rr++ )
+                  nnls_a[ ka++ ] = simdat->value( ss, rr );
+         }
+         else
+         {  // Special case where ODlimit substitutions are in B matrix
+            for ( int ss = 0; ss < nscans; ss++ )
+            {
+               for ( int rr = 0; rr < npoints; rr++ )
+               {  // Fill A with simulations (or zero where B has zero)
+                  if ( nnls_b[ bx++ ] != 0.0 )
+                     nnls_a[ ka++ ] = simdat->value( ss, rr );
+                  else
+                     nnls_a[ ka++ ] = 0.0;
                }
             }
-DbgLv(1) << "CR: ks ka" << ks << ka
+         }
+if ( ! sparse_a )
+{
+DbgLv(2) << "CR: ks ka" << ks << ka
  << "nnA s...k" << nnls_a[ks] << nnls_a[ks+1] << nnls_a[ka-2] << nnls_a[ka-1]
  << "cc ee" << cc << ee << "kodl" << kodl;
+}
+      }  // Each data set
 
-         }  // Each data set
+      if ( tikreg  &&  sparse_a )
+      {  // For Tikhonov Regularization append the diagonal value
+         csc_vals << alphad;
+         csc_rows << ( ntotal + cc );
+         ka          += nsolutes;
+      }
 
-         if ( tikreg )
-         {  // For Tikhonov Regularization append to each column
-            for ( int aa = 0; aa < nsolutes; aa++ )
-            {
-               nnls_a[ ka++ ] = ( aa == cc ) ? alphad : 0.0;
-            }
+      else if ( tikreg )
+      {  // For Tikhonov Regularization append to each column
+         for ( int aa = 0; aa < nsolutes; aa++ )
+         {
+            nnls_a[ ka++ ] = ( aa == cc ) ? alphad : 0.0;
          }
+      }
 
-         if ( signal_wanted  &&  ++kstep == increp )
-         {  // If asked for and step at increment, signal progress
-            emit work_progress( increp );
-            kstep = 0;                     // Reset step count
-         }
-      }   // Each solute
-   }   // Custom grid
+      // Close each sparse column completed
+      while ( sparse_a  &&  csc_cptr.size() <= ka / narows )
+         csc_cptr << csc_vals.size();
+   }   // Each solute
+DbgLv(1) << "CR: NNLS A filled  sparse" << sparse_a << "nonzero"
+ << ( sparse_a ? csc_vals.size() : navals ) << "of" << navals;
 
    nsolutes     = banddthr ? ksols : nsolutes;
    int ntotinoi = ntinois  * nsolutes;
    int ntorinoi = nrinois  * nsolutes;
    int nsolutsq = nsolutes * nsolutes;
 
-   if ( signal_wanted  &&  kstep > 0 )  // If signals and steps done, report
-      emit work_progress( kstep );
+   if ( signal_wanted  &&  sim_kdone < sim_nsols )
+      emit work_progress( sim_nsols - sim_kdone );  // Report remaining steps
 
    if ( abort ) return;
 
@@ -794,7 +701,10 @@ DebugTime("BEG:clcr-nn");
       if ( calc_ri )
          compute_L_tildes( nrinois, nsolutes, L_tildes, nnls_a );
 
-      // Compute L_bars
+      // Compute L_bars.  These per-radius means of each column must be
+      //  complete before any centered product is summed, since each
+      //  mean spans all scans while the products are formed a row block
+      //  at a time.  At solutes x radii they are 1/scans the size of A.
       compute_L_bars( nsolutes, nrinois, ntinois, ntotal,
                       L_bars, nnls_a, L_tildes );
 
@@ -890,11 +800,128 @@ DbgLv(2) << "   CR:210  rss now" << US_Memory::rss_now() << "thrn" << thrnrank;
 DbgLv(1) << "CR: sv_nnls_a size" << sv_nnls_a.size() << nnls_a.size();
       }
 
-      US_Math2::nnls( nnls_a.data(), narows, narows, nsolutes,
-                      nnls_b.data(), nnls_x.data() );
+      if ( sim_vals.nnls_mode == 1 )
+      {  // Solve by way of the normal equations, warm started from
+         //  the concentrations of solutes carried from a previous fit.
+         //  When the same simulations were solved before (as in Monte
+         //  Carlo iterations of a fixed solute set), A'A is reused and
+         //  only A'b is computed for the new data. (Lawson-Hanson has no
+         //  such reuse, nor a warm start:  it factors the columns of the
+         //  active set, which depends on b, and always starts from an
+         //  empty set.) The products of a sparse A are over its nonzero
+         //  values.
+         int nchange  = 0;
+         double btb   = 0.0;
+         QVector< double > ata;
+         QVector< double > atb( nsolutes );
+         QByteArray gkey = gram_key( nsims, nnls_b, kodl, tikreg ? alphad
+                                                                 : 0.0 );
+         bool reused  = ( ! gkey.isEmpty()  &&
+                          US_SimCache::fetch_gram( gkey, ata )  &&
+                          ata.size() == nsolutes * nsolutes );
+
+         if ( reused )
+         {  // Only A'b and b'b are needed
+            const double* bv = nnls_b.constData();
+
+            for ( int cc = 0; cc < nsolutes; cc++ )
+            {
+               double sum   = 0.0;
+
+               if ( sparse_a )
+               {
+                  for ( int kk = csc_cptr[ cc ]; kk < csc_cptr[ cc + 1 ]; kk++ )
+                     sum         += csc_vals[ kk ] * bv[ csc_rows[ kk ] ];
+               }
+
+               else
+               {
+                  const double* av = nnls_a.constData() + cc * narows;
+
+                  for ( int rr = 0; rr < narows; rr++ )
+                     sum         += av[ rr ] * bv[ rr ];
+               }
+
+               atb[ cc ]    = sum;
+            }
+
+            for ( int rr = 0; rr < narows; rr++ )
+               btb         += bv[ rr ] * bv[ rr ];
+         }
+
+         else
+         {  // Form A'A and A'b, saving A'A for a later solution
+            ata.resize( nsolutes * nsolutes );
+
+            if ( sparse_a )
+               US_Math2::nnls_gram_csc( csc_vals.constData(),
+                                        csc_rows.constData(),
+                                        csc_cptr.constData(), narows, nsolutes,
+                                        nnls_b.data(), ata.data(), atb.data(),
+                                        &btb, sim_vals.nthreads );
+            else
+               US_Math2::nnls_gram( nnls_a.data(), narows, narows, nsolutes,
+                                    nnls_b.data(), ata.data(), atb.data(),
+                                    &btb, sim_vals.nthreads );
+
+            if ( ! gkey.isEmpty() )
+               US_SimCache::store_gram( gkey, ata );
+         }
+
+         US_Math2::nnls_normal( ata.constData(), atb.constData(), nsolutes,
+                                nnls_x.data(), btb, NULL, ( nwarm > 0 ),
+                                &nchange );
+
+         if ( dbg_timing )
+         {
+            int ghits;
+            int gmiss;
+            US_SimCache::gram_statistics( ghits, gmiss );
+
+            qDebug() << "w" << thrnrank << "TM: NNLS solutes" << nsolutes
+               << "warm-start" << nwarm << "active-set changes" << nchange
+               << "A'A reused" << reused << "hits,misses" << ghits << gmiss;
+         }
+      }
+
+      else if ( sim_vals.nnls_mode == 2 )
+      {  // Solve both ways (normal equations first, since A is unchanged)
+         //  and report how the solutions compare
+         QVector< double > ne_x( nsolutes );
+         double ne_rnorm = 0.0;
+         double lh_rnorm = 0.0;
+         double dxmax    = 0.0;
+         double xmax     = 0.0;
+         int    nxdiff   = 0;
+
+         US_Math2::nnls_ne( nnls_a.data(), narows, narows, nsolutes,
+                            nnls_b.data(), ne_x.data(), &ne_rnorm,
+                            sim_vals.nthreads );
+         US_Math2::nnls( nnls_a.data(), narows, narows, nsolutes,
+                         nnls_b.data(), nnls_x.data(), &lh_rnorm );
+
+         for ( int cc = 0; cc < nsolutes; cc++ )
+         {
+            dxmax    = qMax( dxmax, qAbs( nnls_x[ cc ] - ne_x[ cc ] ) );
+            xmax     = qMax( xmax,  qAbs( nnls_x[ cc ] ) );
+
+            if ( ( nnls_x[ cc ] > 0.0 ) != ( ne_x[ cc ] > 0.0 ) )
+               nxdiff++;
+         }
+
+DbgLv(1) << "CR: NNLS check: narows nsolutes" << narows << nsolutes
+ << "max|dx| max|x|" << dxmax << xmax << "set-diffs" << nxdiff
+ << "rnorm LH NE" << lh_rnorm << ne_rnorm;
+      }
+
+      else
+      {  // Solve by Lawson-Hanson on A
+         US_Math2::nnls( nnls_a.data(), narows, narows, nsolutes,
+                         nnls_b.data(), nnls_x.data() );
+      }
 DbgLv(2) << "   CR:211  rss now" << US_Memory::rss_now() << "thrn" << thrnrank;
 if(lim_offs>1&&(thrnrank==1||thrnrank==11)) DbgLv(1) << "CR: narows nsolutes" << narows << nsolutes;
-if(lim_offs>1&&(thrnrank==1||thrnrank==11)) DbgLv(1) << "CR:  a0 a1 b0 b1"
+if(lim_offs>1&&(thrnrank==1||thrnrank==11)&&!sparse_a) DbgLv(1) << "CR:  a0 a1 b0 b1"
  << nnls_a[0] << nnls_a[1] << nnls_b[0] << nnls_b[1];
 
       if ( abort ) return;
@@ -912,6 +939,8 @@ DbgLv(1) << "   CR:na  rss now,max" << US_Memory::rss_now() << sim_vals.maxrss
 
    nnls_a.clear();
    nnls_b.clear();
+   csc_vals.clear();
+   csc_rows.clear();
 DebugTime("END:clcr-nn");
 
 DbgLv(1) << "CR: kstodo" << kstodo;
@@ -1352,105 +1381,215 @@ void US_SolveSim::compute_L( int                      ntotal,
    }
 }
 
-void US_SolveSim::ri_small_a_and_b( int                      nsolutes,
-                                    int                      ntotal,
-                                    int                      nrinois,
-                                    QVector< double >&       small_a,
-                                    QVector< double >&       small_b,
-                                    const QVector< double >& a_tilde,
-                                    const QVector< double >& L_tildes,
-                                    const QVector< double >& nnls_a, 
-                                    const QVector< double >& nnls_b )
+// Accumulate the columns of the noise-centered small_a (A'A) and small_b
+//  (A'b) assigned to one thread. Each column of A is centered by its
+//  per-radius (rcen) and/or per-scan (scen) averages, and b by brcen and/or
+//  bscen. Centered values are formed a row block at a time into a buffer
+//  that stays in cache, so the full centered A is never materialized.
+static void noise_gram_cols( const double* a, int m, int n, int npoints,
+                             const double* rcen, int rstride,
+                             const double* scen, int sstride,
+                             const double* b, const double* brcen,
+                             const double* bscen, double* sma, double* smb,
+                             int thrx, int nthr, const bool* abort )
 {
-DebugTime("BEG:ri_smab");
-   US_DataIO::EditedData* edata = &data_sets[ d_offs ]->run_data;
-   int npoints = edata->pointCount();
-   int nscans  = edata->scanCount();
-   int kstodo  = sq( nsolutes ) / 10;   // progress steps to report
-   int incprg  = nsolutes / 20;         // increment between reports
-   incprg      = max( incprg,  1 );
-   incprg      = min( incprg, 10 );
-   int jstprg  = ( kstodo * incprg ) / nsolutes;  // steps for each report
-   int kstep   = 0;                               // progress counter
+   // Rows in a block:  keep a block of all centered columns within ~1 MB
+   const int rblk = qMax( 64, 131072 / qMax( 1, n ) );
+   int    cmax    = thrx + ( ( n - 1 - thrx ) / nthr ) * nthr;
+   QVector< double > packv( ( cmax + 1 ) * rblk );
+   QVector< double > bpackv( rblk );
+   double* pack   = packv .data();
+   double* bpack  = bpackv.data();
+
+   for ( int jj = thrx; jj < n; jj += nthr )
+   {
+      double* smac   = sma + jj * n;
 
-   for ( int cc = 0; cc < nsolutes; cc++ )
+      for ( int ii = 0; ii <= jj; ii++ )
+         smac[ ii ]     = 0.0;
+
+      smb[ jj ]      = 0.0;
+   }
+
+   for ( int r0 = 0; r0 < m; r0 += rblk )
    {
-      int    jsa2  = cc * ntotal;
-      int    jst2  = cc * nrinois;
-      int    jjna  = jsa2;
-      int    jjnb  = 0;
-      int    jjlt  = jst2;
-      double sum_b = small_b[ cc ];
+      int r1         = qMin( m, r0 + rblk );
+      int nr         = r1 - r0;
 
-      for ( int ss = 0; ss < nscans; ss++ )
+      // Center the block of columns needed by this thread (and of b)
+      for ( int cc = 0; cc <= cmax + 1; cc++ )
       {
-         // small_b[ cc ] +=
-         //    ( edata->value( ss, rr ) - a_tilde[ ss ] )
-         //    *
-         //    ( nnls_a[ cc * ntotal + ss * npoints + rr ] 
-         //      -
-         //      L_tildes[ cc * nrinois + ss ] );
-         double atil  = a_tilde [ ss ];
-         double Ltil  = L_tildes[ jjlt++ ];
-
-         for ( int rr = 0; rr < npoints; rr++ )
+         const double* ac = ( cc <= cmax ) ? ( a + cc * m + r0 ) : ( b + r0 );
+         const double* rc = ( cc <= cmax ) ? rcen : brcen;
+         const double* sc = ( cc <= cmax ) ? scen : bscen;
+         double*       pc = ( cc <= cmax ) ? ( pack + cc * rblk ) : bpack;
+         int    ss      = r0 / npoints;
+         int    rx      = r0 % npoints;
+
+         if ( cc <= cmax )
          {
-            sum_b += ( ( nnls_b[ jjnb++ ] - atil )
-                     * ( nnls_a[ jjna++ ] - Ltil ) );
+            rc             = ( rc != NULL ) ? ( rc + cc * rstride ) : NULL;
+            sc             = ( sc != NULL ) ? ( sc + cc * sstride ) : NULL;
          }
 
-      }
+         for ( int kk = 0; kk < nr; kk++ )
+         {
+            double val     = ac[ kk ];
 
-      small_b[ cc ] = sum_b;
+            if ( rc != NULL )
+               val           -= rc[ rx ];
 
-      for ( int kk = 0; kk < nsolutes; kk++ )
-      {
-         //small_a[ kk * nsolutes + cc ] +=
-         //   ( nnls_a[ kk * ntotal + ss * npoints + rr ]
-         //     - 
-         //     L_tildes[ kk * nrinois + ss  ]
-         //   ) 
-         //   *
-         //   ( nnls_a[ cc * ntotal + ss * npoints + rr ]
-         //     -  
-         //     L_tildes[ cc * nrinois + ss ] );
-         int    jjma  = kk * nsolutes + cc;
-         int    jja1  = kk * ntotal;
-         int    jja2  = jsa2;
-         int    jjt1  = kk * nrinois;
-         int    jjt2  = jst2;
-         double sum_a = small_a[ jjma ];
+            if ( sc != NULL )
+               val           -= sc[ ss ];
 
-         for ( int ss = 0; ss < nscans; ss++ )
-         {
-            double Ltil1 = L_tildes[ jjt1++ ];
-            double Ltil2 = L_tildes[ jjt2++ ];
+            pc[ kk ]       = val;
 
-            for ( int rr = 0; rr < npoints; rr++ )
+            if ( ++rx == npoints )
             {
-               sum_a += ( ( nnls_a[ jja1++ ] - Ltil1 )
-                        * ( nnls_a[ jja2++ ] - Ltil2 ) );
+               rx             = 0;
+               ss++;
             }
          }
+      }
+
+      for ( int jj = thrx; jj < n; jj += nthr )
+      {
+         const double* pj = pack + jj * rblk;
+         double* smac   = sma + jj * n;
 
-         small_a[ jjma ] = sum_a;
+         for ( int ii = 0; ii <= jj; ii++ )
+         {
+            const double* pi = pack + ii * rblk;
+            double sum     = 0.0;
+
+            for ( int kk = 0; kk < nr; kk++ )
+               sum           += pi[ kk ] * pj[ kk ];
+
+            smac[ ii ]    += sum;
+         }
+
+         double sum     = 0.0;
+
+         for ( int kk = 0; kk < nr; kk++ )
+            sum           += pj[ kk ] * bpack[ kk ];
+
+         smb[ jj ]     += sum;
       }
 
-      if ( signal_wanted  &&  ++kstep == incprg )
+      if ( *abort ) return;
+   }
+}
+
+// Thread computing an interleaved subset of the columns of small_a
+class noise_gram_thr_t : public QThread
+{
+   public:
+      noise_gram_thr_t( const double* a, int m, int n, int npoints,
+                        const double* rcen, int rstride,
+                        const double* scen, int sstride,
+                        const double* b, const double* brcen,
+                        const double* bscen, double* sma, double* smb,
+                        int thrx, int nthr, const bool* abort )
+         : a( a ), m( m ), n( n ), npoints( npoints ), rcen( rcen ),
+           rstride( rstride ), scen( scen ), sstride( sstride ), b( b ),
+           brcen( brcen ), bscen( bscen ), sma( sma ), smb( smb ),
+           thrx( thrx ), nthr( nthr ), abort( abort ) {}
+
+      void run()
       {
-         emit work_progress( jstprg );
-         kstodo   -= jstprg;
-         kstep     = 0;
+         noise_gram_cols( a, m, n, npoints, rcen, rstride, scen, sstride,
+                          b, brcen, bscen, sma, smb, thrx, nthr, abort );
       }
 
-      if ( abort ) return;
+   private:
+      const double* a;
+      int           m;
+      int           n;
+      int           npoints;
+      const double* rcen;
+      int           rstride;
+      const double* scen;
+      int           sstride;
+      const double* b;
+      const double* brcen;
+      const double* bscen;
+      double*       sma;
+      double*       smb;
+      int           thrx;
+      int           nthr;
+      const bool*   abort;
+};
+
+// Compute small_a and small_b of noise-centered A and b, in threads.
+//  Each thread owns whole columns, so sums do not depend on the
+//  thread count.
+void US_SolveSim::noise_small_a_and_b( int nsolutes, int ntotal,
+      const double* rcen, int rstride, const double* scen, int sstride,
+      const double* brcen, const double* bscen,
+      QVector< double >& small_a, QVector< double >& small_b,
+      const QVector< double >& nnls_a, const QVector< double >& nnls_b )
+{
+   US_DataIO::EditedData* edata = &data_sets[ d_offs ]->run_data;
+   int    npoints = edata->pointCount();
+   int    nthr    = ( sim_vals_p != NULL ) ? sim_vals_p->nthreads : 1;
+   nthr           = qMax( 1, qMin( nthr, nsolutes ) );
+   double* sma    = small_a.data();
+   double* smb    = small_b.data();
+   QList< noise_gram_thr_t* > threads;
+
+   for ( int tt = 1; tt < nthr; tt++ )
+   {
+      noise_gram_thr_t* thr = new noise_gram_thr_t( nnls_a.constData(),
+            ntotal, nsolutes, npoints, rcen, rstride, scen, sstride,
+            nnls_b.constData(), brcen, bscen, sma, smb, tt, nthr, &abort );
+      threads << thr;
+      thr->start();
+   }
+
+   noise_gram_cols( nnls_a.constData(), ntotal, nsolutes, npoints,
+                    rcen, rstride, scen, sstride, nnls_b.constData(),
+                    brcen, bscen, sma, smb, 0, nthr, &abort );
+
+   for ( int tt = 0; tt < threads.size(); tt++ )
+   {
+      threads[ tt ]->wait();
+      delete threads[ tt ];
    }
 
-   if ( signal_wanted  &&  kstodo > 0 )
-      emit work_progress( kstodo );
+   // Mirror the upper triangle into the lower
+   for ( int jj = 0; jj < nsolutes; jj++ )
+      for ( int ii = 0; ii < jj; ii++ )
+         sma[ jj + ii * nsolutes ] = sma[ ii + jj * nsolutes ];
+
+   if ( signal_wanted )
+      emit work_progress( sq( nsolutes ) / 10 );  // Report steps done
+DbgLv(1) << "noise_smab: nthr" << nthr << "nso nto" << nsolutes << ntotal
+ << "a0 an b0 bn" << small_a[ 0 ] << small_a[ nsolutes * nsolutes - 1 ]
+ << small_b[ 0 ] << small_b[ nsolutes - 1 ];
+}
+
+// Set up small_a, small_b for RI noise:  A centered by L_tildes at each
+//  scan, b by a_tilde
+void US_SolveSim::ri_small_a_and_b( int                      nsolutes,
+                                    int                      ntotal,
+                                    int                      nrinois,
+                                    QVector< double >&       small_a,
+                                    QVector< double >&       small_b,
+                                    const QVector< double >& a_tilde,
+                                    const QVector< double >& L_tildes,
+                                    const QVector< double >& nnls_a, 
+                                    const QVector< double >& nnls_b )
+{
+DebugTime("BEG:ri_smab");
+   noise_small_a_and_b( nsolutes, ntotal, NULL, 0,
+                        L_tildes.constData(), nrinois, NULL,
+                        a_tilde.constData(), small_a, small_b,
+                        nnls_a, nnls_b );
 DebugTime("END:ri_smab");
 }
 
+// Set up small_a, small_b for TI noise:  A centered by L_bars at each
+//  radius, b by a_bar
 void US_SolveSim::ti_small_a_and_b( int                      nsolutes,
                                     int                      ntotal,
                                     int                      ntinois,
@@ -1462,98 +1601,9 @@ void US_SolveSim::ti_small_a_and_b( int                      nsolutes,
                                     const QVector< double >& nnls_b )
 {
 DebugTime("BEG:ti-smab");
-   US_DataIO::EditedData* edata = &data_sets[ d_offs ]->run_data;
-   int npoints = edata->pointCount();
-   int nscans  = edata->scanCount();
-   int kstodo  = sq( nsolutes ) / 10;   // progress steps to report
-   int incprg  = nsolutes / 20;         // increment between reports
-   incprg      = max( incprg,  1 );
-   incprg      = min( incprg, 10 );
-   int jstprg  = ( kstodo * incprg ) / nsolutes;  // steps for each report
-   int kstep   = 0;                               // progress counter
-DbgLv(1) << "ti_smab: np ns nn nso" << npoints << nscans << ntinois << nsolutes
- << "szb sza" << nnls_b.size() << nnls_a.size() << "nto" << ntotal;
-int svsa=0;
-small_a.fill( 0.0 );
-small_b.fill( 0.0 );
-
-   for ( int cc = 0; cc < nsolutes; cc++ )
-   {
-      int jjsa  = cc;
-      int jssa  = cc * ntotal;
-      int jssb  = cc * ntinois;
-      int jjna  = jssa;
-      int jjnb  = 0;
-
-      //small_b[ cc ] += 
-      //   ( edata->value( ss, rr ) - a_bar[ rr ] )
-      //     *
-      //   ( nnls_a[ cc * ntotal + ss * npoints + rr ]
-      //     -
-      //     L_bars[ cc * ntinois + rr ] );
-      double sum_b = small_b[ cc ];
-
-      for ( int ss = 0; ss < nscans; ss++ )
-      {
-         int jjlb  = jssb;
-
-         for ( int rr = 0; rr < npoints; rr++ )
-         {
-            sum_b  += ( ( nnls_b[ jjnb++ ] - a_bar [ rr ]     )
-                      * ( nnls_a[ jjna++ ] - L_bars[ jjlb++ ] ) );
-         }
-      }
-
-      small_b[ cc ] = sum_b;
-
-      //small_a[ kk * nsolutes + cc ] +=
-      //   ( nnls_a[ kk * ntotal  + ss * npoints + rr ]
-      //     -
-      //     L_bars[ kk * ntinois + rr ] )
-      //   *
-      //   ( nnls_a[ cc * ntotal  + ss * npoints + rr ]
-      //     -
-      //     L_bars[ cc * ntinois + rr ] );
-      for ( int kk = 0; kk < nsolutes; kk++ )
-      {
-         int    jjna1 = kk * ntotal;
-         int    jjna2 = jssa;
-         int    jslb1 = kk * ntinois;
-         int    jslb2 = jssb;
-         double sum_a = small_a[ jjsa ];
-
-         for ( int ss = 0; ss < nscans; ss++ )
-         {
-            int jjlb1 = jslb1;
-            int jjlb2 = jslb2;
-
-            for ( int rr = 0; rr < npoints; rr++ )
-            {
-               sum_a += ( ( nnls_a[ jjna1++ ] - L_bars[ jjlb1++ ] )
-                        * ( nnls_a[ jjna2++ ] - L_bars[ jjlb2++ ] ) );
-            }
-         }
-
-         small_a[ jjsa ] = sum_a;
-svsa=jjsa;
-         jjsa     += nsolutes;  
-      }
-
-      if ( signal_wanted  &&  ++kstep == incprg )
-      {
-         emit work_progress( jstprg );
-         kstodo   -= jstprg;
-         kstep     = 0;
-      }
-
-      if ( abort ) return;
-   }
-DbgLv(1) << "ti_smab:   nsb nsa" << small_b.size() << small_a.size()
- << "jsb jsa" << nsolutes << svsa << "a0 an b0 bn"
- << small_a[0] << small_a[svsa] << small_b[0] << small_b[nsolutes-1];
-
-   if ( signal_wanted  &&  kstodo > 0 )
-      emit work_progress( kstodo );
+   noise_small_a_and_b( nsolutes, ntotal, L_bars.constData(), ntinois,
+                        NULL, 0, a_bar.constData(), NULL, small_a, small_b,
+                        nnls_a, nnls_b );
 DebugTime("END:ti-smab");
 }
 
@@ -1601,7 +1651,8 @@ void US_SolveSim::compute_a_bar( QVector< double >&       a_bar,
    }
 }
 
-// Calculate the average simulated concentration at each radius point
+// Calculate the average simulated concentration at each radius point.
+//  Each column of A is read once, in storage order.
 void US_SolveSim::compute_L_bars( int                      nsolutes,
                                   int                      nrinois,
                                   int                      ntinois,
@@ -1617,25 +1668,22 @@ void US_SolveSim::compute_L_bars( int                      nsolutes,
 
    for ( int cc = 0; cc < nsolutes; cc++ )
    {
-      int solute_offset = cc * ntotal;
+      const double* acol = nnls_a.constData()   + cc * ntotal;
+      const double* ltil = L_tildes.constData() + cc * nrinois;
+      double*       lbar = L_bars.data()        + cc * ntinois;
 
-      for ( int rr = 0; rr < npoints; rr++ )
+      for ( int ss = 0; ss < nscans; ss++ )
       {
-         int r_index = cc * ntinois + rr;
-
-         for ( int ss = 0; ss < nscans; ss++ )
-         {
-            // Note: L_tildes is always zero when rinoise has not been 
-            // requested
-               
-            int n_index = solute_offset + ss * npoints + rr;
-            int s_index = cc * nrinois + ss;
-
-            L_bars[ r_index ] += ( nnls_a[ n_index ] - L_tildes[ s_index ] );
-         }
+         // Note: L_tildes is always zero when rinoise has not been 
+         // requested
+         double Ltil = ltil[ ss ];
 
-         L_bars[ r_index ] *= avgscale;
+         for ( int rr = 0; rr < npoints; rr++ )
+            lbar[ rr ] += ( *(acol++) - Ltil );
       }
+
+      for ( int rr = 0; rr < npoints; rr++ )
+         lbar[ rr ] *= avgscale;
    }
 }
 
@@ -1757,6 +1805,271 @@ bool US_SolveSim::data_threshold( US_DataIO::EditedData* edata,
    return ( nnzro == 0 );
 }
 
+// Simulate a share of the (solute,dataset) pairs of calc_residuals().
+//  Thread "thrx" of "nthr" handles every nthr'th pair and stores each
+//  simulation in the pair's own output slot. Returns the cache hit count.
+int US_SolveSim::simulate_solutes( int thrx, int nthr )
+{
+   QList< DataSet* >      dsets;
+   QList< DataSet >       dscopy;
+   US_DataIO::EditedData  wdcopy;
+   US_DataIO::EditedData* wdat     = bf_data;
+   const QVector< US_Solute >&  solutes  = sim_vals_p->solutes;
+   const QVector< US_ZSolute >& zsolutes = sim_vals_p->zsolutes;
+   int    nsims    = sim_nsols * sim_ndsets;
+   int    kitems   = 0;
+   int    khits    = 0;
+
+   for ( int dx = 0; dx < sim_ndsets; dx++ )
+   {
+      if ( nthr > 1 )
+      {  // Threads each work with their own (implicitly shared) copies
+         dscopy << *data_sets[ sim_offs + dx ];
+         dsets  << &dscopy[ dx ];
+      }
+      else
+         dsets  << data_sets[ sim_offs + dx ];
+   }
+
+   if ( nthr > 1  &&  bf_data != NULL )
+   {
+      wdcopy         = *bf_data;
+      wdat           = &wdcopy;
+   }
+
+   US_Model model;
+   model.components.resize( 1 );
+
+   for ( int jj = thrx; jj < nsims; jj += nthr )
+   {  // Simulate each solute,dataset pair assigned to this thread
+      if ( abort ) return khits;
+      int    cc      = jj / sim_ndsets;
+      int    dx      = jj - cc * sim_ndsets;
+      DataSet*               dset  = dsets[ dx ];
+      US_DataIO::EditedData* edata = banddthr ? wdat : &dset->run_data;
+      US_DataIO::RawData     simdat;
+      US_Solute              solute;
+      US_ZSolute             zsolute;
+
+      if ( use_zsols )
+         zsolute        = zsolutes.at( cc );
+      else
+         solute         = solutes .at( cc );
+
+      // Set model with the experiment space solute attributes
+      solute_component( model.components[ 0 ], dset, solute, zsolute );
+if (dbg_level>1 && thrnrank<2 && cc==0) {
+ model.debug(); dset->simparams.debug(); }
+
+      if ( ! dskeys.at( dx ).isEmpty() )
+         sim_skey[ jj ] = US_SimCache::solute_key( dskeys.at( dx ),
+                                                   model.components[ 0 ] );
+
+      // Calculate Astfem_RSA solution (Lamm equations) on data grid
+      if ( model_simulation( model, dset, edata, simdat, sim_skey[ jj ],
+                             sgkeys.at( dx ), dsgrids.at( dx ),
+                             ( sim_fchk != NULL ) ? ( sim_fchk + jj * 2 )
+                                                  : NULL ) )
+         khits++;
+
+      if ( abort ) return khits;
+
+      if ( banddthr )
+      {  // If band forming, hold data within thresholds; flag if all-zero
+         sim_zero[ jj ] = data_threshold( &simdat, zerothr, linethr,
+                                          maxod, mfactor ) ? 1 : 0;
+      }
+
+      sim_out[ jj ]  = simdat;
+
+      if ( signal_wanted  &&  thrx == 0 )
+      {  // Signal progress in solutes (this thread's share times threads)
+         kitems        += nthr;
+         int ksdone     = qMin( ( kitems / sim_ndsets ), sim_nsols );
+
+         if ( ( ksdone - sim_kdone ) >= sim_increp )
+         {
+            emit work_progress( ksdone - sim_kdone );
+            sim_kdone      = ksdone;
+         }
+      }
+   }
+
+   return khits;
+}
+
+// Set the experiment-space model component for a solute and data set
+void US_SolveSim::solute_component( US_Model::SimulationComponent& comp,
+      DataSet* dset, US_Solute& solute, US_ZSolute& zsolute )
+{
+   bool vary_v    = ( s_type == 1  ||  s_type > 9 );
+   comp           = zcomponent;
+
+   if ( ! vary_v )
+      comp.vbar20    = dset->vbar20;
+
+   // Set component with standard space attributes
+   if ( use_zsols )
+   {
+      US_ZSolute::set_mcomp_values( comp, zsolute, s_mask );
+   }
+   else
+   {
+      set_comp_attr( comp, solute, attr_x );
+      set_comp_attr( comp, solute, attr_y );
+
+      if ( s_type != 0 )
+         set_comp_attr( comp, solute, attr_z );
+   }
+
+   // Fill in the missing component values
+   US_Model::calc_coefficients( comp );
+
+   // Convert to experimental space
+   if ( s_type == 0 )
+   {  // Constant vbar:  use data set corrections
+      comp.s        /= dset->s20w_correction;
+      comp.D        /= dset->D20w_correction;
+   }
+   else
+   {  // Varying vbar:  compute corrections for the component's vbar
+      US_Math2::SolutionData  sd;
+      double avtemp  = dset->temperature;
+      sd.viscosity   = dset->viscosity;
+      sd.density     = dset->density;
+      sd.manual      = dset->manual;
+      sd.vbar20      = comp.vbar20;
+      sd.vbar        = US_Math2::adjust_vbar20( sd.vbar20, avtemp );
+      US_Math2::data_correction( avtemp, sd );
+
+      comp.s        /= sd.s20w_correction;
+      comp.D        /= sd.D20w_correction;
+   }
+}
+
+// Simulate a single-component model on a data set's grid.
+//  If the cache is enabled (non-empty solute key), a previous simulation
+//  of the same experiment-space component is reused when available.
+//  If the basis store is enabled (non-empty simulation grid key), the
+//  raw simulation grid is kept there and interpolated onto the data grid,
+//  so that data sets with the same simulation parameters share it.
+//  If fchk is given, a float simulation is also compared to a double one
+//  and the RMSD and maximum difference are returned in fchk[0],fchk[1].
+//  Returns true if the simulation came from the cache or store.
+bool US_SolveSim::model_simulation( US_Model& model, DataSet* dset,
+      US_DataIO::EditedData* edata, US_DataIO::RawData& simdat,
+      const QByteArray& skey, const QByteArray& sgkey,
+      US_AstfemGrid* grid, double* fchk )
+{
+   // Initialize simulation data with the experiment's grid
+   US_AstfemMath::initSimData( simdat, *edata, 0.0 );
+
+   QByteArray gkey;
+
+   // Look for the simulation in the cache
+   if ( ! skey.isEmpty()  &&  US_SimCache::fetch( skey, simdat ) )
+      return true;
+
+   // Calculate Astfem_RSA solution (Lamm equations)
+   US_Astfem_RSA astfem_rsa( model, dset->simparams );
+   US_DataIO::RawData sgrid;
+
+   astfem_rsa.set_debug_flag( dbg_level );
+   astfem_rsa.set_grid( grid );
+   astfem_rsa.set_float_flag( sim_vals_p->sim_precision > 0 );
+   astfem_rsa.set_stream_flag( true );
+
+   if ( ! sgkey.isEmpty()  &&  fchk == NULL )
+   {  // Look for the simulation grid in the basis store
+      gkey           = US_SimCache::solute_key( sgkey, model.components[ 0 ] );
+
+      if ( US_SimCache::fetch_simout( gkey, sgrid )  &&
+           astfem_rsa.interpolate_simout( sgrid, simdat ) == 0 )
+      {
+         if ( ! skey.isEmpty() )
+            US_SimCache::store( skey, simdat );
+
+         return true;
+      }
+   }
+
+   if ( fchk != NULL )
+   {  // Simulate in both precisions, keeping the float result
+      fchk[ 0 ]      = US_Astfem_RSA::compare_precision( model,
+                          dset->simparams, simdat, fchk[ 1 ] );
+   }
+   else if ( ! gkey.isEmpty() )
+   {  // Simulate on the raw grid, store it and interpolate it
+      sgrid          = simdat;
+      astfem_rsa.set_simout_flag( true );
+
+      if ( astfem_rsa.calculate( sgrid ) != 0  ||  abort  ||
+           astfem_rsa.interpolate_simout( sgrid, simdat ) != 0 )
+         return false;
+
+      US_SimCache::store_simout( gkey, sgrid );
+   }
+   else if ( astfem_rsa.calculate( simdat ) < 0 )
+      return false;        // Simulation does not cover the data:  not cached
+
+   if ( ! skey.isEmpty()  &&  ! abort )
+      US_SimCache::store( skey, simdat );
+
+   return false;
+}
+
+// Compose the key of A'A for the current simulations:  a digest of the
+//  simulation keys of all columns, the regularization factor and any rows
+//  zeroed for ODlimit.  The key is empty if the simulations are not keyed.
+QByteArray US_SolveSim::gram_key( int nsims, const QVector< double >& bvec,
+                                  int kodl, double alphad )
+{
+   QByteArray gkey;
+
+   if ( banddthr )
+      return gkey;
+
+   QCryptographicHash hash( QCryptographicHash::Md5 );
+
+   for ( int jj = 0; jj < nsims; jj++ )
+   {
+      if ( sim_skey[ jj ].isEmpty() )
+         return gkey;
+
+      hash.addData( sim_skey[ jj ] );
+   }
+
+   hash.addData( (const char*)&alphad, sizeof( double ) );
+
+   if ( kodl > 0 )
+   {  // A has zeroes in rows where B was zeroed
+      QByteArray zmask( ( bvec.size() + 7 ) / 8, '\0' );
+
+      for ( int rr = 0; rr < bvec.size(); rr++ )
+         if ( bvec[ rr ] == 0.0 )
+            zmask[ rr / 8 ] = zmask[ rr / 8 ] | (char)( 1 << ( rr & 7 ) );
+
+      hash.addData( zmask );
+   }
+
+   gkey           = hash.result();
+
+   return gkey;
+}
+
+// Simulation thread constructor
+US_SolveSim::SimThread::SimThread( US_SolveSim* solvesim, int thrx, int nthr )
+   : QThread(), solvesim( solvesim ), thrx( thrx ), nthr( nthr )
+{
+   nhits        = 0;
+}
+
+// Run a simulation thread:  simulate its share of solutes
+void US_SolveSim::SimThread::run( void )
+{
+   nhits        = solvesim->simulate_solutes( thrx, nthr );
+}
+
 // Set a model component attribute value
 void US_SolveSim::set_comp_attr( US_Model::SimulationComponent& component,
       US_Solute& solute, int attr_type )
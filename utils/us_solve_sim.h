@@ -12,6 +12,7 @@
 #include "us_zsolute.h"
 #include "us_astfem_math.h"
 #include "us_astfem_rsa.h"
+#include "us_sim_cache.h"
 
 #define SIMPARAMS US_SimulationParameters
 
@@ -73,6 +74,18 @@ class US_UTIL_EXTERN US_SolveSim : public QObject
          QVector< US_ZSolute > zsolutes;   //!< Input/Output solutes
          long int              maxrss;     //!< Running max rss memory in KB
          int                   noisflag;   //!< Calculated-noise flag: 0-3
+         int                   nthreads;   //!< Threads for solute simulations
+         int                   nnls_mode;  //!< NNLS method: 0 Lawson-Hanson,
+                                           //!<  1 normal eqs., 2 compare both.
+                                           //!<  Only 1 warm starts from the
+                                           //!<  solutes' input concentrations,
+                                           //!<  reuses A'A (cache) for new
+                                           //!<  data of the same solutes, and
+                                           //!<  holds band-forming and ODlimit
+                                           //!<  A in sparse form
+         int                   sim_precision; //!< Simulation precision:
+                                           //!<  0 double, 1 float, 2 float
+                                           //!<  with RMSD check vs. double
          int                   dbg_level;  //!< Debug level
          bool                  dbg_timing; //!< Debug-timing-prints flag
          US_DataIO::RawData    sim_data;   //!< Simulation data
@@ -138,6 +151,44 @@ class US_UTIL_EXTERN US_SolveSim : public QObject
     bool               banddthr;      // Band-forming data threshold peak enhance
     QDateTime          startCalc;     // Start calc time for elapsed time prints
 
+    // Solute simulation state of the current calc_residuals(),
+    //  shared (read-only, except for own output slots) with SimThreads
+    Simulation*            sim_vals_p;  // Simulation values being computed
+    US_DataIO::EditedData* bf_data;     // Band-forming thresholded data
+    US_DataIO::RawData*    sim_out;     // Simulations (solute,dataset order)
+    int*                   sim_zero;    // All-zero simulation flags
+    double*                sim_fchk;    // Float-double RMSD,max-diff pairs
+    QByteArray*            sim_skey;    // Simulation cache keys
+    QVector< QByteArray >  dskeys;      // Simulation cache data set keys
+    QVector< QByteArray >  sgkeys;      // Basis store simulation grid keys
+    QList< US_AstfemGrid* > dsgrids;    // Data sets' shared grid contexts
+    US_Model::SimulationComponent zcomponent; // Zeroed component for models
+    int                sim_offs;      // Data set offset of simulations
+    int                sim_ndsets;    // Data sets count of simulations
+    int                sim_nsols;     // Solutes count of simulations
+    int                sim_increp;    // Progress report increment
+    int                sim_kdone;     // Progress steps reported so far
+    int                s_type;        // Solute type of data sets
+    int                s_mask;        // Solute attribute types mask
+    int                attr_x;        // Solute X attribute type
+    int                attr_y;        // Solute Y attribute type
+    int                attr_z;        // Solute Z attribute type
+    bool               use_zsols;     // Flag use of ZSolutes
+
+    // Thread to simulate a share of the solutes of calc_residuals()
+    class SimThread : public QThread
+    {
+      public:
+         SimThread( US_SolveSim*, int, int );
+
+         void run( void );
+
+         US_SolveSim*  solvesim;      // Parent solve-sim object
+         int           thrx;          // Thread index (1,...)
+         int           nthr;          // Number of simulating threads
+         int           nhits;         // Simulation cache hits of thread
+    };
+
   private slots:
     // Compute "a~", the average experiment signal at each time
     void compute_a_tilde   ( QVector< double >&, const QVector< double >& );
@@ -175,6 +226,16 @@ class US_UTIL_EXTERN US_SolveSim : public QObject
                                           const QVector< double >&,
                                           const QVector< double >& );
 
+    // Compute "small_a" and "small_b" of noise-centered A and b (blocked,
+    //  threaded):  per-radius and per-scan centers of A, then of b
+    void noise_small_a_and_b( int, int, const double*, int,
+                                          const double*, int,
+                                          const double*, const double*,
+                                          QVector< double >&,
+                                          QVector< double >&,
+                                          const QVector< double >&,
+                                          const QVector< double >& );
+
     // Compute "L_bar"
     void compute_L_bar     ( QVector< double >&,
                                           const QVector< double >&,
@@ -185,7 +246,7 @@ class US_UTIL_EXTERN US_SolveSim : public QObject
                                           const QVector< double >&,
                                           const QVector< double >& );
 
-    // Compute "L_bar-s"
+    // Compute "L_bar-s", the per-radius means of each column of A
     void compute_L_bars    ( int, int, int, int, 
                                          QVector< double >&,
                                           const QVector< double >&,
@@ -199,6 +260,25 @@ class US_UTIL_EXTERN US_SolveSim : public QObject
     bool data_threshold    ( US_DataIO::EditedData*,
                              double, double, double, double );
 
+    // Count the adaptive time steps of the largest solute of a data set
+    static long adaptive_steps( DataSet*, double );
+
+    // Simulate a share of the solutes of calc_residuals (thread x, count)
+    int  simulate_solutes  ( int, int );
+
+    // Set the experiment-space model component for a solute and data set
+    void solute_component  ( US_Model::SimulationComponent&, DataSet*,
+                             US_Solute&, US_ZSolute& );
+
+    // Simulate a single-component model for a data set (or fetch it cached)
+    bool model_simulation  ( US_Model&, DataSet*, US_DataIO::EditedData*,
+                             US_DataIO::RawData&, const QByteArray&,
+                             const QByteArray&, US_AstfemGrid*,
+                             double* = NULL );
+
+    // Compose the key of the A'A matrix for the current simulations
+    QByteArray gram_key    ( int, const QVector< double >&, int, double );
+
     // Set a model component attribute value
     void set_comp_attr     ( US_Model::SimulationComponent&,
                              US_Solute&, int );